@@ -1,191 +1,149 @@
-#include <asm/types.h>
+#include <arpa/inet.h>
 #include <errno.h>
-#include <linux/if.h>
+#include <linux/neighbour.h>
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
+#include <net/if.h>
 #include <stdio.h>
 #include <string.h>
-#include <strings.h>
-#define __USE_GNU
 #include <sys/socket.h>
-#include <sys/types.h>
-#include <fcntl.h>
-#include <sys/stat.h> /* fchmod */
-#include <sys/time.h> /* timeval_t struct */
-
-#define ENTRY(x)                                                               \
-  { x, #x }
-
-struct {
-  unsigned flag;
-  const char *name;
-} ifi_flag_map[] = {
-    ENTRY(IFF_UP),        ENTRY(IFF_BROADCAST),   ENTRY(IFF_DEBUG),
-    ENTRY(IFF_LOOPBACK),  ENTRY(IFF_POINTOPOINT), ENTRY(IFF_NOTRAILERS),
-    ENTRY(IFF_RUNNING),   ENTRY(IFF_NOARP),       ENTRY(IFF_PROMISC),
-    ENTRY(IFF_ALLMULTI),  ENTRY(IFF_MASTER),      ENTRY(IFF_SLAVE),
-    ENTRY(IFF_MULTICAST), ENTRY(IFF_PORTSEL),     ENTRY(IFF_AUTOMEDIA),
-    ENTRY(IFF_DYNAMIC),   ENTRY(IFF_LOWER_UP),    ENTRY(IFF_DORMANT),
-    ENTRY(IFF_ECHO),
-};
+#include <unistd.h>
 
-struct {
-  unsigned type;
-  const char *name;
-} nlmrt_type_map[] = {
-    ENTRY(RTM_NEWLINK),      ENTRY(RTM_DELLINK),      ENTRY(RTM_GETLINK),
-    ENTRY(RTM_SETLINK),      ENTRY(RTM_NEWADDR),      ENTRY(RTM_DELADDR),
-    ENTRY(RTM_GETADDR),      ENTRY(RTM_NEWROUTE),     ENTRY(RTM_DELROUTE),
-    ENTRY(RTM_GETROUTE),     ENTRY(RTM_NEWNEIGH),     ENTRY(RTM_DELNEIGH),
-    ENTRY(RTM_GETNEIGH),     ENTRY(RTM_NEWRULE),      ENTRY(RTM_DELRULE),
-    ENTRY(RTM_GETRULE),      ENTRY(RTM_NEWQDISC),     ENTRY(RTM_DELQDISC),
-    ENTRY(RTM_GETQDISC),     ENTRY(RTM_NEWTCLASS),    ENTRY(RTM_DELTCLASS),
-    ENTRY(RTM_GETTCLASS),    ENTRY(RTM_NEWTFILTER),   ENTRY(RTM_DELTFILTER),
-    ENTRY(RTM_NEWACTION),    ENTRY(RTM_DELACTION),    ENTRY(RTM_GETACTION),
-    ENTRY(RTM_NEWPREFIX),    ENTRY(RTM_GETMULTICAST), ENTRY(RTM_GETANYCAST),
-    ENTRY(RTM_NEWNEIGHTBL),  ENTRY(RTM_GETNEIGHTBL),  ENTRY(RTM_SETNEIGHTBL),
-    ENTRY(RTM_NEWNDUSEROPT), ENTRY(RTM_NEWADDRLABEL), ENTRY(RTM_DELADDRLABEL),
-    ENTRY(RTM_GETADDRLABEL), ENTRY(RTM_GETDCB),       ENTRY(RTM_SETDCB),
-    ENTRY(RTM_NEWNETCONF),   ENTRY(RTM_GETNETCONF),   ENTRY(RTM_NEWMDB),
-    ENTRY(RTM_DELMDB),       ENTRY(RTM_GETMDB),
-};
+#include "neigh.h"
+#include "station_table.h" /* station_table_mac() */
 
-static void print_type(unsigned type) {
-  size_t i;
+/* Print the neighbour (ARP/ND) table, then follow its changes and keep the
+ * MAC -> address cache the station tool enriches its samples with. */
 
-  for (i = 0; i < sizeof nlmrt_type_map / sizeof nlmrt_type_map[0]; i++) {
-    if (type == nlmrt_type_map[i].type) {
-      printf("\t\tMsg Type: %s\n", nlmrt_type_map[i].name);
-      return;
-    }
-  }
+#define ENTRY(x) [x] = #x
 
-  printf("\t\tMsg Type: unknown(%d)\n", type);
-}
+/* NUD state names indexed by bit number */
+static const char *const nud_names[] = {
+    "INCOMPLETE", "REACHABLE", "STALE", "DELAY", "PROBE", "FAILED", "NOARP", "PERMANENT",
+};
 
-static void print_flags(unsigned flags, unsigned change) {
-  size_t i;
+/* NTF flag names indexed by bit number */
+static const char *const ntf_names[] = {
+    "USE", "SELF", "MASTER", "PROXY", "EXT_LEARNED", "OFFLOADED", "STICKY", "ROUTER",
+};
 
-  printf("\t\tflags: ");
+static const char *const family_names[] = {
+    ENTRY(AF_UNSPEC), ENTRY(AF_INET), ENTRY(AF_INET6), ENTRY(AF_BRIDGE),
+};
 
-  for (i = 0; i < sizeof ifi_flag_map / sizeof ifi_flag_map[0]; i++) {
-    if (flags & ifi_flag_map[i].flag) {
-      if (change & ifi_flag_map[i].flag) {
-        printf("%s(C) ", ifi_flag_map[i].name);
-      } else {
-        printf("%s ", ifi_flag_map[i].name);
-      }
-    }
+static void print_bits(const char *label, unsigned bits, const char *const *names, unsigned n) {
+  unsigned rest, bit;
+
+  printf(" %s", label);
+  if (bits == 0) printf("NONE");
+  /* visit the set bits only */
+  for (rest = bits; rest; rest &= rest - 1) {
+    bit = __builtin_ctz(rest);
+    printf("%s", rest == bits ? "" : "|");
+    if (bit < n)
+      printf("%s", names[bit]);
+    else
+      printf("0x%x", 1U << bit);
   }
-  puts("");
 }
 
-static void print_link(struct nlmsghdr *nh) {
-  struct ifinfomsg *iface;
-  struct rtattr *attribute;
-  int len;
-
-  iface = (struct ifinfomsg *)NLMSG_DATA(nh);
-  len = nh->nlmsg_len - NLMSG_LENGTH(sizeof(*iface));
+static void print_neigh(const struct neigh_msg *m) {
+  char ifname[IF_NAMESIZE], addr[INET6_ADDRSTRLEN] = "-";
+
+  if (m->dst) inet_ntop(m->dst_len == 4 ? AF_INET : AF_INET6, m->dst, addr, sizeof(addr));
+  if (if_indextoname(m->ifindex, ifname) == NULL) snprintf(ifname, sizeof(ifname), "%u", m->ifindex);
+
+  printf("%s %s %s dev %s", m->type == RTM_DELNEIGH ? "del" : "new",
+         m->family < sizeof family_names / sizeof family_names[0] && family_names[m->family]
+             ? family_names[m->family]
+             : "AF_?",
+         addr, ifname);
+  if (m->lladdr)
+    printf(" lladdr %02x:%02x:%02x:%02x:%02x:%02x", m->lladdr[0], m->lladdr[1], m->lladdr[2],
+           m->lladdr[3], m->lladdr[4], m->lladdr[5]);
+  print_bits("state ", m->state, nud_names, sizeof nud_names / sizeof nud_names[0]);
+  print_bits("flags ", m->flags, ntf_names, sizeof ntf_names / sizeof ntf_names[0]);
+  putchar('\n');
+}
 
-  for (attribute = IFLA_RTA(iface); RTA_OK(attribute, len);
-       attribute = RTA_NEXT(attribute, len)) {
-    printf("\n iface->ifi_type %d\n", iface->ifi_type);
+/* what the cache holds for the MAC now */
+static void print_cached(const struct neigh_cache *c, const uint8_t *lladdr) {
+  char v4[INET_ADDRSTRLEN], v6[INET6_ADDRSTRLEN];
+  const struct in6_addr *a6;
+  int32_t slot = neigh_cache_find(c, station_table_mac(lladdr));
 
-    // get attributes
-    switch (attribute->rta_type) {
-    case IFLA_IFNAME:
-      printf("\n IFLA_IFNAME\n");
-      break;
-    case IFLA_ADDRESS:
-      printf("\nIFLA_ADDRESS\n");
-      break;
-    }
+  if (slot < 0) {
+    printf("\tcache: none\n");
+    return;
   }
+  a6 = neigh_cache_ipv6(c, slot);
+  printf("\tcache: ipv4 %s ipv6 %s\n",
+         c->ipv4[slot].s_addr ? inet_ntop(AF_INET, &c->ipv4[slot], v4, sizeof(v4)) : "-",
+         a6 ? inet_ntop(AF_INET6, a6, v6, sizeof(v6)) : "-");
 }
 
-int main(int argc, char *argv[]) {
-  int fd;
-  static struct sockaddr_nl g_addr;
-
-  /* Zeroing addr */
-  bzero(&g_addr, sizeof(g_addr));
-  g_addr.nl_family = AF_NETLINK;
-  // g_addr.nl_groups = RTNLGRP_NEIGH;
-  g_addr.nl_groups = RTM_NEWNEIGH;
+static int print_dump_cb(const struct nlmsghdr *nh, void *arg) {
+  struct neigh_msg m;
 
-  fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
-  if (fd < 0) {
-    perror("socket failed");
-    return -1;
-  }
+  (void)arg;
+  if (neigh_decode(nh, &m) == 0) print_neigh(&m);
+  return 0;
+}
 
-  fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
-  // set socket nonblocking flag
-  // int flags = fcntl(fd, F_GETFL, 0);
-  // fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+int main(void) {
+  struct sockaddr_nl local = {.nl_family = AF_NETLINK, .nl_groups = RTMGRP_NEIGH};
+  struct neigh_cache cache;
+  static char buf[32768];
+  int fd, dump_fd, ret;
 
-  // set socket timeout 100ms
-  struct timeval tv = {.tv_sec = 0, .tv_usec = 100000};
-  if (setsockopt(sk.s_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0) {
-      perror("setsockopt");
-      return -2;
+  fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (fd < 0 || bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0) {
+    perror("neighbour socket");
+    return 1;
   }
-
-  if (bind(fd, (struct sockaddr *)&g_addr, sizeof(g_addr)) < 0) {
-    printf("bind() error: %s", strerror(errno));
-
-    return -1;
+  if (neigh_cache_init(&cache, 256) < 0) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
   }
 
-  //     char    buffer[4096]  ;
-  //     int     received_bytes = 0  ;
-
-  while (1) {
-    int len;
-    char buf[4096];
-    struct iovec iov = {buf, sizeof(buf)};
-    struct sockaddr_nl sa;
-    struct msghdr msg = {(void *)&sa, sizeof(sa), &iov, 1, NULL, 0, 0};
-    struct nlmsghdr *nh;
+  /* subscribed first: changes during the dump wait on 'fd' */
+  dump_fd = nlraw_open(NETLINK_ROUTE);
+  ret = dump_fd < 0 ? dump_fd : neigh_cache_dump(&cache, dump_fd, print_dump_cb, NULL);
+  if (dump_fd >= 0) close(dump_fd);
+  if (ret < 0) {
+    fprintf(stderr, "neighbour dump: %s\n", strerror(-ret));
+    return 1;
+  }
+  printf("%d MACs cached, following changes\n", ret);
 
-    // received_bytes = recv (sock , buffer , sizeof(buffer) , 0 )  ;
-    len = recvmsg(fd, &msg, 0);
+  for (;;) {
+    const struct nlmsghdr *nh;
+    struct neigh_msg m;
+    int len = recv(fd, buf, sizeof(buf), 0);
 
     if (len < 0) {
-      perror("recvmsg");
-      return -1;
-    }
-
-    else {
-      for (nh = (struct nlmsghdr *)buf; NLMSG_OK(nh, len);
-           nh = NLMSG_NEXT(nh, len)) {
-        struct ifinfomsg *ifimsg;
-        /* The end of multipart message. */
-
-        printf("netlink message: len = %u, type = %u, flags = 0x%X, seq = %u, "
-               "pid = %u\n",
-               nh->nlmsg_len, nh->nlmsg_type, nh->nlmsg_flags, nh->nlmsg_seq,
-               nh->nlmsg_pid);
-
-        if (nh->nlmsg_type == NLMSG_DONE)
-          return 0;
-
-        if (nh->nlmsg_type == NLMSG_ERROR) {
-          continue;
+      if (errno == EINTR) continue;
+      if (errno == ENOBUFS) { /* changes were lost, start over */
+        fprintf(stderr, "recv: %s, reloading\n", strerror(errno));
+        neigh_cache_clear(&cache);
+        dump_fd = nlraw_open(NETLINK_ROUTE);
+        if (dump_fd >= 0) {
+          neigh_cache_dump(&cache, dump_fd, NULL, NULL);
+          close(dump_fd);
         }
-
-        ifimsg = NLMSG_DATA(nh);
-
-        printf("\tifi_family = %u, ifi_type = %u, ifi_index = %u, ifi_flags = "
-               "0x%X, ifi_change = 0x%X\n",
-               ifimsg->ifi_family, ifimsg->ifi_type, ifimsg->ifi_index,
-               ifimsg->ifi_flags, ifimsg->ifi_change);
-
-        print_type(nh->nlmsg_type);
-        print_flags(ifimsg->ifi_flags, ifimsg->ifi_change);
-        print_link(nh);
+        continue;
       }
+      perror("recv");
+      break;
+    }
+    for (nh = (const struct nlmsghdr *)buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+      if (neigh_decode(nh, &m) < 0) continue;
+      print_neigh(&m);
+      if (neigh_cache_update(&cache, &m) < 0) fprintf(stderr, "out of memory\n");
+      if (m.lladdr) print_cached(&cache, m.lladdr);
     }
   }
+  neigh_cache_free(&cache);
+  close(fd);
+  return 1;
 }
@@ -0,0 +1,481 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "output.h"
+#include "spsc.h"
+#include "station.h"
+#include "station_table.h"
+
+int bench_dump_append(struct bench_dump *d, const struct nlmsghdr *nlh) {
+  size_t len = NLMSG_ALIGN(nlh->nlmsg_len);
+
+  if (d->len + len > d->cap) {
+    size_t cap = d->cap ? d->cap : 65536;
+    unsigned char *data;
+
+    while (cap < d->len + len) cap *= 2;
+    data = realloc(d->data, cap);
+    if (data == NULL) return -ENOMEM;
+    d->data = data;
+    d->cap = cap;
+  }
+  memcpy(d->data + d->len, nlh, nlh->nlmsg_len);
+  d->len += len;
+  d->nmsgs++;
+  return 0;
+}
+
+void bench_dump_free(struct bench_dump *d) {
+  free(d->data);
+  memset(d, 0, sizeof(*d));
+}
+
+typedef int (*decode_fn)(const struct nlmsghdr *, struct station_sample *, unsigned, uint64_t);
+
+#ifndef STATION_NO_LIBNL
+/* the reference decoder has no projection */
+static int decode_nla(const struct nlmsghdr *nlh, struct station_sample *s, unsigned flags,
+                      uint64_t fields) {
+  (void)fields;
+  return station_decode_nla(nlh, s, flags);
+}
+#endif
+
+static double now_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* returns ns per decoded message */
+static double bench_run(const struct bench_dump *d, unsigned iterations, decode_fn decode,
+                        uint64_t fields, struct station_sample *s, unsigned long *errors) {
+  double start = now_ns();
+  unsigned i;
+
+  for (i = 0; i < iterations; i++) {
+    const struct nlmsghdr *nlh;
+    int len = (int)d->len;
+
+    for (nlh = (const struct nlmsghdr *)d->data; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+      if (decode(nlh, s, STATION_DECODE_TIDS, fields) < 0) (*errors)++;
+    }
+  }
+  return (now_ns() - start) / ((double)iterations * d->nmsgs);
+}
+
+int bench_decode(const struct bench_dump *d, unsigned iterations, uint64_t fields, FILE *f) {
+  struct station_sample walk;
+  unsigned long walk_err = 0;
+  double walk_ns, proj_ns = 0;
+#ifndef STATION_NO_LIBNL
+  struct station_sample ref;
+  unsigned long ref_err = 0;
+  const struct nlmsghdr *nlh;
+  int len = (int)d->len;
+  unsigned mismatch = 0;
+  double ref_ns;
+#endif
+
+  if (d->nmsgs == 0 || iterations == 0) return -ENODATA;
+
+#ifndef STATION_NO_LIBNL
+  /* both decoders must agree before their speed is worth comparing */
+  for (nlh = (const struct nlmsghdr *)d->data; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+    station_decode_nla(nlh, &ref, STATION_DECODE_TIDS);
+    station_decode(nlh, &walk, STATION_DECODE_TIDS, STATION_FIELDS_ALL);
+    if (ref.present != walk.present || memcmp(ref.mac, walk.mac, sizeof(ref.mac)) ||
+        ref.rx_bytes != walk.rx_bytes || ref.tx_bytes != walk.tx_bytes ||
+        (STA_HAS(&ref, TX_BITRATE) && ref.tx_rate.bitrate != walk.tx_rate.bitrate) ||
+        ref.ntids != walk.ntids)
+      mismatch++;
+  }
+
+  ref_ns = bench_run(d, iterations, decode_nla, STATION_FIELDS_ALL, &ref, &ref_err);
+#endif
+  walk_ns = bench_run(d, iterations, station_decode, STATION_FIELDS_ALL, &walk, &walk_err);
+  if (fields != STATION_FIELDS_ALL)
+    proj_ns = bench_run(d, iterations, station_decode, fields, &walk, &walk_err);
+
+  fprintf(f, "stations:\t%u (%zu bytes) x %u iterations\n", d->nmsgs, d->len, iterations);
+#ifndef STATION_NO_LIBNL
+  fprintf(f, "nla_parse:\t%.1f ns/station\n", ref_ns);
+  fprintf(f, "walker:\t\t%.1f ns/station (%.2fx)\n", walk_ns, ref_ns / walk_ns);
+  if (ref_err || walk_err || mismatch)
+    fprintf(f, "errors:\t\tnla_parse %lu walker %lu mismatch %u\n", ref_err, walk_err, mismatch);
+#else
+  fprintf(f, "walker:\t\t%.1f ns/station\n", walk_ns);
+  if (walk_err) fprintf(f, "errors:\t\twalker %lu\n", walk_err);
+#endif
+  if (proj_ns) fprintf(f, "walker -f:\t%.1f ns/station (%.2fx)\n", proj_ns, walk_ns / proj_ns);
+  return 0;
+}
+
+/* fixed stamps, the passes are compared byte for byte */
+#define BENCH_NOW_MS 1700000000000ULL
+#define BENCH_BOOT_NS 1000000000ULL
+
+struct bench_worker {
+  struct station_sample s;
+  struct station_out out; /* output goes nowhere, ob is sized for a whole pass */
+  const struct bench_dump *d;
+  const struct obuf *ref; /* output of the first pass */
+  unsigned iterations;
+  unsigned long errors, mismatch;
+  pthread_t tid;
+};
+
+/* one pass over the dump into out->ob, a fresh stream every time */
+static unsigned long bench_format(const struct bench_dump *d, struct station_out *out,
+                                  uint64_t fields, struct station_sample *s) {
+  const struct nlmsghdr *nlh;
+  int len = (int)d->len;
+  unsigned long errors = 0;
+
+  out->ob.len = 0;
+  out->started = 0;
+  for (nlh = (const struct nlmsghdr *)d->data; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+    if (station_decode(nlh, s, out->verbose ? STATION_DECODE_TIDS : 0, fields) < 0) {
+      errors++;
+      continue;
+    }
+    s->present &= fields;
+    s->event = 0;
+    s->now_ms = BENCH_NOW_MS;
+    s->boot_ns = BENCH_BOOT_NS;
+    out->fmt->sample(out, s);
+  }
+  if (out->fmt->flush) out->fmt->flush(out);
+  return errors;
+}
+
+static void *bench_worker_run(void *arg) {
+  struct bench_worker *wk = arg;
+  unsigned i;
+
+  for (i = 0; i < wk->iterations; i++) {
+    wk->errors += bench_format(wk->d, &wk->out, STATION_FIELDS_ALL, &wk->s);
+    if (wk->out.ob.err || wk->out.ob.len != wk->ref->len ||
+        memcmp(wk->out.ob.data, wk->ref->data, wk->ref->len))
+      wk->mismatch++;
+  }
+  return NULL;
+}
+
+int bench_threads(const struct bench_dump *d, unsigned threads, unsigned iterations,
+                  const struct station_formatter *fmt, int verbose, FILE *f) {
+  struct bench_worker *wk, *ref;
+  unsigned long errors = 0, mismatch = 0;
+  size_t cap = OBUF_SIZE;
+  double one_ns, all_ns;
+  unsigned i, started = 0;
+  int ret = 0;
+
+  if (d->nmsgs == 0 || iterations == 0 || threads == 0) return -ENODATA;
+  /* the last worker holds the reference pass */
+  wk = aligned_alloc(_Alignof(struct bench_worker), (threads + 1) * sizeof(*wk));
+  if (wk == NULL) return -ENOMEM;
+  memset(wk, 0, (threads + 1) * sizeof(*wk));
+  ref = &wk[threads];
+  ref->out.fmt = fmt;
+  ref->out.verbose = verbose;
+
+  /* no pass may be written out early: grow until the first one fits */
+  for (;;) {
+    ret = obuf_init(&ref->out.ob, -1, cap);
+    if (ret < 0) goto out;
+    bench_format(d, &ref->out, STATION_FIELDS_ALL, &ref->s);
+    if (ref->out.ob.err == 0) break;
+    obuf_free(&ref->out.ob);
+    cap *= 2;
+  }
+
+  for (i = 0; i < threads; i++) {
+    wk[i].out.fmt = fmt;
+    wk[i].out.verbose = verbose;
+    wk[i].d = d;
+    wk[i].ref = &ref->out.ob;
+    wk[i].iterations = iterations;
+    ret = obuf_init(&wk[i].out.ob, -1, cap);
+    if (ret < 0) goto out;
+  }
+
+  one_ns = now_ns();
+  bench_worker_run(&wk[0]);
+  one_ns = now_ns() - one_ns;
+  errors = wk[0].errors;
+  mismatch = wk[0].mismatch;
+  wk[0].errors = wk[0].mismatch = 0;
+
+  all_ns = now_ns();
+  for (; started < threads; started++) {
+    ret = -pthread_create(&wk[started].tid, NULL, bench_worker_run, &wk[started]);
+    if (ret < 0) break;
+  }
+  for (i = 0; i < started; i++) {
+    pthread_join(wk[i].tid, NULL);
+    errors += wk[i].errors;
+    mismatch += wk[i].mismatch;
+  }
+  all_ns = now_ns() - all_ns;
+  if (ret < 0) goto out;
+
+  fprintf(f, "stations:\t%u (%zu bytes of %s) x %u iterations\n", d->nmsgs, ref->out.ob.len,
+          fmt->name, iterations);
+  fprintf(f, "1 thread:\t%.0f stations/s\n", d->nmsgs * (double)iterations * 1e9 / one_ns);
+  fprintf(f, "%u threads:\t%.0f stations/s (%.2fx)\n", threads,
+          d->nmsgs * (double)iterations * threads * 1e9 / all_ns, one_ns * threads / all_ns);
+  fprintf(f, "output:\t\t%lu of %lu passes differ\n", mismatch, (threads + 1UL) * iterations);
+  if (errors) fprintf(f, "errors:\t\t%lu\n", errors);
+  if (mismatch) ret = -EBADMSG;
+
+out:
+  for (i = 0; i <= threads; i++) obuf_free(&wk[i].out.ob);
+  free(wk);
+  return ret;
+}
+
+#define BENCH_RING_SLOTS 2048
+
+struct bench_producer {
+  struct spsc ring;
+  const struct bench_dump *d;
+  unsigned iterations;
+  unsigned flags;
+  unsigned long errors;
+  atomic_int finished;
+  int drained;
+  pthread_t tid;
+};
+
+/* decode straight into the ring, waiting for the writer when it is full */
+static void *bench_producer_run(void *arg) {
+  struct bench_producer *p = arg;
+  unsigned i;
+
+  for (i = 0; i < p->iterations; i++) {
+    const struct nlmsghdr *nlh;
+    int len = (int)p->d->len;
+
+    for (nlh = (const struct nlmsghdr *)p->d->data; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+      struct station_sample *s;
+
+      while ((s = spsc_claim(&p->ring)) == NULL) sched_yield();
+      if (station_decode(nlh, s, p->flags, STATION_FIELDS_ALL) < 0) {
+        p->errors++;
+        continue; /* the slot is claimed again */
+      }
+      s->event = 0;
+      s->now_ms = BENCH_NOW_MS;
+      s->boot_ns = BENCH_BOOT_NS;
+      spsc_publish(&p->ring);
+    }
+  }
+  atomic_store_explicit(&p->finished, 1, memory_order_release);
+  return NULL;
+}
+
+/* one run with 'n' producers, returns stations/s or a negative errno */
+static double bench_pipeline_run(const struct bench_dump *d, unsigned n, unsigned iterations,
+                                 struct station_out *out, unsigned long *errors) {
+  struct bench_producer *p = calloc(n, sizeof(*p));
+  unsigned long count = 0;
+  unsigned i, started = 0, running;
+  double start, ret;
+
+  if (p == NULL) return -ENOMEM;
+  for (i = 0; i < n; i++) {
+    p[i].d = d;
+    p[i].iterations = iterations;
+    p[i].flags = out->verbose ? STATION_DECODE_TIDS : 0;
+    if (spsc_init(&p[i].ring, BENCH_RING_SLOTS, sizeof(struct station_sample)) < 0) {
+      ret = -ENOMEM;
+      goto out;
+    }
+  }
+
+  start = now_ns();
+  for (; started < n; started++)
+    if (pthread_create(&p[started].tid, NULL, bench_producer_run, &p[started])) break;
+  for (running = started; running > 0;) {
+    unsigned long batch = 0;
+
+    for (i = 0; i < started; i++) {
+      const struct station_sample *s;
+      int finished = atomic_load_explicit(&p[i].finished, memory_order_acquire);
+
+      while ((s = spsc_peek(&p[i].ring)) != NULL) {
+        out->fmt->sample(out, s);
+        spsc_release(&p[i].ring);
+        batch++;
+      }
+      if (finished && !p[i].drained) {
+        p[i].drained = 1;
+        running--;
+      }
+    }
+    if (batch == 0) sched_yield();
+    count += batch;
+  }
+  if (out->fmt->flush) out->fmt->flush(out);
+  obuf_flush(&out->ob);
+  ret = count * 1e9 / (now_ns() - start);
+
+  for (i = 0; i < started; i++) {
+    pthread_join(p[i].tid, NULL);
+    *errors += p[i].errors;
+  }
+  if (started < n) ret = -EAGAIN;
+out:
+  for (i = 0; i < n; i++) spsc_free(&p[i].ring);
+  free(p);
+  return ret;
+}
+
+int bench_pipeline(const struct bench_dump *d, unsigned threads, unsigned iterations,
+                   const struct station_formatter *fmt, int verbose, FILE *f) {
+  struct station_out out = {.fmt = fmt, .verbose = verbose};
+  unsigned long errors = 0;
+  double one = 0, rate;
+  unsigned n;
+  int fd, ret = 0;
+
+  if (d->nmsgs == 0 || iterations == 0 || threads == 0) return -ENODATA;
+  fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  if (fd < 0) return -errno;
+  ret = obuf_init(&out.ob, fd, OBUF_SIZE);
+  if (ret < 0) goto out;
+
+  fprintf(f, "stations:\t%u (%zu bytes) x %u iterations per worker, %s\n", d->nmsgs, d->len,
+          iterations, fmt->name);
+  for (n = 1; n <= threads; n++) {
+    rate = bench_pipeline_run(d, n, iterations, &out, &errors);
+    if (rate < 0) {
+      ret = (int)rate;
+      break;
+    }
+    if (n == 1) one = rate;
+    fprintf(f, "%u workers:\t%.0f stations/s (%.2fx)\n", n, rate, rate / one);
+  }
+  if (errors) fprintf(f, "errors:\t\t%lu\n", errors);
+  obuf_free(&out.ob);
+out:
+  close(fd);
+  return ret;
+}
+
+int bench_scale(const struct bench_dump *d, unsigned iterations, uint64_t fields,
+                const struct station_formatter *fmt, int verbose, FILE *f) {
+  struct station_out out = {.fmt = fmt, .verbose = verbose, .fields = fields};
+  struct station_sample s;
+  unsigned long errors = 0;
+  double decode_ns, format_ns, stations, in_bytes;
+  unsigned i;
+  int fd, ret;
+
+  if (d->nmsgs == 0 || iterations == 0) return -ENODATA;
+  fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  if (fd < 0) return -errno;
+  ret = obuf_init(&out.ob, fd, OBUF_SIZE);
+  if (ret < 0) goto out;
+
+  decode_ns = bench_run(d, iterations, station_decode, fields, &s, &errors) * d->nmsgs * iterations;
+
+  format_ns = now_ns();
+  for (i = 0; i < iterations; i++) {
+    errors += bench_format(d, &out, fields, &s);
+    obuf_flush(&out.ob); /* one write per dump, like watch mode */
+  }
+  format_ns = now_ns() - format_ns;
+
+  stations = (double)d->nmsgs * iterations;
+  in_bytes = (double)d->len * iterations;
+  fprintf(f, "stations:\t%u (%zu bytes, %zu per station) x %u iterations\n", d->nmsgs, d->len,
+          d->len / d->nmsgs, iterations);
+  fprintf(f, "decode:\t\t%.0f stations/s, %.1f MB/s in\n", stations * 1e9 / decode_ns,
+          in_bytes * 1e3 / decode_ns);
+  fprintf(f, "+ %s:\t%.0f stations/s, %.1f MB/s in, %.1f MB/s out\n", fmt->name,
+          stations * 1e9 / format_ns, in_bytes * 1e3 / format_ns, out.ob.written * 1e3 / format_ns);
+  if (errors) fprintf(f, "errors:\t\t%lu\n", errors);
+  obuf_free(&out.ob);
+out:
+  close(fd);
+  return ret;
+}
+
+/* xorshift64, keys must not follow the hash order */
+static uint64_t bench_rand(uint64_t *state) {
+  uint64_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+int bench_table(uint32_t entries, FILE *f) {
+  struct station_table t;
+  uint64_t *macs, state = 0x2545f4914f6cdd1dULL;
+  uint32_t i, hits = 0, removed;
+  double start, insert_ns, hit_ns, miss_ns, expire_ns;
+  int created;
+
+  if (entries == 0) return -EINVAL;
+  macs = malloc(entries * sizeof(*macs));
+  if (macs == NULL) return -ENOMEM;
+  for (i = 0; i < entries; i++)
+    macs[i] = bench_rand(&state) & 0xffffffffffffULL;
+
+  /* start small so growing is part of the insert cost */
+  if (station_table_init(&t, 0) < 0) {
+    free(macs);
+    return -ENOMEM;
+  }
+
+  start = now_ns();
+  for (i = 0; i < entries; i++) {
+    int32_t slot = station_table_insert(&t, 1 + (i & 3), macs[i], &created);
+
+    if (slot < 0) break;
+    t.seen[slot] = i & 1; /* every other station expires below */
+  }
+  insert_ns = (now_ns() - start) / entries;
+
+  start = now_ns();
+  for (i = 0; i < entries; i++)
+    hits += station_table_find(&t, 1 + (i & 3), macs[i]) >= 0;
+  hit_ns = (now_ns() - start) / entries;
+
+  start = now_ns();
+  for (i = 0; i < entries; i++)
+    hits += station_table_find(&t, 5, macs[i]) >= 0; /* no station on ifindex 5 */
+  miss_ns = (now_ns() - start) / entries;
+
+  start = now_ns();
+  removed = station_table_expire(&t, 1);
+  expire_ns = (now_ns() - start) / (removed ? removed : 1);
+
+  /* the survivors must still be found after the backward shifts */
+  for (i = 1; i < entries; i += 2)
+    if (station_table_find(&t, 1 + (i & 3), macs[i]) < 0) hits = 0;
+
+  fprintf(f, "stations:\t%u (capacity %u)\n", entries, t.cap);
+  fprintf(f, "insert:\t\t%.1f ns/station\n", insert_ns);
+  fprintf(f, "lookup hit:\t%.1f ns/station\n", hit_ns);
+  fprintf(f, "lookup miss:\t%.1f ns/station\n", miss_ns);
+  fprintf(f, "expire:\t\t%.1f ns/station (%u removed, %u left)\n", expire_ns, removed, t.count);
+  if (hits != entries) fprintf(f, "errors:\t\t%u of %u stations not found\n", entries - hits, entries);
+
+  station_table_free(&t);
+  free(macs);
+  return hits == entries ? 0 : -EINVAL;
+}
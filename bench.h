@@ -0,0 +1,56 @@
+//
+// decode micro benchmark over recorded station dump messages
+//
+
+#ifndef NETLINK_DEMO_BENCH_H
+#define NETLINK_DEMO_BENCH_H
+
+#include <linux/netlink.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* station messages copied back to back, each NLMSG_ALIGN()ed */
+struct bench_dump {
+  unsigned char *data;
+  size_t len, cap;
+  unsigned nmsgs;
+};
+
+int bench_dump_append(struct bench_dump *d, const struct nlmsghdr *nlh);
+void bench_dump_free(struct bench_dump *d);
+
+/* decode every message 'iterations' times with the nla_parse() reference
+ * decoder and the single pass walker and report ns per station; with a
+ * projection ('fields' not STATION_FIELDS_ALL) the walker runs once more
+ * decoding only those */
+int bench_decode(const struct bench_dump *d, unsigned iterations, uint64_t fields, FILE *f);
+
+struct station_formatter;
+
+/* Decode and format every message 'iterations' times in one thread, then in
+ * 'threads' threads at once, each with its own decode buffer and output
+ * context. Every pass has to produce the bytes of the first one. Returns 0,
+ * -EBADMSG if any pass differed, or a negative errno. */
+int bench_threads(const struct bench_dump *d, unsigned threads, unsigned iterations,
+                  const struct station_formatter *fmt, int verbose, FILE *f);
+
+/* Worker mode pipeline without sockets: 1 to 'threads' producer threads
+ * decode the dump 'iterations' times each into their own SPSC ring, the
+ * calling thread formats everything to /dev/null. Reports stations/s for
+ * every producer count. */
+int bench_pipeline(const struct bench_dump *d, unsigned threads, unsigned iterations,
+                   const struct station_formatter *fmt, int verbose, FILE *f);
+
+/* Decode every message 'iterations' times, then decode and format it to
+ * /dev/null as many times, and report stations/s and bytes/s of netlink
+ * input (and of output) for each. Only 'fields' are decoded and printed.
+ * Meant for synthetic dumps of any size. */
+int bench_scale(const struct bench_dump *d, unsigned iterations, uint64_t fields,
+                const struct station_formatter *fmt, int verbose, FILE *f);
+
+/* insert, lookup and expire 'entries' random stations in a station table
+ * and report ns per operation, no netlink involved */
+int bench_table(uint32_t entries, FILE *f);
+
+#endif // NETLINK_DEMO_BENCH_H
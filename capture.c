@@ -0,0 +1,87 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "capture.h"
+
+#define CAPTURE_ALIGN(len) (((len) + 7) & ~(size_t)7)
+
+int capture_open(struct capture *c, const char *path, uint32_t family_id) {
+  struct capture_hdr h = {.version = CAPTURE_VERSION, .family_id = family_id};
+
+  memcpy(h.magic, CAPTURE_MAGIC, sizeof(h.magic));
+  c->err = 0;
+  c->f = fopen(path, "we");
+  if (c->f == NULL) return -errno;
+  if (fwrite(&h, sizeof(h), 1, c->f) != 1) c->err = -EIO;
+  return c->err;
+}
+
+void capture_put(struct capture *c, uint16_t kind, uint32_t ifindex, uint64_t now_ms,
+                 uint64_t boot_ns, const void *data, uint32_t len) {
+  static const unsigned char pad[8];
+  struct capture_rec r = {
+      .len = len, .kind = kind, .ifindex = ifindex, .now_ms = now_ms, .boot_ns = boot_ns};
+  size_t npad = CAPTURE_ALIGN(len) - len;
+
+  if (fwrite(&r, sizeof(r), 1, c->f) != 1 || (len && fwrite(data, len, 1, c->f) != 1) ||
+      (npad && fwrite(pad, npad, 1, c->f) != 1))
+    c->err = -EIO;
+}
+
+int capture_close(struct capture *c) {
+  if (c->f == NULL) return c->err;
+  if (fclose(c->f) != 0 && c->err == 0) c->err = -errno;
+  c->f = NULL;
+  return c->err;
+}
+
+int capture_load(struct capture_file *cf, const char *path) {
+  const struct capture_hdr *h;
+  FILE *f = fopen(path, "re");
+  long size;
+  int ret = 0;
+
+  memset(cf, 0, sizeof(*cf));
+  if (f == NULL) return -errno;
+  if (fseek(f, 0, SEEK_END) < 0 || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) < 0) {
+    ret = -errno;
+    goto out;
+  }
+  /* records are read in place, netlink messages need 4 byte alignment */
+  cf->data = aligned_alloc(8, CAPTURE_ALIGN(size ? size : 1));
+  if (cf->data == NULL) {
+    ret = -ENOMEM;
+    goto out;
+  }
+  if (fread(cf->data, 1, size, f) != (size_t)size) {
+    ret = -EIO;
+    goto out;
+  }
+  h = (const struct capture_hdr *)cf->data;
+  if ((size_t)size < sizeof(*h) || memcmp(h->magic, CAPTURE_MAGIC, sizeof(h->magic)) ||
+      h->version != CAPTURE_VERSION) {
+    ret = -EINVAL;
+    goto out;
+  }
+  cf->len = size;
+  cf->off = sizeof(*h);
+  cf->family_id = h->family_id;
+out:
+  fclose(f);
+  if (ret < 0) capture_free(cf);
+  return ret;
+}
+
+void capture_free(struct capture_file *cf) {
+  free(cf->data);
+  memset(cf, 0, sizeof(*cf));
+}
+
+const struct capture_rec *capture_next(struct capture_file *cf) {
+  const struct capture_rec *r = (const struct capture_rec *)(cf->data + cf->off);
+
+  if (cf->off + sizeof(*r) > cf->len || r->len > cf->len - cf->off - sizeof(*r)) return NULL;
+  cf->off += CAPTURE_ALIGN(sizeof(*r) + r->len);
+  return r;
+}
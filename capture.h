@@ -0,0 +1,87 @@
+//
+// raw netlink reply capture file, for offline replay
+//
+
+#ifndef NETLINK_DEMO_CAPTURE_H
+#define NETLINK_DEMO_CAPTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define CAPTURE_MAGIC "NLCAP\0\0\0"
+#define CAPTURE_VERSION 1
+
+/* File header, then records back to back, each padded to 8 bytes. Host byte
+ * order like the netlink messages inside. */
+struct capture_hdr {
+  char magic[8];
+  uint32_t version;
+  uint32_t family_id; /* nl80211 family id of the recording */
+};
+
+enum capture_kind {
+  CAPTURE_DEV = 1, /* a polled interface, struct capture_dev */
+  CAPTURE_ROUND,   /* requests of a dump round were sent, struct capture_req[] */
+  CAPTURE_DUMP,    /* datagram read from the dump socket of 'ifindex' */
+  CAPTURE_MLME,    /* datagram read from the nl80211 "mlme" group socket */
+  CAPTURE_NEIGH,   /* datagram read from the rtnetlink neighbour socket */
+  CAPTURE_NEIGH_DUMP, /* message of the dump loading the neighbour cache, an
+                       * empty record starts the dump */
+};
+
+struct capture_rec {
+  uint32_t len;     /* payload bytes after the header */
+  uint16_t kind;
+  uint16_t flags;   /* unused, 0 */
+  uint32_t ifindex; /* DEV, DUMP */
+  uint32_t pad;
+  uint64_t now_ms;  /* stamp the samples got, CLOCK_REALTIME */
+  uint64_t boot_ns; /* CLOCK_BOOTTIME */
+};
+
+struct capture_dev {
+  int32_t wiphy;
+  char name[16];
+};
+
+/* one request of a round, its replies carry 'seq' */
+struct capture_req {
+  uint32_t ifindex;
+  uint32_t seq;
+};
+
+/* writer, stdio buffered: a record costs no syscall of its own */
+struct capture {
+  FILE *f;
+  int err; /* first write error, negative errno */
+};
+
+int capture_open(struct capture *c, const char *path, uint32_t family_id);
+/* append a record with the stamps the live samples got, replay uses them */
+void capture_put(struct capture *c, uint16_t kind, uint32_t ifindex, uint64_t now_ms,
+                 uint64_t boot_ns, const void *data, uint32_t len);
+/* returns 0 or the first write error */
+int capture_close(struct capture *c);
+
+/* reader over the whole file in memory */
+struct capture_file {
+  unsigned char *data;
+  size_t len, off;
+  uint32_t family_id;
+};
+
+/* Returns 0, -EINVAL if it is no capture file of this version, or a negative
+ * errno. */
+int capture_load(struct capture_file *cf, const char *path);
+void capture_free(struct capture_file *cf);
+
+/* next record, its payload follows it; NULL at the end or on a truncated
+ * record */
+const struct capture_rec *capture_next(struct capture_file *cf);
+
+static inline const void *capture_data(const struct capture_rec *r) {
+  return r + 1;
+}
+
+#endif // NETLINK_DEMO_CAPTURE_H
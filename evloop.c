@@ -0,0 +1,68 @@
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "evloop.h"
+
+#define EVLOOP_BATCH 16 /* more ready sources wait for the next call */
+
+int evloop_init(struct evloop *l) {
+  l->epfd = epoll_create1(EPOLL_CLOEXEC);
+  l->wait_mask = NULL;
+  return l->epfd < 0 ? -errno : 0;
+}
+
+void evloop_free(struct evloop *l) {
+  if (l->epfd >= 0) close(l->epfd);
+  l->epfd = -1;
+}
+
+int evloop_add(struct evloop *l, struct evloop_source *src) {
+  struct epoll_event e = {.events = EPOLLIN, .data.ptr = src};
+
+  return epoll_ctl(l->epfd, EPOLL_CTL_ADD, src->fd, &e) < 0 ? -errno : 0;
+}
+
+void evloop_del(struct evloop *l, struct evloop_source *src) {
+  epoll_ctl(l->epfd, EPOLL_CTL_DEL, src->fd, NULL);
+}
+
+int evloop_run_once(struct evloop *l, int timeout_ms) {
+  struct epoll_event e[EVLOOP_BATCH];
+  int i, n;
+
+  n = epoll_pwait(l->epfd, e, EVLOOP_BATCH, timeout_ms, l->wait_mask);
+  if (n < 0) return errno == EINTR ? 0 : -errno;
+  for (i = 0; i < n; i++) {
+    struct evloop_source *src = e[i].data.ptr;
+
+    src->ready(src->arg);
+  }
+  return n;
+}
+
+int evloop_timer_open(unsigned interval_ms) {
+  struct itimerspec its = {
+      .it_interval = {.tv_sec = interval_ms / 1000, .tv_nsec = (interval_ms % 1000) * 1000000L},
+  };
+  int fd;
+
+  its.it_value = its.it_interval;
+  fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (fd < 0) return -errno;
+  if (timerfd_settime(fd, 0, &its, NULL) < 0) {
+    int ret = -errno;
+
+    close(fd);
+    return ret;
+  }
+  return fd;
+}
+
+uint64_t evloop_timer_read(int fd) {
+  uint64_t expirations;
+
+  if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) return 0;
+  return expirations;
+}
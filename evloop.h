@@ -0,0 +1,47 @@
+//
+// epoll event loop over the netlink sockets and the watch timer
+//
+
+#ifndef NETLINK_DEMO_EVLOOP_H
+#define NETLINK_DEMO_EVLOOP_H
+
+#include <signal.h>
+#include <stdint.h>
+
+/* A readable descriptor and what to do with it. The loop is level triggered,
+ * a handler may read as much or as little as it likes. */
+struct evloop_source {
+  int fd;
+  void (*ready)(void *arg);
+  void *arg;
+};
+
+/* 'wait_mask' is the signal mask for the wait only (NULL keeps the thread's
+ * mask): a caller that blocks its stop signals, checks its flag and sets the
+ * old mask here cannot miss a signal between the check and the wait. */
+struct evloop {
+  int epfd;
+  const sigset_t *wait_mask;
+};
+
+int evloop_init(struct evloop *l);
+void evloop_free(struct evloop *l);
+
+/* the source must stay in place while it is registered */
+int evloop_add(struct evloop *l, struct evloop_source *src);
+void evloop_del(struct evloop *l, struct evloop_source *src);
+
+/* wait up to timeout_ms (-1 forever) and run the handlers of every ready
+ * source. Returns the number of handlers run, 0 on timeout or a signal, or a
+ * negative errno. */
+int evloop_run_once(struct evloop *l, int timeout_ms);
+
+/* Periodic CLOCK_MONOTONIC timerfd, first expiry after one interval. It keeps
+ * its own schedule: an overrun shows up as several expirations in one read,
+ * not as a burst of wakeups. Returns the fd or a negative errno. */
+int evloop_timer_open(unsigned interval_ms);
+
+/* expirations since the last read, 0 if none */
+uint64_t evloop_timer_read(int fd);
+
+#endif // NETLINK_DEMO_EVLOOP_H
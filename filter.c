@@ -0,0 +1,285 @@
+#define _GNU_SOURCE 1 /* strchrnul() */
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "filter.h"
+
+enum key_type { KEY_U8, KEY_U16, KEY_U32, KEY_U64, KEY_S8, KEY_F64, KEY_RATE };
+#define KEY_DELTA 0x80 /* in station_delta, valid with its source counter */
+
+static const struct {
+  const char *name;
+  struct station_key key;
+} keys[] = {
+#define KEY(n, f, t) {#n, {offsetof(struct station_sample, n), STA_F_##f, KEY_##t}}
+#define RATE_KEY(n, m, f) {#n, {offsetof(struct station_sample, m.bitrate), STA_F_##f, KEY_RATE}}
+#define DELTA_KEY(n, f, t)                                                                 \
+  {"delta." #n,                                                                            \
+   {offsetof(struct station_sample, delta) + offsetof(struct station_delta, n), STA_F_##f, \
+    KEY_##t | KEY_DELTA}}
+    KEY(generation, GENERATION, U32),
+    KEY(inactive_time, INACTIVE_TIME, U32),
+    KEY(rx_bytes, RX_BYTES, U64),
+    KEY(rx_packets, RX_PACKETS, U32),
+    KEY(tx_bytes, TX_BYTES, U64),
+    KEY(tx_packets, TX_PACKETS, U32),
+    KEY(tx_retries, TX_RETRIES, U32),
+    KEY(tx_failed, TX_FAILED, U32),
+    KEY(beacon_loss, BEACON_LOSS, U32),
+    KEY(beacon_rx, BEACON_RX, U64),
+    KEY(rx_drop_misc, RX_DROP_MISC, U64),
+    KEY(signal, SIGNAL, S8),
+    KEY(signal_avg, SIGNAL_AVG, S8),
+    KEY(beacon_signal_avg, BEACON_SIGNAL_AVG, S8),
+    KEY(tx_duration, TX_DURATION, U64),
+    KEY(rx_duration, RX_DURATION, U64),
+    KEY(ack_signal, ACK_SIGNAL, S8),
+    KEY(ack_signal_avg, ACK_SIGNAL_AVG, S8),
+    KEY(airtime_weight, AIRTIME_WEIGHT, U16),
+    KEY(expected_throughput, EXPECTED_THROUGHPUT, U32),
+    KEY(airtime_link_metric, AIRTIME_LINK_METRIC, U32),
+    KEY(connected_time, CONNECTED_TIME, U32),
+    RATE_KEY(tx_bitrate, tx_rate, TX_BITRATE),
+    RATE_KEY(rx_bitrate, rx_rate, RX_BITRATE),
+    DELTA_KEY(rx_bytes, RX_BYTES, U64),
+    DELTA_KEY(rx_bytes_rate, RX_BYTES, F64),
+    DELTA_KEY(rx_packets, RX_PACKETS, U32),
+    DELTA_KEY(rx_packets_rate, RX_PACKETS, F64),
+    DELTA_KEY(tx_bytes, TX_BYTES, U64),
+    DELTA_KEY(tx_bytes_rate, TX_BYTES, F64),
+    DELTA_KEY(tx_packets, TX_PACKETS, U32),
+    DELTA_KEY(tx_packets_rate, TX_PACKETS, F64),
+    DELTA_KEY(tx_retries, TX_RETRIES, U32),
+    DELTA_KEY(retry_ratio, TX_RETRIES, F64),
+    DELTA_KEY(tx_failed, TX_FAILED, U32),
+    DELTA_KEY(fail_ratio, TX_FAILED, F64),
+    DELTA_KEY(beacon_loss, BEACON_LOSS, U32),
+    DELTA_KEY(rx_drop_misc, RX_DROP_MISC, U64),
+#undef DELTA_KEY
+#undef RATE_KEY
+#undef KEY
+};
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+int station_key_parse(struct station_key *k, const char *name, size_t len) {
+  int match = -1;
+  size_t i;
+
+  for (i = 0; i < ARRAY_SIZE(keys); i++) {
+    if (strncmp(keys[i].name, name, len)) continue;
+    if (keys[i].name[len] == '\0') { /* exact, even if it prefixes others */
+      match = i;
+      break;
+    }
+    if (match >= 0) return -EINVAL; /* ambiguous prefix */
+    match = i;
+  }
+  if (match < 0 || len == 0) return -EINVAL;
+  *k = keys[match].key;
+  return 0;
+}
+
+uint64_t station_key_fields(const struct station_key *k) {
+  uint64_t bits = 1ULL << k->field;
+
+  if (k->type & KEY_DELTA) bits |= STA_BIT(DELTA);
+  return bits;
+}
+
+int station_key_value(const struct station_key *k, const struct station_sample *s, double *v) {
+  const void *p = (const char *)s + k->offset;
+
+  if (k->type & KEY_DELTA) {
+    if (!STA_HAS(s, DELTA) || !(s->delta.present & (1ULL << k->field))) return 0;
+  } else if (!(s->present & (1ULL << k->field))) {
+    return 0;
+  }
+  switch (k->type & ~KEY_DELTA) {
+  case KEY_U8:
+    *v = *(const uint8_t *)p;
+    break;
+  case KEY_U16:
+    *v = *(const uint16_t *)p;
+    break;
+  case KEY_U32:
+    *v = *(const uint32_t *)p;
+    break;
+  case KEY_U64:
+    *v = *(const uint64_t *)p;
+    break;
+  case KEY_S8:
+    *v = *(const int8_t *)p;
+    break;
+  case KEY_F64:
+    *v = *(const double *)p;
+    break;
+  case KEY_RATE: /* 100 kbit/s units, 0 if the driver did not know */
+    if (*(const uint32_t *)p == 0) return 0;
+    *v = *(const uint32_t *)p / 10.0;
+    break;
+  }
+  return 1;
+}
+
+/* the longer operators first */
+static const struct {
+  const char *s;
+  uint8_t op;
+} ops[] = {
+    {"<=", FILTER_LE}, {">=", FILTER_GE}, {"==", FILTER_EQ}, {"!=", FILTER_NE},
+    {"<", FILTER_LT},  {">", FILTER_GT},  {"=", FILTER_EQ},
+};
+
+int station_filter_parse(struct station_filter *f, const char *expr, const char **bad) {
+  const char *p, *end;
+
+  f->n = 0;
+  for (p = expr; *p; p = *end ? end + 1 : end) {
+    struct station_filter_term *t;
+    size_t name_len, i;
+    char *num_end;
+
+    end = strchrnul(p, ',');
+    if (end == p) continue;
+    *bad = p;
+    if (f->n == STATION_FILTER_TERMS) return -EINVAL;
+    t = &f->term[f->n];
+
+    name_len = strcspn(p, "<>=!");
+    if (p + name_len >= end || station_key_parse(&t->key, p, name_len) < 0) return -EINVAL;
+    for (i = 0; i < ARRAY_SIZE(ops); i++)
+      if (!strncmp(p + name_len, ops[i].s, strlen(ops[i].s))) break;
+    if (i == ARRAY_SIZE(ops)) return -EINVAL;
+    t->op = ops[i].op;
+    t->value = strtod(p + name_len + strlen(ops[i].s), &num_end);
+    if (num_end != end || num_end == p + name_len + strlen(ops[i].s)) return -EINVAL;
+    f->n++;
+  }
+  return 0;
+}
+
+uint64_t station_filter_fields(const struct station_filter *f) {
+  uint64_t bits = 0;
+  unsigned i;
+
+  for (i = 0; i < f->n; i++) bits |= station_key_fields(&f->term[i].key);
+  return bits;
+}
+
+int station_filter_match(const struct station_filter *f, const struct station_sample *s) {
+  unsigned i;
+  double v;
+
+  for (i = 0; i < f->n; i++) {
+    const struct station_filter_term *t = &f->term[i];
+    int ok = 0;
+
+    if (!station_key_value(&t->key, s, &v)) return 0;
+    switch (t->op) {
+    case FILTER_LT:
+      ok = v < t->value;
+      break;
+    case FILTER_LE:
+      ok = v <= t->value;
+      break;
+    case FILTER_GT:
+      ok = v > t->value;
+      break;
+    case FILTER_GE:
+      ok = v >= t->value;
+      break;
+    case FILTER_EQ:
+      ok = v == t->value;
+      break;
+    case FILTER_NE:
+      ok = v != t->value;
+      break;
+    }
+    if (!ok) return 0;
+  }
+  return 1;
+}
+
+int station_top_init(struct station_top *t, uint32_t cap, const struct station_key *key,
+                     int smallest) {
+  memset(t, 0, sizeof(*t));
+  t->heap = calloc(cap, sizeof(*t->heap));
+  t->value = calloc(cap, sizeof(*t->value));
+  t->slot = aligned_alloc(_Alignof(struct station_sample), cap * sizeof(*t->slot));
+  if (t->heap == NULL || t->value == NULL || t->slot == NULL) {
+    station_top_free(t);
+    return -ENOMEM;
+  }
+  t->key = *key;
+  t->smallest = smallest;
+  t->cap = cap;
+  return 0;
+}
+
+void station_top_free(struct station_top *t) {
+  free(t->heap);
+  free(t->value);
+  free(t->slot);
+  memset(t, 0, sizeof(*t));
+}
+
+/* 'a' is given up before 'b' */
+static int top_worse(const struct station_top *t, double a, double b) {
+  return t->smallest ? a > b : a < b;
+}
+
+static void top_sift_down(struct station_top *t, uint32_t i, uint32_t n) {
+  uint32_t x = t->heap[i];
+
+  for (;;) {
+    uint32_t c = 2 * i + 1;
+
+    if (c >= n) break;
+    if (c + 1 < n && top_worse(t, t->value[t->heap[c + 1]], t->value[t->heap[c]])) c++;
+    if (!top_worse(t, t->value[t->heap[c]], t->value[x])) break;
+    t->heap[i] = t->heap[c];
+    i = c;
+  }
+  t->heap[i] = x;
+}
+
+int station_top_add(struct station_top *t, const struct station_sample *s) {
+  uint32_t i, x;
+  double v;
+
+  if (!station_key_value(&t->key, s, &v)) return 0;
+  t->offered++;
+  if (t->n == t->cap) {
+    if (!top_worse(t, t->value[t->heap[0]], v)) return 0;
+    x = t->heap[0]; /* evict the root, sift the newcomer down from there */
+    memcpy(&t->slot[x], s, sizeof(*s));
+    t->value[x] = v;
+    top_sift_down(t, 0, t->n);
+    return 1;
+  }
+
+  x = t->n++;
+  memcpy(&t->slot[x], s, sizeof(*s));
+  t->value[x] = v;
+  for (i = x; i > 0 && top_worse(t, v, t->value[t->heap[(i - 1) / 2]]); i = (i - 1) / 2)
+    t->heap[i] = t->heap[(i - 1) / 2];
+  t->heap[i] = x;
+  return 1;
+}
+
+uint32_t station_top_sort(struct station_top *t) {
+  uint32_t n = t->n, i;
+
+  /* heapsort: the worst goes to the end, the best stays in front */
+  for (i = n; i > 1; i--) {
+    uint32_t root = t->heap[0];
+
+    t->heap[0] = t->heap[i - 1];
+    t->heap[i - 1] = root;
+    top_sift_down(t, 0, i - 1);
+  }
+  t->n = t->offered = 0;
+  return n;
+}
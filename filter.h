@@ -0,0 +1,77 @@
+//
+// filter expressions and top-N selection over decoded station samples
+//
+
+#ifndef NETLINK_DEMO_FILTER_H
+#define NETLINK_DEMO_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "station.h"
+
+/* A numeric field of a sample: the JSON key of a counter or signal,
+ * tx_bitrate/rx_bitrate in MBit/s, or delta.<key> for the watch mode
+ * deltas and rates. */
+struct station_key {
+  uint16_t offset; /* into the sample */
+  uint8_t field;   /* enum station_field that has to be present */
+  uint8_t type;    /* how to read it, private to filter.c */
+};
+
+/* Resolve the key 'name' ('len' bytes): the full name or a prefix of only
+ * one, "inactive" for inactive_time. Returns 0 or -EINVAL. */
+int station_key_parse(struct station_key *k, const char *name, size_t len);
+
+/* STA_BIT()s the key is read from, to decode even when not printed */
+uint64_t station_key_fields(const struct station_key *k);
+
+/* Returns 1 and the value in 'v', or 0 if the sample does not have it. */
+int station_key_value(const struct station_key *k, const struct station_sample *s, double *v);
+
+#define STATION_FILTER_TERMS 8
+
+enum station_filter_op { FILTER_LT, FILTER_LE, FILTER_GT, FILTER_GE, FILTER_EQ, FILTER_NE };
+
+/* Comma separated terms that all have to hold, compiled once:
+ * signal<-75,inactive>10000. A sample without a term's field fails it. */
+struct station_filter {
+  unsigned n; /* 0 passes everything */
+  struct station_filter_term {
+    struct station_key key;
+    uint8_t op; /* enum station_filter_op */
+    double value;
+  } term[STATION_FILTER_TERMS];
+};
+
+/* Returns 0, or -EINVAL with '*bad' at the term that could not be read. */
+int station_filter_parse(struct station_filter *f, const char *expr, const char **bad);
+uint64_t station_filter_fields(const struct station_filter *f);
+int station_filter_match(const struct station_filter *f, const struct station_sample *s);
+
+/* The 'cap' samples with the largest (or smallest) key of a dump round, in
+ * a bounded heap: the root is the one to give up next, a sample that does
+ * not beat it costs one comparison. Samples are copied in, the heap holds
+ * slot indexes so sifting moves no samples. */
+struct station_top {
+  struct station_key key;
+  int smallest; /* keep the smallest values ("bottom") */
+  uint32_t cap, n;
+  uint32_t offered; /* samples with the key since the last sort */
+  uint32_t *heap;  /* slot indexes, heap ordered by value */
+  double *value;   /* per slot */
+  struct station_sample *slot;
+};
+
+int station_top_init(struct station_top *t, uint32_t cap, const struct station_key *key,
+                     int smallest);
+void station_top_free(struct station_top *t);
+
+/* Offer a sample. Returns 1 if it was kept, 0 if not (no key, or beaten). */
+int station_top_add(struct station_top *t, const struct station_sample *s);
+
+/* Order the kept samples best first in heap[] and return how many there
+ * are; slot[heap[i]] is the i-th. The next station_top_add() starts over. */
+uint32_t station_top_sort(struct station_top *t);
+
+#endif // NETLINK_DEMO_FILTER_H
@@ -0,0 +1,111 @@
+// -F terms that cannot be read, and the top-N heap keeping the right samples
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "filter.h"
+
+static int failed;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond);      \
+      failed = 1;                                                     \
+    }                                                                 \
+  } while (0)
+
+/* station 'id' with a signal and 'rx_bytes' */
+static void sample(struct station_sample *s, uint8_t id, int8_t signal, uint64_t rx_bytes) {
+  memset(s, 0, sizeof *s);
+  s->present = STA_BIT(MAC) | STA_BIT(SIGNAL) | STA_BIT(RX_BYTES);
+  s->mac[0] = 0x02;
+  s->mac[5] = id;
+  s->signal = signal;
+  s->rx_bytes = rx_bytes;
+}
+
+/* 'expr' is rejected at the term starting at 'at' */
+static void check_bad(const char *expr, size_t at) {
+  struct station_filter f;
+  const char *bad = NULL;
+
+  CHECK(station_filter_parse(&f, expr, &bad) == -EINVAL);
+  CHECK(bad == expr + at);
+}
+
+static void check_filter(void) {
+  struct station_filter f;
+  struct station_sample s;
+  const char *bad = NULL;
+
+  CHECK(station_filter_parse(&f, ",signal<-75,,inactive>=10000,", &bad) == 0);
+  CHECK(f.n == 2 && f.term[0].op == FILTER_LT && f.term[0].value == -75);
+  CHECK(f.term[1].op == FILTER_GE && f.term[1].value == 10000);
+  sample(&s, 1, -80, 0);
+  CHECK(!station_filter_match(&f, &s)); /* no inactive_time, fails its term */
+  s.present |= STA_BIT(INACTIVE_TIME);
+  s.inactive_time = 10000;
+  CHECK(station_filter_match(&f, &s));
+  s.signal = -75;
+  CHECK(!station_filter_match(&f, &s));
+
+  check_bad("signal", 0);              /* no operator */
+  check_bad("signal<", 0);             /* no value */
+  check_bad("signal<<3", 0);           /* value is not a number */
+  check_bad("signal<-75dBm", 0);       /* trailing junk */
+  check_bad("signal<-75,bogus>1", 11); /* unknown key, at the second term */
+  check_bad("signal~3", 0);
+  check_bad("<3", 0);
+  check_bad("signal>1,signal>1,signal>1,signal>1,signal>1,signal>1,signal>1,signal>1,signal>1",
+            72); /* one term too many */
+}
+
+static void check_top(int smallest) {
+  /* rx_bytes of stations 1..10, in no particular order, with a tie */
+  static const uint64_t rx[] = {500, 100, 900, 300, 700, 900, 200, 800, 400, 600};
+  struct station_top t;
+  struct station_key key;
+  struct station_sample s;
+  uint32_t i, n;
+
+  CHECK(station_key_parse(&key, "rx_bytes", 8) == 0);
+  if (station_top_init(&t, 3, &key, smallest) < 0) {
+    fprintf(stderr, "out of memory\n");
+    failed = 1;
+    return;
+  }
+  for (i = 0; i < sizeof rx / sizeof rx[0]; i++) {
+    sample(&s, i + 1, -50, rx[i]);
+    station_top_add(&t, &s);
+  }
+  sample(&s, 11, -50, 0);
+  s.present &= ~STA_BIT(RX_BYTES);
+  CHECK(station_top_add(&t, &s) == 0); /* no key, never kept */
+
+  n = station_top_sort(&t);
+  CHECK(n == 3);
+  if (smallest) {
+    CHECK(t.slot[t.heap[0]].rx_bytes == 100 && t.slot[t.heap[0]].mac[5] == 2);
+    CHECK(t.slot[t.heap[1]].rx_bytes == 200 && t.slot[t.heap[1]].mac[5] == 7);
+    CHECK(t.slot[t.heap[2]].rx_bytes == 300 && t.slot[t.heap[2]].mac[5] == 4);
+  } else {
+    CHECK(t.slot[t.heap[0]].rx_bytes == 900 && t.slot[t.heap[1]].rx_bytes == 900);
+    CHECK(t.slot[t.heap[2]].rx_bytes == 800 && t.slot[t.heap[2]].mac[5] == 8);
+  }
+
+  /* the next round starts empty */
+  sample(&s, 12, -50, 1);
+  CHECK(station_top_add(&t, &s) == 1);
+  CHECK(station_top_sort(&t) == 1 && t.slot[t.heap[0]].mac[5] == 12);
+  station_top_free(&t);
+}
+
+int main(void) {
+  check_filter();
+  check_top(0);
+  check_top(1);
+  if (!failed) printf("filter_test: ok\n");
+  return failed;
+}
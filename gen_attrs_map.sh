@@ -0,0 +1,37 @@
+#!/bin/sh
+# Generate nl80211_attrs_map.h: NL80211_ATTR_* names indexed by attribute type,
+# taken from the linux/nl80211.h the program is compiled against.
+#
+# usage: gen_attrs_map.sh [cc [cflags...]] > nl80211_attrs_map.h
+
+CC=${1:-cc}
+[ $# -gt 0 ] && shift
+
+cat <<'HDR'
+/* generated by gen_attrs_map.sh from linux/nl80211.h, do not edit */
+
+#ifndef NETLINK_DEMO_NL80211_ATTRS_MAP_H
+#define NETLINK_DEMO_NL80211_ATTRS_MAP_H
+
+#include <linux/nl80211.h>
+
+/* attribute type -> name, NULL for holes */
+static const char *const nl_attr_names[NL80211_ATTR_MAX + 1] = {
+HDR
+
+printf '#include <linux/nl80211.h>\n' | $CC "$@" -E -P - | awk '
+  /enum nl80211_attrs *\{/ { inside = 1; next }
+  inside && /\}/ { exit }
+  inside {
+    sub(/[,=].*/, "")
+    gsub(/[ \t]/, "")
+    if ($0 ~ /^NL80211_ATTR_/ && $0 != "NL80211_ATTR_MAX")
+      printf "    [%s] = \"%s\",\n", $0, $0
+  }
+' || exit 1
+
+cat <<'HDR'
+};
+
+#endif // NETLINK_DEMO_NL80211_ATTRS_MAP_H
+HDR
@@ -0,0 +1,195 @@
+#include <errno.h>
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <linux/nl80211.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libstation.h"
+#include "nl80211_ids.h"
+#include "nlraw.h"
+
+#define STATION_CTX_MIN 64 /* samples allocated by the first dump */
+
+struct station_ctx {
+  int fd;
+  struct nl80211_ids ids;
+  char *cache_path; /* for nl80211_ids_refresh(), NULL if there is none */
+  unsigned decode_flags;
+  uint64_t fields; /* station_select() */
+  struct station_sample *samples; /* last dump, grown and never shrunk */
+  size_t n, cap;
+};
+
+struct station_ctx *station_open(const char *cache_path, unsigned flags, int *err) {
+  struct station_ctx *ctx = calloc(1, sizeof(*ctx));
+  int ret;
+
+  if (ctx == NULL) {
+    *err = -ENOMEM;
+    return NULL;
+  }
+  ctx->decode_flags = flags & STATION_OPEN_TIDS ? STATION_DECODE_TIDS : 0;
+  ctx->fields = STATION_FIELDS_ALL;
+  if (cache_path != NULL && (ctx->cache_path = strdup(cache_path)) == NULL) {
+    *err = -ENOMEM;
+    free(ctx);
+    return NULL;
+  }
+  ctx->fd = nlraw_open(NETLINK_GENERIC);
+  if (ctx->fd < 0) {
+    *err = ctx->fd;
+    free(ctx->cache_path);
+    free(ctx);
+    return NULL;
+  }
+  ret = nl80211_ids_get(ctx->fd, cache_path, &ctx->ids);
+  if (ret < 0) {
+    *err = ret;
+    station_close(ctx);
+    return NULL;
+  }
+  *err = 0;
+  return ctx;
+}
+
+void station_select(struct station_ctx *ctx, uint64_t fields) {
+  ctx->fields = fields;
+}
+
+void station_close(struct station_ctx *ctx) {
+  if (ctx == NULL) return;
+  if (ctx->fd >= 0) close(ctx->fd);
+  free(ctx->samples);
+  free(ctx->cache_path);
+  free(ctx);
+}
+
+static void station_ctx_req(struct station_ctx *ctx, struct nlraw_req *req, uint32_t ifindex,
+                            const uint8_t *mac) {
+  nlraw_req_init(req, ctx->ids.family_id, NL80211_CMD_GET_STATION,
+                 mac == NULL ? NLM_F_DUMP : NLM_F_ACK);
+  nlraw_req_put_u32(req, NL80211_ATTR_IFINDEX, ifindex);
+  if (mac != NULL) nlraw_req_put(req, NL80211_ATTR_MAC, mac, STATION_MAC_LEN);
+}
+
+/* The ids of the on-disk cache go stale when nl80211 is reloaded with another
+ * family id, and the kernel then answers -ENOENT or -EOPNOTSUPP. Such a
+ * failure resolves the ids again through the controller and asks for a retry
+ * (1) if the family id changed. Otherwise the error stands as the kernel
+ * gave it (0), except that losing nl80211 altogether is reported as
+ * -EPROTONOSUPPORT to keep it apart from a missing station. */
+static int station_ctx_stale(struct station_ctx *ctx, int err) {
+  int ret;
+
+  if (!ctx->ids.from_disk || (err != -ENOENT && err != -EOPNOTSUPP)) return 0;
+  ret = nl80211_ids_refresh(ctx->fd, ctx->cache_path, &ctx->ids);
+  if (ret == -ENOENT) return -EPROTONOSUPPORT;
+  return ret;
+}
+
+/* a station message of the dump, stations without statistics are skipped
+ * like the command line tool does */
+static int station_dump_cb(const struct nlmsghdr *nlh, void *arg) {
+  struct station_ctx *ctx = arg;
+  struct station_sample *s;
+  int ret;
+
+  if (nlh->nlmsg_type != ctx->ids.family_id) return 0;
+  if (ctx->n == ctx->cap) {
+    size_t cap = ctx->cap ? ctx->cap * 2 : STATION_CTX_MIN;
+
+    s = realloc(ctx->samples, cap * sizeof(*s));
+    if (s == NULL) return -ENOMEM;
+    ctx->samples = s;
+    ctx->cap = cap;
+  }
+  s = &ctx->samples[ctx->n];
+  ret = station_decode(nlh, s, ctx->decode_flags, ctx->fields);
+  if (ret == -ENODATA) return 0;
+  if (ret < 0) return ret;
+  s->event = 0;
+  if (ctx->n > 0) {
+    s->now_ms = ctx->samples[0].now_ms;
+    s->boot_ns = ctx->samples[0].boot_ns;
+  } else {
+    station_stamp(s);
+  }
+  ctx->n++;
+  return 0;
+}
+
+int station_dump(struct station_ctx *ctx, uint32_t ifindex) {
+  struct nlraw_req req;
+  int ret;
+
+  ctx->n = 0;
+  station_ctx_req(ctx, &req, ifindex, NULL);
+  ret = nlraw_transact(ctx->fd, &req, station_dump_cb, ctx);
+  if (ret < 0) {
+    int stale = station_ctx_stale(ctx, ret);
+
+    if (stale < 0) ret = stale;
+    if (stale == 1) {
+      ctx->n = 0;
+      station_ctx_req(ctx, &req, ifindex, NULL);
+      ret = nlraw_transact(ctx->fd, &req, station_dump_cb, ctx);
+    }
+  }
+  if (ret < 0) {
+    ctx->n = 0;
+    return ret;
+  }
+  return ctx->n;
+}
+
+struct station_get_arg {
+  struct station_ctx *ctx;
+  struct station_sample *out;
+  int found;
+};
+
+static int station_get_cb(const struct nlmsghdr *nlh, void *arg) {
+  struct station_get_arg *g = arg;
+  int ret;
+
+  if (nlh->nlmsg_type != g->ctx->ids.family_id) return 0;
+  ret = station_decode(nlh, g->out, g->ctx->decode_flags, g->ctx->fields);
+  if (ret < 0) return ret;
+  g->out->event = 0;
+  station_stamp(g->out);
+  g->found = 1;
+  return 0;
+}
+
+int station_get(struct station_ctx *ctx, uint32_t ifindex, const uint8_t *mac,
+                struct station_sample *out) {
+  struct station_get_arg g = {.ctx = ctx, .out = out};
+  struct nlraw_req req;
+  int ret;
+
+  station_ctx_req(ctx, &req, ifindex, mac);
+  ret = nlraw_transact(ctx->fd, &req, station_get_cb, &g);
+  if (ret < 0) {
+    int stale = station_ctx_stale(ctx, ret);
+
+    if (stale < 0) return stale;
+    if (stale == 0) return ret;
+    station_ctx_req(ctx, &req, ifindex, mac);
+    ret = nlraw_transact(ctx->fd, &req, station_get_cb, &g);
+  }
+  if (ret < 0) return ret;
+  return g.found ? 0 : -ENOENT;
+}
+
+const struct station_sample *station_next(const struct station_ctx *ctx,
+                                          const struct station_sample *prev) {
+  const struct station_sample *s = prev ? prev + 1 : ctx->samples;
+
+  return s < ctx->samples + ctx->n ? s : NULL;
+}
+
+size_t station_count(const struct station_ctx *ctx) {
+  return ctx->n;
+}
@@ -0,0 +1,55 @@
+//
+// libstation: nl80211 station statistics as decoded structs, in process
+//
+
+#ifndef NETLINK_DEMO_LIBSTATION_H
+#define NETLINK_DEMO_LIBSTATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "station.h" /* struct station_sample, STA_HAS() */
+
+#define LIBSTATION_VERSION 2 /* 2: station_select() */
+
+/* station_open() flags */
+#define STATION_OPEN_TIDS (1 << 0) /* also decode per TID statistics */
+
+/* One netlink socket and the samples of its last dump. Contexts are
+ * independent of each other, a context must not be used by two threads at
+ * the same time. */
+struct station_ctx;
+
+/* Open a context. 'cache_path' is the on-disk nl80211 id cache (NULL
+ * disables it). Returns NULL and sets '*err' to a negative errno on failure,
+ * -ENOENT if there is no nl80211. */
+struct station_ctx *station_open(const char *cache_path, unsigned flags, int *err);
+void station_close(struct station_ctx *ctx);
+
+/* Decode only the STA_BIT()s in 'fields' from now on, STATION_FIELDS_ALL
+ * (the default) for all of them; ifindex and MAC are always there. Nested
+ * attributes that are not selected are skipped without being parsed. */
+void station_select(struct station_ctx *ctx, uint64_t fields);
+
+/* Dump every station of interface 'ifindex' into the context, replacing the
+ * previous dump. Ids taken from the on-disk cache that turn out stale are
+ * resolved again and the request retried once. Returns the number of
+ * stations or a negative errno, -EPROTONOSUPPORT if nl80211 went away. */
+int station_dump(struct station_ctx *ctx, uint32_t ifindex);
+
+/* Query the station 'mac' of interface 'ifindex' into 'out', the dump stays
+ * as it is; stale ids are handled like station_dump() does. Returns 0,
+ * -ENOENT if the station is not associated, or another negative errno
+ * (-EPROTONOSUPPORT if nl80211 went away). */
+int station_get(struct station_ctx *ctx, uint32_t ifindex, const uint8_t *mac,
+                struct station_sample *out);
+
+/* Walk the samples of the last dump: NULL gives the first, the last gives
+ * NULL. Valid until the next station_dump() or station_close(). */
+const struct station_sample *station_next(const struct station_ctx *ctx,
+                                          const struct station_sample *prev);
+
+/* number of samples of the last dump */
+size_t station_count(const struct station_ctx *ctx);
+
+#endif // NETLINK_DEMO_LIBSTATION_H
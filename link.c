@@ -0,0 +1,122 @@
+#include <errno.h>
+#include <linux/rtnetlink.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "link.h"
+
+int link_decode(const struct nlmsghdr *nh, struct link_msg *m) {
+  const struct ifinfomsg *ifi = NLMSG_DATA(nh);
+  const struct rtattr *rta;
+  int len;
+
+  if (nh->nlmsg_type != RTM_NEWLINK && nh->nlmsg_type != RTM_DELLINK) return -EINVAL;
+  if (nh->nlmsg_len < NLMSG_LENGTH(sizeof(*ifi))) return -EINVAL;
+
+  memset(m, 0, sizeof(*m));
+  m->type = nh->nlmsg_type;
+  m->ifindex = ifi->ifi_index;
+  m->flags = ifi->ifi_flags;
+
+  len = nh->nlmsg_len - NLMSG_LENGTH(sizeof(*ifi));
+  for (rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+    /* NUL terminated and short enough for IF_NAMESIZE */
+    if (rta->rta_type == IFLA_IFNAME && RTA_PAYLOAD(rta) > 0 && RTA_PAYLOAD(rta) <= IF_NAMESIZE &&
+        memchr(RTA_DATA(rta), '\0', RTA_PAYLOAD(rta)))
+      m->name = RTA_DATA(rta);
+  }
+  return 0;
+}
+
+int link_cache_init(struct link_cache *c, uint32_t hint) {
+  c->cap = hint > 16 ? hint : 16;
+  c->count = 0;
+  c->e = calloc(c->cap, sizeof(*c->e));
+  return c->e ? 0 : -ENOMEM;
+}
+
+void link_cache_free(struct link_cache *c) {
+  free(c->e);
+  memset(c, 0, sizeof(*c));
+}
+
+void link_cache_clear(struct link_cache *c) {
+  c->count = 0;
+}
+
+static struct link_entry *link_cache_find(const struct link_cache *c, uint32_t ifindex) {
+  uint32_t i;
+
+  for (i = 0; i < c->count; i++)
+    if (c->e[i].ifindex == ifindex) return &c->e[i];
+  return NULL;
+}
+
+const char *link_cache_name(const struct link_cache *c, uint32_t ifindex) {
+  const struct link_entry *e = link_cache_find(c, ifindex);
+
+  return e ? e->name : NULL;
+}
+
+uint32_t link_cache_index(const struct link_cache *c, const char *name) {
+  uint32_t i;
+
+  for (i = 0; i < c->count; i++)
+    if (!strncmp(c->e[i].name, name, IF_NAMESIZE)) return c->e[i].ifindex;
+  return 0;
+}
+
+int link_cache_update(struct link_cache *c, const struct link_msg *m) {
+  struct link_entry *e;
+
+  if (m->ifindex == 0) return 0;
+  e = link_cache_find(c, m->ifindex);
+  if (m->type == RTM_DELLINK) {
+    if (e == NULL) return 0;
+    *e = c->e[--c->count]; /* the last one takes its place */
+    return 1;
+  }
+  /* most notifications are state changes, the name stays */
+  if (m->name == NULL) return 0;
+  if (e) {
+    if (!strcmp(e->name, m->name)) return 0;
+    snprintf(e->name, sizeof(e->name), "%s", m->name);
+    return 1;
+  }
+
+  if (c->count == c->cap) {
+    e = realloc(c->e, 2 * c->cap * sizeof(*e));
+    if (e == NULL) return -ENOMEM;
+    c->e = e;
+    c->cap *= 2;
+  }
+  e = &c->e[c->count++];
+  e->ifindex = m->ifindex;
+  snprintf(e->name, sizeof(e->name), "%s", m->name);
+  return 1;
+}
+
+static int link_dump_cb(const struct nlmsghdr *nh, void *arg) {
+  struct link_msg m;
+
+  if (link_decode(nh, &m) < 0) return 0;
+  return link_cache_update(arg, &m) < 0 ? -ENOMEM : 0;
+}
+
+int link_cache_dump(struct link_cache *c, int fd) {
+  struct {
+    struct nlmsghdr nlh;
+    struct ifinfomsg ifi;
+  } req = {
+      .nlh = {.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg)),
+              .nlmsg_type = RTM_GETLINK,
+              .nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP},
+      .ifi = {.ifi_family = AF_UNSPEC},
+  };
+  int ret;
+
+  ret = nlraw_transact_msg(fd, &req.nlh, link_dump_cb, c);
+  return ret < 0 ? ret : (int)c->count;
+}
@@ -0,0 +1,57 @@
+//
+// rtnetlink link decoder and interface index <-> name cache
+//
+
+#ifndef NETLINK_DEMO_LINK_H
+#define NETLINK_DEMO_LINK_H
+
+#include <linux/netlink.h>
+#include <net/if.h> /* IF_NAMESIZE */
+#include <stdint.h>
+
+#include "nlraw.h"
+
+/* One RTM_NEWLINK/RTM_DELLINK message, 'name' points into it. */
+struct link_msg {
+  uint16_t type;    /* RTM_NEWLINK or RTM_DELLINK */
+  uint32_t ifindex;
+  uint32_t flags;   /* IFF_* */
+  const char *name; /* IFLA_IFNAME, NULL if missing */
+};
+
+/* Returns 0, or -EINVAL if 'nh' is no link message or is truncated. */
+int link_decode(const struct nlmsghdr *nh, struct link_msg *m);
+
+struct link_entry {
+  uint32_t ifindex;
+  char name[IF_NAMESIZE];
+};
+
+/* A host has a handful of interfaces: one array in no particular order,
+ * searched front to back. Names are looked up by index on every formatted
+ * sample, indexes by name only when the interfaces are given. */
+struct link_cache {
+  uint32_t cap, count;
+  struct link_entry *e;
+};
+
+int link_cache_init(struct link_cache *c, uint32_t hint);
+void link_cache_free(struct link_cache *c);
+/* forget every interface, the room stays */
+void link_cache_clear(struct link_cache *c);
+
+/* Apply a decoded message: RTM_NEWLINK adds or renames, RTM_DELLINK
+ * removes. Returns 1 if the cache changed, 0 if not, -ENOMEM. */
+int link_cache_update(struct link_cache *c, const struct link_msg *m);
+
+/* Fill the cache from an RTM_GETLINK dump over the NETLINK_ROUTE socket
+ * 'fd'. Returns the number of interfaces or a negative errno. */
+int link_cache_dump(struct link_cache *c, int fd);
+
+/* name of 'ifindex', NULL if unknown */
+const char *link_cache_name(const struct link_cache *c, uint32_t ifindex);
+
+/* index of the interface 'name', 0 if unknown */
+uint32_t link_cache_index(const struct link_cache *c, const char *name);
+
+#endif // NETLINK_DEMO_LINK_H
@@ -1,32 +1,44 @@
 #define _GNU_SOURCE 1      /* this macro is needed to define struct ucred */
 #include <arpa/inet.h>     /* inet_ntop() */
 #include <errno.h>         /* printf */
+#include <fcntl.h>         /* open() */
 #include <linux/netlink.h> /*netlink macros and structures */
 #include <linux/nl80211.h> /* 802.11 netlink interface */
+#include <linux/rtnetlink.h> /* neighbour notifications */
 #include <net/if.h>
+#include <pthread.h> /* worker mode */
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdbool.h> /* bool, true, false macros */
 #include <stdio.h>   /* printf */
+#include <stdlib.h>  /* strtoul() */
 #include <string.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h> /*struct ucred */
 #include <time.h>
 #include <unistd.h> /* close() */
 
-/* libnl-3 */
-#include <netlink/attr.h>
-#include <netlink/msg.h>
-#include <netlink/netlink.h>
-
-/*libnl-gen-3*/
-#include <netlink/genl/ctrl.h>
-#include <netlink/genl/genl.h>
-
-#include "nl80211_attrs_map.h" /* netlink attribute types names */
+#include "bench.h"       /* decode micro benchmark */
+#include "capture.h"     /* record and replay raw replies */
+#include "evloop.h"      /* epoll loop, watch timer */
+#include "filter.h"      /* filter expressions, top-N */
+#include "link.h"        /* interface names by index */
+#include "neigh.h"       /* client addresses by MAC */
+#include "nlraw.h"       /* requests and replies without libnl */
+#include "nlrx.h"        /* batched dump receive */
+#include "nl80211_ids.h" /* family id cache */
+#include "output.h"      /* station sample formatters */
+#include "prom.h"        /* Prometheus exporter */
+#include "rates.h"       /* watch mode counter deltas */
+#include "spsc.h"        /* worker to writer rings */
+#include "stats.h"       /* counters and latency histograms */
+#include "station.h"     /* station record decoder */
+#include "synth.h"       /* synthetic station dumps */
 
 /* used macros */
-#ifndef NL_OWN_PORT
-#define NL_OWN_PORT (1 << 2)
-#endif
 #define ETH_ALEN 6
+#define STRESS_ITERATIONS 1000 /* passes per thread unless bench <n> says otherwise */
+#define SYNTH_STATIONS 1000000 /* stations decoded per dump size unless bench <n> is given */
 
 /* cli arguments parse macro and functions */
 #define NEXT_ARG()                         \
@@ -46,316 +58,103 @@ static void usage(void) {
   fprintf(stdout, ""
                   "Usage:   %s [options] [command value] ... [command value]    \n"
                   "options: -b\tshow brief only                                 \n"
-                  "command: dev | mac | help                                    \n"
+                  "         -v\tshow per TID statistics                         \n"
+                  "         -e\treport station joins/leaves as they happen   \n"
+                  "         -n\treport neighbour (ARP/ND) changes of stations and add\n"
+                  "         \t\ttheir IPv4/IPv6 addresses to the samples\n"
+                  "         -w\tpoll every wiphy in its own thread, format in one\n"
+                  "         --stats\tcount syscalls, bytes and errors, time the hot path,\n"
+                  "         \t\tprint a summary with latency histograms at exit\n"
+                  "         -o <fmt>\toutput format: text, brief, bin, json or csv\n"
+                  "         -f <f,..>\tdecode and print only these fields (JSON keys, e.g.\n"
+                  "         \t\tsignal,tx_bitrate,rx_bytes,delta), ifindex and mac always\n"
+                  "command: dev | mac | watch | count | cache | bench | stress | tablebench | synth |\n"
+                  "         mix | out | record | replay | stats | filter | top | bottom | serve |\n"
+                  "         help\n"
+                  "         watch <ms>\tpoll every <ms> milliseconds over one socket\n"
+                  "         count <n>\tstop watch mode after <n> samples        \n"
+                  "         cache <file>\tkeep resolved nl80211 ids in <file> per boot\n"
+                  "         bench <n>\tdecode one recorded dump <n> times, print ns/station\n"
+                  "         stress <n>\tdecode and format one recorded dump in <n> threads,\n"
+                  "         \t\tcompare with one thread (bench <n> sets the passes),\n"
+                  "         \t\twith -w time the worker pipeline for 1 to <n> workers\n"
+                  "         tablebench <n>\ttime station table insert/lookup/expire of <n> stations\n"
+                  "         synth <n,..>\tdecode and format generated dumps of <n> stations,\n"
+                  "         \t\tprint stations/s and bytes/s (stress <n> works too)\n"
+                  "         mix <m>\tattributes of generated stations: min, typical, full or\n"
+                  "         \t\ta list of signal,chains,rates,bss,flags,airtime,mesh,tids\n"
+                  "         out <file>\twrite samples to <file> instead of stdout\n"
+                  "         record <file>\tsave the raw netlink replies to <file>\n"
+                  "         replay <file>\tdecode replies saved by record, no device needed\n"
+                  "         stats <s>\t--stats, and in watch mode a report every <s> seconds\n"
+                  "         filter <e>\tformat only stations matching all terms of <e>, e.g.\n"
+                  "         \t\tsignal<-75,inactive>10000,tx_bitrate<50,delta.tx_failed>0\n"
+                  "         top <n> <k>\tformat the <n> stations with the largest <k> per\n"
+                  "         \t\tround (bottom: smallest), <k> as in filter\n"
+                  "         serve <a>\texport the last round's stations for Prometheus on\n"
+                  "         \t\thttp://<a>/metrics instead of printing, <a> a port on\n"
+                  "         \t\t127.0.0.1 or <address>:<port>, needs watch\n"
                   "\n"
                   "Example: %s dev wlan0 mac 00:ff:12:a3:e3                     \n"
                   "         %s dev wlan0                                        \n"
+                  "         %s dev wlan0 watch 1000                             \n"
+                  "         %s dev wlan0,wlan1 | all                            \n"
+                  "         %s -o bin dev all watch 1000 out /var/log/sta.bin   \n"
+                  "         %s -e -o json dev all watch 60000                   \n"
+                  "         %s -e -n dev wlan0                                  \n"
+                  "         %s -w -o bin dev all watch 1000 out /var/log/sta.bin\n"
+                  "         %s dev wlan0 watch 1000 count 60 record wlan0.cap   \n"
+                  "         %s -o json replay wlan0.cap                         \n"
+                  "         %s -o json mix full synth 100,1000,10000,100000     \n"
+                  "         %s -o json -f signal,tx_bitrate,rx_bytes dev all watch 1000\n"
+                  "         %s -b dev all bottom 20 signal filter inactive<60000      \n"
+                  "         %s dev all watch 5000 serve 9101                    \n"
                   "\n",
-          argv0, argv0, argv0);
+          argv0, argv0, argv0, argv0, argv0, argv0, argv0, argv0, argv0, argv0, argv0, argv0, argv0,
+          argv0, argv0);
   exit(-1);
 }
 
-enum plink_state {
-  LISTEN,
-  OPN_SNT,
-  OPN_RCVD,
-  CNF_RCVD,
-  ESTAB,
-  HOLDING,
-  BLOCKED
-};
-
-// struct nl_sock {
-//     struct sockaddr_nl s_local;
-//     struct sockaddr_nl s_peer;
-//     int s_fd;
-//     int s_proto;
-//     unsigned int s_seq_next;
-//     unsigned int s_seq_expect;
-//     int s_flags;
-//     struct nl_cb *s_cb;
-//     size_t s_bufsize;
-// };
-
+/* Everything one run needs, owned by main() and handed down: there is no
+ * process wide mutable state, so several of these can be used by as many
+ * threads at the same time. */
 struct nl80211_state {
-  struct nl_sock *nl_sock;
   int nl80211_id;
-} nl80211State = {
-    .nl_sock = NULL,
-    .nl80211_id = 0};
-
-static void print_power_mode(struct nlattr *a) {
-  enum nl80211_mesh_power_mode pm = nla_get_u32(a);
-
-  switch (pm) {
-  case NL80211_MESH_POWER_ACTIVE:
-    printf("ACTIVE");
-    break;
-  case NL80211_MESH_POWER_LIGHT_SLEEP:
-    printf("LIGHT SLEEP");
-    break;
-  case NL80211_MESH_POWER_DEEP_SLEEP:
-    printf("DEEP SLEEP");
-    break;
-  default:
-    printf("UNKNOWN");
-    break;
-  }
-}
-
-int parse_txq_stats(char *buf, int buflen, struct nlattr *tid_stats_attr, int header,
-                    int tid, const char *indent);
-int parse_txq_stats(char *buf, int buflen, struct nlattr *tid_stats_attr, int header,
-                    int tid, const char *indent) {
-  struct nlattr *txqstats_info[NL80211_TXQ_STATS_MAX + 1], *txqinfo;
-  static struct nla_policy txqstats_policy[NL80211_TXQ_STATS_MAX + 1] = {
-      [NL80211_TXQ_STATS_BACKLOG_BYTES] = {.type = NLA_U32},
-      [NL80211_TXQ_STATS_BACKLOG_PACKETS] = {.type = NLA_U32},
-      [NL80211_TXQ_STATS_FLOWS] = {.type = NLA_U32},
-      [NL80211_TXQ_STATS_DROPS] = {.type = NLA_U32},
-      [NL80211_TXQ_STATS_ECN_MARKS] = {.type = NLA_U32},
-      [NL80211_TXQ_STATS_OVERLIMIT] = {.type = NLA_U32},
-      [NL80211_TXQ_STATS_COLLISIONS] = {.type = NLA_U32},
-      [NL80211_TXQ_STATS_TX_BYTES] = {.type = NLA_U32},
-      [NL80211_TXQ_STATS_TX_PACKETS] = {.type = NLA_U32},
-  };
-  char *pos = buf;
-  if (nla_parse_nested(txqstats_info, NL80211_TXQ_STATS_MAX, tid_stats_attr,
-                       txqstats_policy)) {
-    printf("failed to parse nested TXQ stats attributes!");
-    return 0;
-  }
-
-  if (header)
-    pos += snprintf(buf, buflen, "\n%s\t%s\tqsz-byt\t"
-                                 "qsz-pkt\tflows\tdrops\tmarks\toverlmt\t"
-                                 "hashcol\ttx-bytes\ttx-packets",
-                    indent,
-                    tid >= 0 ? "TID" : "");
-
-  pos += snprintf(pos, buflen - (pos - buf), "\n%s\t", indent);
-  if (tid >= 0)
-    pos += snprintf(pos, buflen - (pos - buf), "%d", tid);
-
-#define PRINT_STAT(key, spacer)                         \
-  do {                                                  \
-    txqinfo = txqstats_info[NL80211_TXQ_STATS_##key];   \
-    pos += snprintf(pos, buflen - (pos - buf), spacer); \
-    if (txqinfo)                                        \
-      pos += snprintf(pos, buflen - (pos - buf), "%u",  \
-                      nla_get_u32(txqinfo));            \
-  } while (0)
-
-  PRINT_STAT(BACKLOG_BYTES, "\t");
-  PRINT_STAT(BACKLOG_PACKETS, "\t");
-  PRINT_STAT(FLOWS, "\t");
-  PRINT_STAT(DROPS, "\t");
-  PRINT_STAT(ECN_MARKS, "\t");
-  PRINT_STAT(OVERLIMIT, "\t");
-  PRINT_STAT(COLLISIONS, "\t");
-  PRINT_STAT(TX_BYTES, "\t");
-  PRINT_STAT(TX_PACKETS, "\t\t");
-
-#undef PRINT_STAT
-
-  return pos - buf;
-}
-
-static void parse_tid_stats(struct nlattr *tid_stats_attr) {
-  struct nlattr *stats_info[NL80211_TID_STATS_MAX + 1], *tidattr, *info;
-  static struct nla_policy stats_policy[NL80211_TID_STATS_MAX + 1] = {
-      [NL80211_TID_STATS_RX_MSDU] = {.type = NLA_U64},
-      [NL80211_TID_STATS_TX_MSDU] = {.type = NLA_U64},
-      [NL80211_TID_STATS_TX_MSDU_RETRIES] = {.type = NLA_U64},
-      [NL80211_TID_STATS_TX_MSDU_FAILED] = {.type = NLA_U64},
-      [NL80211_TID_STATS_TXQ_STATS] = {.type = NLA_NESTED},
-  };
-  int rem, i = 0;
-  char txqbuf[2000] = {}, *pos = txqbuf;
-  int buflen = sizeof(txqbuf), foundtxq = 0;
-
-  printf("\n\tMSDU:\n\t\tTID\trx\ttx\ttx retries\ttx failed");
-  nla_for_each_nested(tidattr, tid_stats_attr, rem) {
-    if (nla_parse_nested(stats_info, NL80211_TID_STATS_MAX,
-                         tidattr, stats_policy)) {
-      printf("failed to parse nested stats attributes!");
-      return;
-    }
-    printf("\n\t\t%d", i);
-    info = stats_info[NL80211_TID_STATS_RX_MSDU];
-    if (info)
-      printf("\t%llu", (unsigned long long)nla_get_u64(info));
-    info = stats_info[NL80211_TID_STATS_TX_MSDU];
-    if (info)
-      printf("\t%llu", (unsigned long long)nla_get_u64(info));
-    info = stats_info[NL80211_TID_STATS_TX_MSDU_RETRIES];
-    if (info)
-      printf("\t%llu", (unsigned long long)nla_get_u64(info));
-    info = stats_info[NL80211_TID_STATS_TX_MSDU_FAILED];
-    if (info)
-      printf("\t\t%llu", (unsigned long long)nla_get_u64(info));
-    info = stats_info[NL80211_TID_STATS_TXQ_STATS];
-    if (info) {
-      pos += parse_txq_stats(pos, buflen - (pos - txqbuf), info, !foundtxq, i, "\t");
-      foundtxq = 1;
-    }
+  struct nl80211_ids ids;
+  const char *cache_path; /* on-disk family id cache, NULL if disabled */
+  struct station_out out; /* selected formatter */
+  struct station_sample sample; /* decode buffer reused for every station */
+  struct station_sample note;   /* decode buffer of notifications */
+  struct station_rates rates;   /* previous counters, watch mode only */
+  uint64_t fields;              /* -f: STA_BIT()s to print, STATION_FIELDS_ALL */
+  uint64_t decode_fields;       /* and to decode, the delta sources included */
+  struct station_filter filter; /* samples that get formatted, n 0 for all */
+  struct station_top top;       /* top/bottom: a round's best, cap 0 if off */
+  struct neigh_cache neigh;     /* -n: client addresses by MAC, cap 0 if off */
+  struct link_cache links;      /* interface names by index, cap 0 if not loaded */
+  struct evloop_source links_src; /* their changes, fd -1 if not followed */
+  struct prom prom;             /* serve: the last rounds' stations, cap 0 if off */
+  struct evloop_source serve;   /* its HTTP listener */
+  struct spsc *ring;            /* worker mode: samples go to the writer thread */
+  int wake_fd;                  /* worker mode: eventfd the writer waits on */
+  const char *record_path;      /* save raw replies here */
+  struct capture cap;           /* open while recording (cap.f set) */
+  const struct capture_rec *replay; /* replay: the record being fed, its stamps count */
+  struct stats stats;           /* since the last report */
+  struct stats stats_total;     /* reported earlier, and ended workers */
+  uint64_t stats_period_ns;     /* report that often, 0: only the total at exit */
+  uint64_t stats_last_ns;       /* boot time of the last report */
+  const char *stats_name;       /* worker mode: first interface of the worker */
+};
 
-    i++;
-  }
-
-  if (foundtxq)
-    printf("\n\tTXQs:%s", txqbuf);
-}
-
-static void parse_bss_param(struct nlattr *bss_param_attr) {
-  struct nlattr *bss_param_info[NL80211_STA_BSS_PARAM_MAX + 1], *info;
-  static struct nla_policy bss_poilcy[NL80211_STA_BSS_PARAM_MAX + 1] = {
-      [NL80211_STA_BSS_PARAM_CTS_PROT] = {.type = NLA_FLAG},
-      [NL80211_STA_BSS_PARAM_SHORT_PREAMBLE] = {.type = NLA_FLAG},
-      [NL80211_STA_BSS_PARAM_SHORT_SLOT_TIME] = {.type = NLA_FLAG},
-      [NL80211_STA_BSS_PARAM_DTIM_PERIOD] = {.type = NLA_U8},
-      [NL80211_STA_BSS_PARAM_BEACON_INTERVAL] = {.type = NLA_U16},
-  };
-
-  if (nla_parse_nested(bss_param_info, NL80211_STA_BSS_PARAM_MAX,
-                       bss_param_attr, bss_poilcy)) {
-    printf("failed to parse nested bss param attributes!");
-  }
-
-  info = bss_param_info[NL80211_STA_BSS_PARAM_DTIM_PERIOD];
-  if (info)
-    printf("\n\tDTIM period:\t%u", nla_get_u8(info));
-  info = bss_param_info[NL80211_STA_BSS_PARAM_BEACON_INTERVAL];
-  if (info)
-    printf("\n\tbeacon interval:%u", nla_get_u16(info));
-  info = bss_param_info[NL80211_STA_BSS_PARAM_CTS_PROT];
-  if (info) {
-    printf("\n\tCTS protection:");
-    if (nla_get_u16(info))
-      printf("\tyes");
-    else
-      printf("\tno");
-  }
-  info = bss_param_info[NL80211_STA_BSS_PARAM_SHORT_PREAMBLE];
-  if (info) {
-    printf("\n\tshort preamble:");
-    if (nla_get_u16(info))
-      printf("\tyes");
-    else
-      printf("\tno");
-  }
-  info = bss_param_info[NL80211_STA_BSS_PARAM_SHORT_SLOT_TIME];
-  if (info) {
-    printf("\n\tshort slot time:");
-    if (nla_get_u16(info))
-      printf("yes");
-    else
-      printf("no");
-  }
-}
-
-static char *get_chain_signal(struct nlattr *attr_list) {
-  struct nlattr *attr;
-  static char buf[64];
-  char *cur = buf;
-  int i = 0, rem;
-  const char *prefix;
-
-  if (!attr_list)
-    return "";
-
-  nla_for_each_nested(attr, attr_list, rem) {
-    if (i++ > 0)
-      prefix = ", ";
-    else
-      prefix = "[";
-
-    cur += snprintf(cur, sizeof(buf) - (cur - buf), "%s%d", prefix,
-                    (int8_t)nla_get_u8(attr));
-  }
-
-  if (i)
-    snprintf(cur, sizeof(buf) - (cur - buf), "] ");
-
-  return buf;
-}
-
-static void parse_bitrate(struct nlattr *bitrate_attr, char *buf, int buflen) {
-  int rate = 0;
-  char *pos = buf;
-  struct nlattr *rinfo[NL80211_RATE_INFO_MAX + 1];
-  static struct nla_policy rate_policy[NL80211_RATE_INFO_MAX + 1] = {
-      [NL80211_RATE_INFO_BITRATE] = {.type = NLA_U16},
-      [NL80211_RATE_INFO_BITRATE32] = {.type = NLA_U32},
-      [NL80211_RATE_INFO_MCS] = {.type = NLA_U8},
-      [NL80211_RATE_INFO_40_MHZ_WIDTH] = {.type = NLA_FLAG},
-      [NL80211_RATE_INFO_SHORT_GI] = {.type = NLA_FLAG},
-  };
-
-  if (nla_parse_nested(rinfo, NL80211_RATE_INFO_MAX,
-                       bitrate_attr, rate_policy)) {
-    snprintf(buf, buflen, "failed to parse nested rate attributes!");
+/* wall clock and boot time, the recorded ones while replaying */
+static void station_clock(struct nl80211_state *st, struct station_sample *s) {
+  if (st->replay) {
+    s->now_ms = st->replay->now_ms;
+    s->boot_ns = st->replay->boot_ns;
     return;
   }
-
-  if (rinfo[NL80211_RATE_INFO_BITRATE32])
-    rate = nla_get_u32(rinfo[NL80211_RATE_INFO_BITRATE32]);
-  else if (rinfo[NL80211_RATE_INFO_BITRATE])
-    rate = nla_get_u16(rinfo[NL80211_RATE_INFO_BITRATE]);
-  if (rate > 0)
-    pos += snprintf(pos, buflen - (pos - buf),
-                    "%d.%d MBit/s", rate / 10, rate % 10);
-  else
-    pos += snprintf(pos, buflen - (pos - buf), "(unknown)");
-
-  if (rinfo[NL80211_RATE_INFO_MCS])
-    pos += snprintf(pos, buflen - (pos - buf),
-                    " MCS %d", nla_get_u8(rinfo[NL80211_RATE_INFO_MCS]));
-  if (rinfo[NL80211_RATE_INFO_VHT_MCS])
-    pos += snprintf(pos, buflen - (pos - buf),
-                    " VHT-MCS %d", nla_get_u8(rinfo[NL80211_RATE_INFO_VHT_MCS]));
-  if (rinfo[NL80211_RATE_INFO_40_MHZ_WIDTH])
-    pos += snprintf(pos, buflen - (pos - buf), " 40MHz");
-  if (rinfo[NL80211_RATE_INFO_80_MHZ_WIDTH])
-    pos += snprintf(pos, buflen - (pos - buf), " 80MHz");
-  if (rinfo[NL80211_RATE_INFO_80P80_MHZ_WIDTH])
-    pos += snprintf(pos, buflen - (pos - buf), " 80P80MHz");
-  if (rinfo[NL80211_RATE_INFO_160_MHZ_WIDTH])
-    pos += snprintf(pos, buflen - (pos - buf), " 160MHz");
-  if (rinfo[NL80211_RATE_INFO_320_MHZ_WIDTH])
-    pos += snprintf(pos, buflen - (pos - buf), " 320MHz");
-  if (rinfo[NL80211_RATE_INFO_SHORT_GI])
-    pos += snprintf(pos, buflen - (pos - buf), " short GI");
-  if (rinfo[NL80211_RATE_INFO_VHT_NSS])
-    pos += snprintf(pos, buflen - (pos - buf),
-                    " VHT-NSS %d", nla_get_u8(rinfo[NL80211_RATE_INFO_VHT_NSS]));
-  if (rinfo[NL80211_RATE_INFO_HE_MCS])
-    pos += snprintf(pos, buflen - (pos - buf),
-                    " HE-MCS %d", nla_get_u8(rinfo[NL80211_RATE_INFO_HE_MCS]));
-  if (rinfo[NL80211_RATE_INFO_HE_NSS])
-    pos += snprintf(pos, buflen - (pos - buf),
-                    " HE-NSS %d", nla_get_u8(rinfo[NL80211_RATE_INFO_HE_NSS]));
-  if (rinfo[NL80211_RATE_INFO_HE_GI])
-    pos += snprintf(pos, buflen - (pos - buf),
-                    " HE-GI %d", nla_get_u8(rinfo[NL80211_RATE_INFO_HE_GI]));
-  if (rinfo[NL80211_RATE_INFO_HE_DCM])
-    pos += snprintf(pos, buflen - (pos - buf),
-                    " HE-DCM %d", nla_get_u8(rinfo[NL80211_RATE_INFO_HE_DCM]));
-  if (rinfo[NL80211_RATE_INFO_HE_RU_ALLOC])
-    pos += snprintf(pos, buflen - (pos - buf),
-                    " HE-RU-ALLOC %d", nla_get_u8(rinfo[NL80211_RATE_INFO_HE_RU_ALLOC]));
-  if (rinfo[NL80211_RATE_INFO_EHT_MCS])
-    pos += snprintf(pos, buflen - (pos - buf),
-                    " EHT-MCS %d", nla_get_u8(rinfo[NL80211_RATE_INFO_EHT_MCS]));
-  if (rinfo[NL80211_RATE_INFO_EHT_NSS])
-    pos += snprintf(pos, buflen - (pos - buf),
-                    " EHT-NSS %d", nla_get_u8(rinfo[NL80211_RATE_INFO_EHT_NSS]));
-  if (rinfo[NL80211_RATE_INFO_EHT_GI])
-    pos += snprintf(pos, buflen - (pos - buf),
-                    " EHT-GI %d", nla_get_u8(rinfo[NL80211_RATE_INFO_EHT_GI]));
-  if (rinfo[NL80211_RATE_INFO_EHT_RU_ALLOC])
-    pos += snprintf(pos, buflen - (pos - buf),
-                    " EHT-RU-ALLOC %d", nla_get_u8(rinfo[NL80211_RATE_INFO_EHT_RU_ALLOC]));
+  station_stamp(s);
 }
 
 static int mac_addr_atoi(uint8_t *mac, const char *hex) {
@@ -373,472 +172,1810 @@ static int mac_addr_atoi(uint8_t *mac, const char *hex) {
   return 1;
 }
 
-static const char *get_nl_attr_type(unsigned type) {
-  size_t i;
+/* the station's client addresses from the neighbour cache */
+static void station_neigh_fill(const struct neigh_cache *c, struct station_sample *s) {
+  const struct in6_addr *v6;
+  int32_t slot;
+
+  if (c->cap == 0 || !STA_HAS(s, MAC)) return;
+  slot = neigh_cache_find(c, station_table_mac(s->mac));
+  if (slot < 0) return;
+  if (c->ipv4[slot].s_addr != INADDR_ANY) {
+    memcpy(s->ipv4, &c->ipv4[slot], sizeof(s->ipv4));
+    s->present |= STA_BIT(IPV4);
+  }
+  v6 = neigh_cache_ipv6(c, slot);
+  if (v6) {
+    memcpy(s->ipv6, v6, sizeof(s->ipv6));
+    s->present |= STA_BIT(IPV6);
+  }
+}
+
+/* decode one station message of a dump into the context sample and hand it
+ * to the selected formatter, no printing happens here */
+static void station_sample_out(struct nl80211_state *st, const struct nlmsghdr *ret_hdr) {
+  struct station_sample *sample = &st->sample;
+  uint64_t start;
+  int ret;
+
+  /* worker mode decodes straight into the writer's ring */
+  if (st->ring) {
+    sample = spsc_claim(st->ring);
+    if (sample == NULL) {
+      stats_count(&st->stats, STATS_DROPPED, 1);
+      return;
+    }
+    sample->now_ms = st->sample.now_ms;
+    sample->boot_ns = st->sample.boot_ns;
+  }
+
+  start = stats_start(&st->stats);
+  ret = station_decode(ret_hdr, sample, st->out.verbose ? STATION_DECODE_TIDS : 0,
+                       st->decode_fields);
+  stats_end(&st->stats, STATS_DECODE, start);
+  stats_count(&st->stats, STATS_STATIONS, 1);
+  if (ret == -ENODATA) {
+    fprintf(stderr, "sta stats missing!\n");
+    return;
+  }
+  if (ret < 0) {
+    stats_count(&st->stats, STATS_PARSE_ERRORS, 1);
+    fprintf(stderr, "failed to parse nested attributes!\n");
+    return;
+  }
+  sample->event = 0;
+  if (st->rates.t.cap && station_rates_update(&st->rates, sample) < 0)
+    fprintf(stderr, "failed to grow the station table!\n");
+  station_neigh_fill(&st->neigh, sample);
+  /* nothing left out gets near the formatter or the ring */
+  if (!station_filter_match(&st->filter, sample)) {
+    stats_count(&st->stats, STATS_FILTERED, 1);
+    return;
+  }
+  if (st->top.cap) { /* out at the end of the round */
+    station_top_add(&st->top, sample);
+    return;
+  }
+  sample->present &= st->fields;
+  if (st->prom.cap) { /* kept for the scrapes instead of formatted */
+    if (prom_update(&st->prom, sample, station_out_ifname(&st->out, sample->ifindex)) < 0)
+      fprintf(stderr, "failed to grow the exporter table!\n");
+    return;
+  }
+
+  if (st->ring) {
+    spsc_publish(st->ring);
+    return;
+  }
+  start = stats_start(&st->stats);
+  st->out.fmt->sample(&st->out, sample);
+  stats_end(&st->stats, STATS_FORMAT, start);
+}
+
+/* notifications are decoded into st->note, in worker mode it is copied */
+static void station_note_out(struct nl80211_state *st, const struct station_sample *note) {
+  struct station_sample *slot;
+  uint64_t start;
+
+  stats_count(&st->stats, STATS_EVENTS, 1);
+  if (st->prom.cap) return; /* the exporter shows what the dumps return */
+  if (st->ring == NULL) {
+    start = stats_start(&st->stats);
+    st->out.fmt->sample(&st->out, note);
+    stats_end(&st->stats, STATS_FORMAT, start);
+    return;
+  }
+  slot = spsc_claim(st->ring);
+  if (slot == NULL) {
+    stats_count(&st->stats, STATS_DROPPED, 1);
+    return;
+  }
+  memcpy(slot, note, sizeof(*slot));
+  spsc_publish(st->ring);
+}
+
+/* Returns true if 'prefix' is a not empty prefix of 'string'. */
+static bool matches(const char *prefix, const char *string) {
+  if (!*prefix)
+    return false;
+  while (*string && *prefix == *string) {
+    prefix++;
+    string++;
+  }
+  return !*prefix;
+}
+
+static void incomplete_command(void) {
+  fprintf(stderr, "Command line is not complete. Try option \"help\"\n");
+  exit(-1);
+}
+
+/* watch mode stop flag, set from SIGINT/SIGTERM handler, read by workers */
+static atomic_int stop_requested;
+
+static void on_stop_signal(int sig) {
+  (void)sig;
+  stop_requested = 1;
+}
+
+/* one polled interface with its own socket: the kernel keeps a single dump
+ * in flight per netlink socket (a second dump request gets EBUSY), so
+ * pipelined dumps need one socket each */
+struct station_watch;
+struct station_dev {
+  char name[IF_NAMESIZE];
+  int ifindex;
+  int wiphy;             /* radio, -1 if not known */
+  int fd;                /* nl80211 socket, -1 if not open */
+  struct nlraw_req req;  /* prebuilt GET_STATION request */
+  int last_error;     /* errno of the last NLMSG_ERROR reply */
+  int ret;            /* result of the last request */
+  int pending;        /* request sent, its DONE, ACK or error not seen yet */
+  uint32_t seq;       /* sequence number of that request */
+  struct evloop_source src;
+  struct station_watch *w;
+};
+
+/* open an nl80211 socket, the family id is resolved once per process.
+ * Returns the fd or a negative errno. */
+static int nl80211_open(struct nl80211_state *st) {
+  uint64_t start;
+  int fd, ret;
+
+  /* nl_socket_alloc(), genl_connect() replacement */
+  fd = nlraw_open(NETLINK_GENERIC);
+  if (fd < 0) {
+    fprintf(stderr, "socket: %d %s\n", -fd, strerror(-fd));
+    return fd;
+  }
+
+  // find the nl80211 driver ID, cached in-process and optionally on disk
+  start = stats_start(&st->stats);
+  ret = nl80211_ids_get(fd, st->cache_path, &st->ids);
+  stats_end(&st->stats, STATS_RESOLVE, start);
+  if (ret < 0) {
+    fprintf(stderr, "nl80211 family: %d %s\n", ret, strerror(-ret));
+    close(fd);
+    return ret;
+  }
+  st->nl80211_id = st->ids.family_id;
+  return fd;
+}
+
+/* collect wireless interfaces from an NL80211_CMD_GET_INTERFACE dump */
+struct iface_list {
+  struct station_dev *devs;
+  int n, cap;
+  int family_id;
+};
+
+static int station_iface_msg(const struct nlmsghdr *nlh, void *arg) {
+  struct iface_list *list = arg;
+  const struct nlattr *a;
+  const char *name = NULL;
+  struct station_dev *dev;
+  int ifindex = 0, wiphy = -1, rem;
+
+  if (nlh->nlmsg_type != list->family_id) return 0;
+  attr_for_each(a, genl_attrs(nlh), genl_attrs_len(nlh), rem) {
+    if (attr_type(a) == NL80211_ATTR_IFINDEX && attr_len(a) >= (int)sizeof(uint32_t))
+      ifindex = attr_u32(a);
+    else if (attr_type(a) == NL80211_ATTR_WIPHY && attr_len(a) >= (int)sizeof(uint32_t))
+      wiphy = attr_u32(a);
+    else if (attr_type(a) == NL80211_ATTR_IFNAME && attr_len(a) > 0 &&
+             ((const char *)attr_data(a))[attr_len(a) - 1] == '\0')
+      name = attr_data(a);
+  }
+  if (ifindex == 0 || name == NULL) return 0;
+
+  if (list->n == list->cap) {
+    int cap = list->cap ? list->cap * 2 : 8;
+    struct station_dev *devs = realloc(list->devs, cap * sizeof(*devs));
+    if (devs == NULL) return -ENOMEM;
+    list->devs = devs;
+    list->cap = cap;
+  }
+  dev = &list->devs[list->n++];
+  memset(dev, 0, sizeof(*dev));
+  dev->fd = -1;
+  dev->ifindex = ifindex;
+  dev->wiphy = wiphy;
+  snprintf(dev->name, sizeof(dev->name), "%s", name);
+  return 0;
+}
+
+/* "all" expands to every nl80211 interface, otherwise a comma separated list */
+static int station_devs_parse(struct nl80211_state *st, const char *arg,
+                              struct station_dev **devs) {
+  struct iface_list list = {};
+  const char *p, *end;
+
+  if (!strcmp(arg, "all")) {
+    struct nlraw_req req;
+    int fd, ret;
+
+    fd = nl80211_open(st);
+    if (fd < 0) return fd;
+    list.family_id = st->nl80211_id;
+    nlraw_req_init(&req, st->nl80211_id, NL80211_CMD_GET_INTERFACE, NLM_F_DUMP);
+    ret = nlraw_transact(fd, &req, station_iface_msg, &list);
+    close(fd);
+    if (ret < 0) {
+      fprintf(stderr, "interface dump: %d %s\n", ret, strerror(-ret));
+      free(list.devs);
+      return ret;
+    }
+    *devs = list.devs;
+    return list.n;
+  }
+
+  for (p = arg; *p; p = *end ? end + 1 : end) {
+    struct station_dev *dev;
+
+    end = strchrnul(p, ',');
+    if (end == p) continue;
+    if (list.n == list.cap) {
+      list.cap = list.cap ? list.cap * 2 : 8;
+      list.devs = realloc(list.devs, list.cap * sizeof(*list.devs));
+      if (list.devs == NULL) return -ENOMEM;
+    }
+    dev = &list.devs[list.n++];
+    memset(dev, 0, sizeof(*dev));
+    dev->fd = -1;
+    dev->wiphy = -1;
+    snprintf(dev->name, sizeof(dev->name), "%.*s", (int)(end - p), p);
+    dev->ifindex = st->links.cap ? link_cache_index(&st->links, dev->name)
+                                 : if_nametoindex(dev->name);
+    if (dev->ifindex == 0) dev->ifindex = -1;
+  }
+  *devs = list.devs;
+  return list.n;
+}
+
+/* -f: the comma separated field names become the mask of what is printed
+ * and decoded; main() adds what the filter, top-N and deltas read. Ifindex
+ * and MAC identify the station and are always kept. */
+static int station_fields_parse(struct nl80211_state *st, const char *arg) {
+  uint64_t fields = STA_BIT(IFINDEX) | STA_BIT(MAC), bits;
+  const char *p, *end;
+
+  for (p = arg; *p; p = *end ? end + 1 : end) {
+    end = strchrnul(p, ',');
+    if (end == p) continue;
+    bits = station_field_bits(p, end - p);
+    if (bits == 0) {
+      fprintf(stderr, "unknown field '%.*s'\n", (int)(end - p), p);
+      return -EINVAL;
+    }
+    fields |= bits;
+  }
+  st->fields = st->decode_fields = fields;
+  return 0;
+}
+
+/* build the GET_STATION request once in place, it is resent on every sample.
+ * A single station request asks for an ACK, which ends it like NLMSG_DONE
+ * ends a dump. */
+static void nl80211_station_req(struct station_dev *dev, int family_id, const uint8_t *mac_addr,
+                                int flags) {
+  struct nlraw_req *req = &dev->req;
+
+  nlraw_req_init(req, family_id, NL80211_CMD_GET_STATION,
+                 flags & NLM_F_DUMP ? flags : flags | NLM_F_ACK);
+
+  // add message attributes, they always fit the request
+  nlraw_req_put_u32(req, NL80211_ATTR_IFINDEX, dev->ifindex);
+  if (mac_addr != NULL) nlraw_req_put(req, NL80211_ATTR_MAC, mac_addr, ETH_ALEN);
+}
+
+static int nl80211_station_send(struct station_dev *dev) {
+  int ret; /* to store returning values */
+
+  dev->seq = nlraw_seq();
+  dev->last_error = 0;
+  ret = nlraw_send(dev->fd, &dev->req, dev->seq);
+  if (ret < 0) fprintf(stderr, "%s: send: %d %s\n", dev->name, ret, strerror(-ret));
+  return (ret);
+}
+
+/* end of a dump round or an event batch: let the formatter finish its output
+ * and write it out in one go */
+static int station_out_flush(struct nl80211_state *st) {
+  struct obuf *ob = &st->out.ob;
+  uint64_t start;
+
+  if (st->ring) { /* the writer thread formats and writes */
+    eventfd_write(st->wake_fd, 1);
+    return 0;
+  }
+  start = stats_start(&st->stats);
+  if (st->out.fmt->flush) st->out.fmt->flush(&st->out);
+  obuf_flush(ob);
+  stats_end(&st->stats, STATS_WRITE, start);
+  /* early flushes of the formatters included */
+  stats_count(&st->stats, STATS_WRITES, ob->writes);
+  stats_count(&st->stats, STATS_BYTES_OUT, ob->written);
+  ob->writes = ob->written = 0;
+  if (ob->err < 0) {
+    fprintf(stderr, "output write failed: %s\n", strerror(-ob->err));
+    return ob->err;
+  }
+  return 0;
+}
+
+/* Everything the process waits for goes through one epoll loop: the dump
+ * sockets, the mlme multicast socket, the rtnetlink neighbour socket and the
+ * watch timer. Nothing blocks, so notifications are handled while a dump is
+ * still coming in and samples of both kinds leave in arrival order. */
+struct station_watch {
+  struct nl80211_state *st;
+  struct evloop loop;
+  struct nlrx rx; /* receive ring shared by all sockets of the loop */
+  struct station_dev *devs;
+  int n;
+  const uint8_t *mac; /* requested station, NULL for dumps */
+  int flags;
+  int quiet_enoent; /* a station looked up on several interfaces */
+  int pending;      /* requests of the current round without final reply */
+  int ret;          /* first error of the last round */
+  uint64_t round_start; /* stats span of the round, 0 if spans are off */
+  unsigned long rounds, count; /* count 0 means until signalled */
+  int done;
+  struct bench_dump *dump; /* bench mode: keep the messages, do not decode */
+  struct evloop_source timer;
+  struct evloop_source ev;    /* nl80211 "mlme" station join/leave notifications */
+  int resync;                 /* notifications were lost, dump now */
+  struct evloop_source neigh; /* fd -1 unless neighbour changes are followed */
+};
+
+static void station_round_start(struct station_watch *w);
+static int station_events_reopen(struct station_watch *w);
+
+/* A family id read from the disk cache may be stale (module reloaded without
+ * a reboot). The kernel answers ENOENT for an unknown family, but nl80211 also
+ * uses ENOENT for an unknown station, so only a fresh controller lookup can
+ * tell them apart. Returns 1 if the id changed and the requests were rebuilt. */
+static int station_ids_refresh(struct station_watch *w) {
+  struct nl80211_state *st = w->st;
+  int i, ret;
+
+  for (i = 0; i < w->n; i++)
+    if (w->devs[i].last_error == ENOENT || w->devs[i].last_error == EOPNOTSUPP) break;
+  if (i == w->n) return 0;
+
+  /* the round is over, nothing else is read from this socket meanwhile */
+  ret = nl80211_ids_refresh(w->devs[0].fd, st->cache_path, &st->ids);
+  if (ret != 1) return ret;
+  st->nl80211_id = st->ids.family_id;
+
+  for (i = 0; i < w->n; i++) nl80211_station_req(&w->devs[i], st->nl80211_id, w->mac, w->flags);
+  /* the "mlme" group id came from the same stale cache */
+  if (w->ev.fd >= 0 && (ret = station_events_reopen(w)) < 0)
+    fprintf(stderr, "station events: %s\n", strerror(-ret));
+  return 1;
+}
+
+/* print what was counted since the last report and start over */
+static void station_stats_report(struct nl80211_state *st) {
+  char label[IF_NAMESIZE + 16];
+
+  snprintf(label, sizeof(label), "%s%sinterval", st->stats_name ? st->stats_name : "",
+           st->stats_name ? " " : "");
+  if (st->stats_last_ns) stats_print(&st->stats, label, stderr);
+  stats_merge(&st->stats_total, &st->stats);
+  stats_reset(&st->stats);
+  st->stats_last_ns = st->sample.boot_ns;
+}
+
+/* the round's top-N, best first; the others never reached the formatter */
+static void station_top_out(struct nl80211_state *st) {
+  uint32_t i, n, offered = st->top.offered;
+  uint64_t start;
+
+  n = station_top_sort(&st->top);
+  stats_count(&st->stats, STATS_FILTERED, offered - n);
+  for (i = 0; i < n; i++) {
+    struct station_sample *s = &st->top.slot[st->top.heap[i]];
+
+    s->present &= st->fields;
+    start = stats_start(&st->stats);
+    st->out.fmt->sample(&st->out, s);
+    stats_end(&st->stats, STATS_FORMAT, start);
+  }
+}
+
+static void station_round_done(struct station_watch *w) {
+  struct nl80211_state *st = w->st;
+  int i;
+
+  for (i = 0; i < w->n; i++) {
+    struct station_dev *dev = &w->devs[i];
+
+    if (dev->ret < 0 && w->ret == 0 && !(w->quiet_enoent && dev->last_error == ENOENT))
+      w->ret = dev->ret;
+  }
+  /* a station of an interface that did not answer is not gone */
+  if (w->ret == 0) {
+    if (st->rates.t.cap) station_rates_expire(&st->rates);
+    if (st->prom.cap) prom_expire(&st->prom);
+  }
+  if (st->top.cap) station_top_out(st);
+  if (station_out_flush(st) < 0 && w->ret == 0) w->ret = st->out.ob.err;
+
+  if (st->ids.from_disk && station_ids_refresh(w) == 1) {
+    station_round_start(w); /* the same round again with the fresh id */
+    return;
+  }
+  stats_end(&st->stats, STATS_ROUND, w->round_start);
+  if (st->stats_period_ns && st->sample.boot_ns - st->stats_last_ns >= st->stats_period_ns)
+    station_stats_report(st);
+  w->rounds++;
+  if (w->count && w->rounds >= w->count) w->done = 1;
+}
+
+/* stamp the round and age the rate table, the requests are up to the caller */
+static void station_round_begin(struct station_watch *w) {
+  struct nl80211_state *st = w->st;
 
-  for (i = 0; i < sizeof nl_attr_map / sizeof nl_attr_map[0]; i++) {
-    if (type == nl_attr_map[i].type) {
-      return nl_attr_map[i].name;
+  station_clock(st, &st->sample);
+  if (st->rates.t.cap) station_rates_round(&st->rates);
+  if (st->prom.cap) prom_round(&st->prom);
+  w->ret = 0;
+  w->round_start = stats_start(&st->stats);
+}
+
+/* the requests in flight, replay matches the recorded replies on them */
+static void station_record_round(struct station_watch *w) {
+  struct capture_req req[w->n];
+  int i, n = 0;
+
+  for (i = 0; i < w->n; i++)
+    if (w->devs[i].pending)
+      req[n++] = (struct capture_req){.ifindex = w->devs[i].ifindex, .seq = w->devs[i].seq};
+  capture_put(&w->st->cap, CAPTURE_ROUND, 0, w->st->sample.now_ms, w->st->sample.boot_ns, req,
+              n * sizeof(*req));
+}
+
+/* Send every request first, the replies are read as they come in: all dumps
+ * are started by the kernel before the first reply is read, so the round
+ * costs one round trip instead of one per interface. Replies are
+ * demultiplexed by socket and matched on the sequence number. */
+static void station_round_start(struct station_watch *w) {
+  struct nl80211_state *st = w->st;
+  int i;
+
+  if (w->pending) return; /* the previous round overran the interval */
+
+  station_round_begin(w);
+  for (i = 0; i < w->n; i++) {
+    uint64_t start = stats_start(&st->stats);
+
+    w->devs[i].ret = nl80211_station_send(&w->devs[i]);
+    stats_end(&st->stats, STATS_SEND, start);
+    stats_count(&st->stats, STATS_SENDS, 1);
+    w->devs[i].pending = w->devs[i].ret >= 0;
+    w->pending += w->devs[i].pending;
+  }
+  if (st->cap.f) station_record_round(w);
+  if (w->pending == 0) station_round_done(w);
+}
+
+/* the request of 'dev' failed with -err, or err is 0 for its ACK */
+static void station_dev_error(struct station_watch *w, struct station_dev *dev, int err) {
+  dev->pending = 0;
+  if (err == 0) return;
+  dev->last_error = -err;
+  dev->ret = err;
+  if (!(w->quiet_enoent && dev->last_error == ENOENT))
+    fprintf(stderr, "%s: %s\n", dev->name, strerror(-err));
+}
+
+/* Walk the messages of one datagram in place. A dump ends with NLMSG_DONE,
+ * a single station request with its ACK, both with NLMSG_ERROR on failure. */
+static void station_dev_msgs(struct station_watch *w, struct station_dev *dev,
+                             const struct nlmsghdr *nlh, int len) {
+  for (; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+    if (!dev->pending || nlh->nlmsg_seq != dev->seq) continue; /* late reply of a past round */
+
+    if (nlh->nlmsg_type == NLMSG_DONE) {
+      dev->pending = 0;
+    } else if (nlh->nlmsg_type == NLMSG_ERROR) {
+      const struct nlmsgerr *e = NLMSG_DATA(nlh);
+
+      station_dev_error(w, dev, nlh->nlmsg_len >= NLMSG_LENGTH(sizeof(*e)) ? e->error : -EPROTO);
+    } else if (nlh->nlmsg_type == w->st->nl80211_id) {
+      if (w->dump == NULL)
+        station_sample_out(w->st, nlh);
+      else if (bench_dump_append(w->dump, nlh) < 0)
+        station_dev_error(w, dev, -ENOMEM);
     }
   }
+}
 
-  return "unknown";
+/* nlrx_recv() with the syscall and the bytes counted */
+static int station_recv(struct station_watch *w, int fd) {
+  struct stats *s = &w->st->stats;
+  uint64_t start = stats_start(s);
+  int i, n = nlrx_recv(&w->rx, fd);
+
+  stats_end(s, STATS_RECV, start);
+  stats_count(s, STATS_RECVS, 1);
+  if (n == -ENOBUFS) stats_count(s, STATS_ENOBUFS, 1);
+  for (i = 0; i < n; i++) stats_count(s, STATS_BYTES_IN, nlrx_len(&w->rx, i));
+  return n;
 }
 
-static int nl_cb_brief(struct nl_msg *msg, void *arg) {
-  struct nlmsghdr *ret_hdr = nlmsg_hdr(msg);
-  struct nlattr *tb_msg[NL80211_ATTR_MAX + 1];
+/* take one batch of what is queued on a dump socket, the rest of a multipart
+ * dump comes with a later wakeup */
+static void station_dev_ready(void *arg) {
+  struct station_dev *dev = arg;
+  struct station_watch *w = dev->w;
+  int was_pending = dev->pending;
+  int i, n = station_recv(w, dev->fd);
+
+  if (n < 0 && dev->pending) station_dev_error(w, dev, n);
+  if (n > 0) stats_count(&w->st->stats, STATS_DATAGRAMS, n);
+  for (i = 0; i < n; i++) {
+    int len = nlrx_len(&w->rx, i);
+
+    if (len == 0 && dev->pending) station_dev_error(w, dev, -EMSGSIZE);
+    if (w->st->cap.f && len)
+      capture_put(&w->st->cap, CAPTURE_DUMP, dev->ifindex, w->st->sample.now_ms,
+                  w->st->sample.boot_ns, nlrx_buf(&w->rx, i), len);
+    station_dev_msgs(w, dev, nlrx_buf(&w->rx, i), len);
+  }
+  if (was_pending && !dev->pending && --w->pending == 0) station_round_done(w);
+}
 
-  if (ret_hdr->nlmsg_type != nl80211State.nl80211_id) return NL_STOP;
-  struct genlmsghdr *gnlh = (struct genlmsghdr *)nlmsg_data(ret_hdr);
-  nla_parse(tb_msg, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), NULL);
+static void station_timer_ready(void *arg) {
+  struct station_watch *w = arg;
 
-  /*
-   *  <------- NLA_HDRLEN ------> <-- NLA_ALIGN(payload)-->
-   * +---------------------+- - -+- - - - - - - - - -+- - -+
-   * |        Header       | Pad |     Payload       | Pad |
-   * |   (struct nlattr)   | ing |                   | ing |
-   * +---------------------+- - -+- - - - - - - - - -+- - -+
-   *  <-------------- nlattr->nla_len -------------->
-   */
+  /* several expirations mean the loop fell behind, one sample catches up */
+  if (evloop_timer_read(w->timer.fd)) station_round_start(w);
+}
 
-  if (tb_msg[NL80211_ATTR_MAC]) {
-    void *p = tb_msg[NL80211_ATTR_MAC];
-    uint8_t *data = p + NLA_HDRLEN;
-    printf("%02X:%02X:%02X:%02X:%02X:%02X\n",
-           data[0], data[1], data[2], data[3], data[4], data[5]);
+/* notifications carry sequence number 0, they are filtered on the
+ * interfaces and the station being polled; st->note is stamped once per
+ * datagram by the caller, a replay gives it the recorded stamp */
+static void station_event_msg(struct station_watch *w, const struct nlmsghdr *nlh) {
+  const struct genlmsghdr *gnlh = NLMSG_DATA(nlh);
+  struct nl80211_state *st = w->st;
+  struct station_sample *sample = &st->note;
+  int i, ret;
+
+  if (nlh->nlmsg_type != st->nl80211_id) return;
+  if (gnlh->cmd != NL80211_CMD_NEW_STATION && gnlh->cmd != NL80211_CMD_DEL_STATION) return;
+
+  /* the station info of a notification is often empty or missing */
+  ret = station_decode(nlh, sample, 0, st->decode_fields);
+  if ((ret < 0 && ret != -ENODATA) || !STA_HAS(sample, IFINDEX) || !STA_HAS(sample, MAC))
+    return;
+  for (i = 0; i < w->n && w->devs[i].ifindex != (int)sample->ifindex; i++)
+    ;
+  if (i == w->n) return;
+  if (w->mac && memcmp(w->mac, sample->mac, ETH_ALEN)) return;
+
+  sample->event = gnlh->cmd;
+  if (st->rates.t.cap) {
+    if (gnlh->cmd == NL80211_CMD_DEL_STATION)
+      station_rates_forget(&st->rates, sample->ifindex, sample->mac);
+    else if (station_rates_update(&st->rates, sample) < 0)
+      fprintf(stderr, "failed to grow the station table!\n");
+  }
+  station_neigh_fill(&st->neigh, sample);
+  if (!station_filter_match(&st->filter, sample)) {
+    stats_count(&st->stats, STATS_FILTERED, 1);
+    return;
   }
+  sample->present &= st->fields;
 
-  return NL_SKIP;
+  station_note_out(st, sample);
 }
-static int nl_cb(struct nl_msg *msg, void *arg) {
-  struct nlmsghdr *ret_hdr = nlmsg_hdr(msg);
-  struct nlattr *tb_msg[NL80211_ATTR_MAX + 1];
-  char *chain;
-  struct timeval now;
-  unsigned long long now_ms;
-  char state_name[10];
-  struct nl80211_sta_flag_update *sta_flags;
 
-  gettimeofday(&now, NULL);
-  now_ms = now.tv_sec * 1000ULL;
-  now_ms += (now.tv_usec / 1000);
+/* nl80211 socket subscribed to the "mlme" multicast group, non-blocking.
+ * Returns the fd or a negative errno. */
+static int station_events_open(struct nl80211_state *st) {
+  struct sockaddr_nl local = {.nl_family = AF_NETLINK};
+  uint64_t start;
+  int fd, ret, grp;
 
-  if (ret_hdr->nlmsg_type != nl80211State.nl80211_id) return NL_STOP;
+  fd = nl80211_open(st);
+  if (fd < 0) return fd;
+
+  start = stats_start(&st->stats);
+  ret = nl80211_ids_mlme(fd, st->cache_path, &st->ids);
+  stats_end(&st->stats, STATS_RESOLVE, start);
+  if (ret < 0) {
+    fprintf(stderr, "mlme group: %d %s\n", ret, strerror(-ret));
+    close(fd);
+    return ret;
+  }
+  grp = st->ids.mlme_grp;
+
+  if (bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0 ||
+      setsockopt(fd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &grp, sizeof(grp)) < 0 ||
+      fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
+    ret = -errno;
+    fprintf(stderr, "mlme group %d: %s\n", grp, strerror(-ret));
+    close(fd);
+    return ret;
+  }
+  return fd;
+}
 
-  struct genlmsghdr *gnlh = (struct genlmsghdr *)nlmsg_data(ret_hdr);
+/* A reloaded nl80211 has another "mlme" group id: leave the old one with its
+ * socket and subscribe a new socket to the group resolved now. Notifications
+ * in between are lost, the caller dumps again right away. */
+static int station_events_reopen(struct station_watch *w) {
+  int ret;
 
-  nla_parse(tb_msg, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), NULL);
+  evloop_del(&w->loop, &w->ev);
+  close(w->ev.fd);
+  w->ev.fd = -1;
+  ret = station_events_open(w->st);
+  if (ret < 0) return ret;
+  nlrx_rcvbuf(ret, NLRX_RCVBUF);
+  w->ev.fd = ret;
+  return evloop_add(&w->loop, &w->ev);
+}
 
-  for (int i = 0; i < NL80211_ATTR_MAX; i++) {
-    if (tb_msg[i] == NULL) continue;
-    printf("attr. type: %d %s\n", tb_msg[i]->nla_type, get_nl_attr_type(tb_msg[i]->nla_type));
+/* Drain everything queued and write the batch. Lost notifications leave the
+ * station state unknown, a dump starts right away. */
+static void station_events_ready(void *arg) {
+  struct station_watch *w = arg;
+  struct nl80211_state *st = w->st;
+  const struct nlmsghdr *nlh;
+  int i, n, len;
+
+  while ((n = station_recv(w, w->ev.fd)) != 0) {
+    if (n < 0) {
+      if (n != -ENOBUFS) break;
+      /* the receive queue overflowed */
+      fprintf(stderr, "station events: %s, dumping\n", strerror(-n));
+      w->resync = 1;
+      continue;
+    }
+    for (i = 0; i < n; i++) {
+      len = nlrx_len(&w->rx, i);
+      station_clock(st, &st->note);
+      if (st->cap.f && len)
+        capture_put(&st->cap, CAPTURE_MLME, 0, st->note.now_ms, st->note.boot_ns,
+                    nlrx_buf(&w->rx, i), len);
+      for (nlh = nlrx_buf(&w->rx, i); NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len))
+        station_event_msg(w, nlh);
+    }
   }
-  /*
-   *  <------- NLA_HDRLEN ------> <-- NLA_ALIGN(payload)-->
-   * +---------------------+- - -+- - - - - - - - - -+- - -+
-   * |        Header       | Pad |     Payload       | Pad |
-   * |   (struct nlattr)   | ing |                   | ing |
-   * +---------------------+- - -+- - - - - - - - - -+- - -+
-   *  <-------------- nlattr->nla_len -------------->
-   */
-  char str[100];
+  station_out_flush(w->st);
 
-  if (tb_msg[NL80211_ATTR_IFINDEX]) {
-    void *p = tb_msg[NL80211_ATTR_IFINDEX];
-    int *data = p + NLA_HDRLEN;
-    if_indextoname(*data, str);
-    printf("dev idx: %d if: %s\n", *data, str);
+  if (w->resync) {
+    w->resync = 0;
+    station_round_start(w);
   }
+}
 
-  if (tb_msg[NL80211_ATTR_MAC]) {
-    void *p = tb_msg[NL80211_ATTR_MAC];
-    uint8_t *data = p + NLA_HDRLEN;
-    printf("mac: %02X:%02X:%02X:%02X:%02X:%02X\n",
-           data[0], data[1], data[2], data[3], data[4], data[5]);
+/* rtnetlink neighbour (ARP/ND) notifications, raw: no libnl cache behind them */
+static int station_neigh_open(void) {
+  struct sockaddr_nl local = {.nl_family = AF_NETLINK, .nl_groups = RTMGRP_NEIGH};
+  int fd, ret;
+
+  fd = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (fd < 0 || bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0) {
+    ret = -errno;
+    fprintf(stderr, "neighbour socket: %s\n", strerror(-ret));
+    if (fd >= 0) close(fd);
+    return ret;
   }
+  return fd;
+}
 
-  if (!tb_msg[NL80211_ATTR_STA_INFO]) {
-    fprintf(stderr, "sta stats missing!\n");
-    return NL_SKIP;
+/* replay sees the dump that (re)loaded the cache, an empty record starts it */
+static int station_neigh_record(const struct nlmsghdr *nh, void *arg) {
+  struct nl80211_state *st = arg;
+
+  capture_put(&st->cap, CAPTURE_NEIGH_DUMP, 0, st->note.now_ms, st->note.boot_ns, nh,
+              nh->nlmsg_len);
+  return 0;
+}
+
+/* (Re)load the neighbour cache from an RTM_GETNEIGH dump, over a socket of
+ * its own: the notification socket is bound first, so what changes during
+ * the dump is queued there and applied afterwards. */
+static int station_neigh_load(struct nl80211_state *st) {
+  int fd, ret;
+
+  if (st->neigh.cap == 0) {
+    ret = neigh_cache_init(&st->neigh, 256);
+    if (ret < 0) return ret;
   }
-  if (nla_parse_nested(tb_msg, NL80211_STA_INFO_MAX,
-                       tb_msg[NL80211_ATTR_STA_INFO],
-                       stats_policy)) {
-    fprintf(stderr, "failed to parse nested attributes!\n");
-    return NL_SKIP;
-  }
-
-  if (tb_msg[NL80211_STA_INFO_INACTIVE_TIME])
-    printf("\n\tinactive time:\t%u ms",
-           nla_get_u32(tb_msg[NL80211_STA_INFO_INACTIVE_TIME]));
-  if (tb_msg[NL80211_STA_INFO_RX_BYTES64])
-    printf("\n\trx bytes:\t%llu",
-           (unsigned long long)nla_get_u64(tb_msg[NL80211_STA_INFO_RX_BYTES64]));
-  else if (tb_msg[NL80211_STA_INFO_RX_BYTES])
-    printf("\n\trx bytes:\t%u",
-           nla_get_u32(tb_msg[NL80211_STA_INFO_RX_BYTES]));
-  if (tb_msg[NL80211_STA_INFO_RX_PACKETS])
-    printf("\n\trx packets:\t%u",
-           nla_get_u32(tb_msg[NL80211_STA_INFO_RX_PACKETS]));
-  if (tb_msg[NL80211_STA_INFO_TX_BYTES64])
-    printf("\n\ttx bytes:\t%llu",
-           (unsigned long long)nla_get_u64(tb_msg[NL80211_STA_INFO_TX_BYTES64]));
-  else if (tb_msg[NL80211_STA_INFO_TX_BYTES])
-    printf("\n\ttx bytes:\t%u",
-           nla_get_u32(tb_msg[NL80211_STA_INFO_TX_BYTES]));
-  if (tb_msg[NL80211_STA_INFO_TX_PACKETS])
-    printf("\n\ttx packets:\t%u",
-           nla_get_u32(tb_msg[NL80211_STA_INFO_TX_PACKETS]));
-  if (tb_msg[NL80211_STA_INFO_TX_RETRIES])
-    printf("\n\ttx retries:\t%u",
-           nla_get_u32(tb_msg[NL80211_STA_INFO_TX_RETRIES]));
-  if (tb_msg[NL80211_STA_INFO_TX_FAILED])
-    printf("\n\ttx failed:\t%u",
-           nla_get_u32(tb_msg[NL80211_STA_INFO_TX_FAILED]));
-  if (tb_msg[NL80211_STA_INFO_BEACON_LOSS])
-    printf("\n\tbeacon loss:\t%u",
-           nla_get_u32(tb_msg[NL80211_STA_INFO_BEACON_LOSS]));
-  if (tb_msg[NL80211_STA_INFO_BEACON_RX])
-    printf("\n\tbeacon rx:\t%llu",
-           (unsigned long long)nla_get_u64(tb_msg[NL80211_STA_INFO_BEACON_RX]));
-  if (tb_msg[NL80211_STA_INFO_RX_DROP_MISC])
-    printf("\n\trx drop misc:\t%llu",
-           (unsigned long long)nla_get_u64(tb_msg[NL80211_STA_INFO_RX_DROP_MISC]));
-
-  chain = get_chain_signal(tb_msg[NL80211_STA_INFO_CHAIN_SIGNAL]);
-  if (tb_msg[NL80211_STA_INFO_SIGNAL])
-    printf("\n\tsignal:  \t%d %sdBm",
-           (int8_t)nla_get_u8(tb_msg[NL80211_STA_INFO_SIGNAL]),
-           chain);
-
-  chain = get_chain_signal(tb_msg[NL80211_STA_INFO_CHAIN_SIGNAL_AVG]);
-  if (tb_msg[NL80211_STA_INFO_SIGNAL_AVG])
-    printf("\n\tsignal avg:\t%d %sdBm",
-           (int8_t)nla_get_u8(tb_msg[NL80211_STA_INFO_SIGNAL_AVG]),
-           chain);
-
-  if (tb_msg[NL80211_STA_INFO_BEACON_SIGNAL_AVG])
-    printf("\n\tbeacon signal avg:\t%d dBm",
-           (int8_t)nla_get_u8(tb_msg[NL80211_STA_INFO_BEACON_SIGNAL_AVG]));
-  if (tb_msg[NL80211_STA_INFO_T_OFFSET])
-    printf("\n\tToffset:\t%llu us",
-           (unsigned long long)nla_get_u64(tb_msg[NL80211_STA_INFO_T_OFFSET]));
-
-  if (tb_msg[NL80211_STA_INFO_TX_BITRATE]) {
-    char buf[100];
-
-    parse_bitrate(tb_msg[NL80211_STA_INFO_TX_BITRATE], buf, sizeof(buf));
-    printf("\n\ttx bitrate:\t%s", buf);
-  }
-
-  if (tb_msg[NL80211_STA_INFO_TX_DURATION])
-    printf("\n\ttx duration:\t%lld us",
-           (unsigned long long)nla_get_u64(tb_msg[NL80211_STA_INFO_TX_DURATION]));
-
-  if (tb_msg[NL80211_STA_INFO_RX_BITRATE]) {
-    char buf[100];
-
-    parse_bitrate(tb_msg[NL80211_STA_INFO_RX_BITRATE], buf, sizeof(buf));
-    printf("\n\trx bitrate:\t%s", buf);
-  }
-
-  if (tb_msg[NL80211_STA_INFO_RX_DURATION])
-    printf("\n\trx duration:\t%lld us",
-           (unsigned long long)nla_get_u64(tb_msg[NL80211_STA_INFO_RX_DURATION]));
-
-  if (tb_msg[NL80211_STA_INFO_ACK_SIGNAL])
-    printf("\n\tlast ack signal:%d dBm",
-           (int8_t)nla_get_u8(tb_msg[NL80211_STA_INFO_ACK_SIGNAL]));
-
-  if (tb_msg[NL80211_STA_INFO_ACK_SIGNAL_AVG])
-    printf("\n\tavg ack signal:\t%d dBm",
-           (int8_t)nla_get_u8(tb_msg[NL80211_STA_INFO_ACK_SIGNAL_AVG]));
-
-  if (tb_msg[NL80211_STA_INFO_AIRTIME_WEIGHT]) {
-    printf("\n\tairtime weight: %d", nla_get_u16(tb_msg[NL80211_STA_INFO_AIRTIME_WEIGHT]));
-  }
-
-  if (tb_msg[NL80211_STA_INFO_EXPECTED_THROUGHPUT]) {
-    uint32_t thr;
-
-    thr = nla_get_u32(tb_msg[NL80211_STA_INFO_EXPECTED_THROUGHPUT]);
-    /* convert in Mbps but scale by 1000 to save kbps units */
-    thr = thr * 1000 / 1024;
-
-    printf("\n\texpected throughput:\t%u.%uMbps",
-           thr / 1000, thr % 1000);
-  }
-
-  if (tb_msg[NL80211_STA_INFO_LLID])
-    printf("\n\tmesh llid:\t%d",
-           nla_get_u16(tb_msg[NL80211_STA_INFO_LLID]));
-  if (tb_msg[NL80211_STA_INFO_PLID])
-    printf("\n\tmesh plid:\t%d",
-           nla_get_u16(tb_msg[NL80211_STA_INFO_PLID]));
-  if (tb_msg[NL80211_STA_INFO_PLINK_STATE]) {
-    switch (nla_get_u8(tb_msg[NL80211_STA_INFO_PLINK_STATE])) {
-    case LISTEN:
-      strcpy(state_name, "LISTEN");
-      break;
-    case OPN_SNT:
-      strcpy(state_name, "OPN_SNT");
-      break;
-    case OPN_RCVD:
-      strcpy(state_name, "OPN_RCVD");
-      break;
-    case CNF_RCVD:
-      strcpy(state_name, "CNF_RCVD");
-      break;
-    case ESTAB:
-      strcpy(state_name, "ESTAB");
-      break;
-    case HOLDING:
-      strcpy(state_name, "HOLDING");
-      break;
-    case BLOCKED:
-      strcpy(state_name, "BLOCKED");
-      break;
-    default:
-      strcpy(state_name, "UNKNOWN");
+  neigh_cache_clear(&st->neigh);
+  fd = nlraw_open(NETLINK_ROUTE);
+  if (fd < 0) {
+    ret = fd;
+  } else {
+    if (st->cap.f) {
+      station_clock(st, &st->note);
+      capture_put(&st->cap, CAPTURE_NEIGH_DUMP, 0, st->note.now_ms, st->note.boot_ns, NULL, 0);
+    }
+    ret = neigh_cache_dump(&st->neigh, fd, st->cap.f ? station_neigh_record : NULL, st);
+    close(fd);
+  }
+  if (ret < 0) fprintf(stderr, "neighbour dump: %s\n", strerror(-ret));
+  return ret;
+}
+
+/* A neighbour entry changed (resolved, went stale, failed or was deleted):
+ * the cache follows it, and if it is one of our stations a record goes out.
+ * The entry hangs off the bridge or routed interface, the station is found
+ * by its MAC on the polled interfaces. */
+static void station_neigh_msg(struct station_watch *w, const struct nlmsghdr *nh) {
+  struct nl80211_state *st = w->st;
+  struct station_sample *sample = &st->note;
+  struct neigh_msg m;
+  int i;
+
+  if (neigh_decode(nh, &m) < 0) return;
+  if (st->neigh.cap && neigh_cache_update(&st->neigh, &m) < 0)
+    fprintf(stderr, "failed to grow the neighbour cache!\n");
+  if (m.lladdr == NULL) return;
+  if (w->mac && memcmp(w->mac, m.lladdr, ETH_ALEN)) return;
+
+  for (i = 0; i < w->n; i++)
+    if (station_table_find(&st->rates.t, w->devs[i].ifindex,
+                           station_table_mac(m.lladdr)) >= 0)
       break;
+  if (i == w->n) return;
+
+  sample->present = STA_BIT(IFINDEX) | STA_BIT(MAC);
+  sample->ifindex = w->devs[i].ifindex;
+  memcpy(sample->mac, m.lladdr, ETH_ALEN);
+  sample->nattrs = 0;
+  sample->ntids = 0;
+  sample->event = m.type;
+  station_neigh_fill(&st->neigh, sample);
+  if (!station_filter_match(&st->filter, sample)) {
+    stats_count(&st->stats, STATS_FILTERED, 1);
+    return;
+  }
+  sample->present &= st->fields;
+  station_note_out(st, sample);
+}
+
+static void station_neigh_ready(void *arg) {
+  struct station_watch *w = arg;
+  struct nl80211_state *st = w->st;
+  const struct nlmsghdr *nh;
+  int i, n, len, reload = 0;
+
+  while ((n = station_recv(w, w->neigh.fd)) != 0) {
+    if (n < 0) {
+      if (n != -ENOBUFS) break;
+      /* the kernel dropped notifications, the cache may miss some */
+      fprintf(stderr, "neighbour events: %s, reloading\n", strerror(-n));
+      reload = 1;
+      continue;
     }
-    printf("\n\tmesh plink:\t%s", state_name);
-  }
-  if (tb_msg[NL80211_STA_INFO_AIRTIME_LINK_METRIC])
-    printf("\n\tmesh airtime link metric: %d",
-           nla_get_u32(tb_msg[NL80211_STA_INFO_AIRTIME_LINK_METRIC]));
-  if (tb_msg[NL80211_STA_INFO_CONNECTED_TO_GATE])
-    printf("\n\tmesh connected to gate:\t%s",
-           nla_get_u8(tb_msg[NL80211_STA_INFO_CONNECTED_TO_GATE]) ? "yes" : "no");
-  if (tb_msg[NL80211_STA_INFO_CONNECTED_TO_AS])
-    printf("\n\tmesh connected to auth server:\t%s",
-           nla_get_u8(tb_msg[NL80211_STA_INFO_CONNECTED_TO_AS]) ? "yes" : "no");
-
-  if (tb_msg[NL80211_STA_INFO_LOCAL_PM]) {
-    printf("\n\tmesh local PS mode:\t");
-    print_power_mode(tb_msg[NL80211_STA_INFO_LOCAL_PM]);
-  }
-  if (tb_msg[NL80211_STA_INFO_PEER_PM]) {
-    printf("\n\tmesh peer PS mode:\t");
-    print_power_mode(tb_msg[NL80211_STA_INFO_PEER_PM]);
-  }
-  if (tb_msg[NL80211_STA_INFO_NONPEER_PM]) {
-    printf("\n\tmesh non-peer PS mode:\t");
-    print_power_mode(tb_msg[NL80211_STA_INFO_NONPEER_PM]);
-  }
-
-  if (tb_msg[NL80211_STA_INFO_STA_FLAGS]) {
-    sta_flags = (struct nl80211_sta_flag_update *)
-        nla_data(tb_msg[NL80211_STA_INFO_STA_FLAGS]);
-
-    if (sta_flags->mask & NL80211_STA_FLAG_AUTHORIZED) {
-      printf("\n\tauthorized:\t");
-      if (sta_flags->set & NL80211_STA_FLAG_AUTHORIZED)
-        printf("yes");
-      else
-        printf("no");
+    for (i = 0; i < n; i++) {
+      len = nlrx_len(&w->rx, i);
+      station_clock(st, &st->note);
+      if (st->cap.f && len)
+        capture_put(&st->cap, CAPTURE_NEIGH, 0, st->note.now_ms, st->note.boot_ns,
+                    nlrx_buf(&w->rx, i), len);
+      for (nh = nlrx_buf(&w->rx, i); NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len))
+        station_neigh_msg(w, nh);
     }
+  }
+  station_out_flush(w->st);
+  if (reload) station_neigh_load(st);
+}
 
-    if (sta_flags->mask & NL80211_STA_FLAG_AUTHENTICATED) {
-      printf("\n\tauthenticated:\t");
-      if (sta_flags->set & NL80211_STA_FLAG_AUTHENTICATED)
-        printf("yes");
-      else
-        printf("no");
+/* (Re)load the interface names from an RTM_GETLINK dump, over a socket of
+ * its own like the neighbour cache. */
+static int station_links_load(struct nl80211_state *st) {
+  int fd, ret;
+
+  link_cache_clear(&st->links);
+  fd = nlraw_open(NETLINK_ROUTE);
+  if (fd < 0) return fd;
+  ret = link_cache_dump(&st->links, fd);
+  close(fd);
+  return ret;
+}
+
+/* An interface appeared, was renamed or went away. Not tied to a watch: in
+ * worker mode the writer thread follows them, as it formats the samples. */
+static void station_links_ready(void *arg) {
+  struct nl80211_state *st = arg;
+  char buf[NLRX_BUFSIZE];
+  const struct nlmsghdr *nh;
+  struct link_msg m;
+  int len, reload = 0;
+
+  while ((len = recv(st->links_src.fd, buf, sizeof(buf), MSG_DONTWAIT)) != 0) {
+    if (len < 0) {
+      if (errno == EINTR) continue;
+      if (errno != ENOBUFS) break;
+      stats_count(&st->stats, STATS_ENOBUFS, 1);
+      reload = 1;
+      continue;
     }
+    stats_count(&st->stats, STATS_RECVS, 1);
+    stats_count(&st->stats, STATS_BYTES_IN, len);
+    for (nh = (const struct nlmsghdr *)buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len))
+      if (link_decode(nh, &m) == 0 && link_cache_update(&st->links, &m) < 0)
+        fprintf(stderr, "failed to grow the interface cache!\n");
+  }
+  /* renames were lost, ask again */
+  if (reload && station_links_load(st) < 0) fprintf(stderr, "interface dump failed\n");
+}
 
-    if (sta_flags->mask & NL80211_STA_FLAG_ASSOCIATED) {
-      printf("\n\tassociated:\t");
-      if (sta_flags->set & NL80211_STA_FLAG_ASSOCIATED)
-        printf("yes");
-      else
-        printf("no");
+/* Interface names come from one RTM_GETLINK dump and, with 'follow', from
+ * link notifications after it, so formatting a sample makes no syscall.
+ * Without the cache the formatters fall back to if_indextoname(). */
+static int station_links_open(struct nl80211_state *st, int follow) {
+  struct sockaddr_nl local = {.nl_family = AF_NETLINK, .nl_groups = RTMGRP_LINK};
+  int fd = -1, ret;
+
+  st->links_src.fd = -1;
+  /* subscribed first: a rename during the dump waits on 'fd' */
+  if (follow) {
+    fd = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0) {
+      ret = -errno;
+      goto fail;
     }
+  }
+  ret = link_cache_init(&st->links, 64);
+  if (ret == 0) ret = station_links_load(st);
+  if (ret < 0) goto fail;
+  st->links_src = (struct evloop_source){.fd = fd, .ready = station_links_ready, .arg = st};
+  st->out.links = &st->links;
+  return 0;
+
+fail:
+  fprintf(stderr, "interface names: %s\n", strerror(-ret));
+  if (fd >= 0) close(fd);
+  link_cache_free(&st->links);
+  return ret;
+}
 
-    if (sta_flags->mask & NL80211_STA_FLAG_SHORT_PREAMBLE) {
-      printf("\n\tpreamble:\t");
-      if (sta_flags->set & NL80211_STA_FLAG_SHORT_PREAMBLE)
-        printf("short");
-      else
-        printf("long");
+static void station_links_close(struct nl80211_state *st) {
+  if (st->links_src.fd >= 0) close(st->links_src.fd);
+  st->links_src.fd = -1;
+  st->out.links = NULL;
+  link_cache_free(&st->links);
+}
+
+/* One scrape, answered from the stored values. The loop waits meanwhile,
+ * for the render and a slow client at most PROM_CLIENT_TIMEOUT_MS in all;
+ * dump replies queue up in the socket buffers. */
+static void station_serve_ready(void *arg) {
+  struct nl80211_state *st = arg;
+  struct obuf *ob = &st->prom.ob;
+  uint64_t start = stats_start(&st->stats);
+  int ret = prom_serve(&st->prom, st->serve.fd);
+
+  if (ret == 0) return;
+  stats_end(&st->stats, STATS_SCRAPE, start);
+  stats_count(&st->stats, STATS_WRITES, ob->writes);
+  stats_count(&st->stats, STATS_BYTES_OUT, ob->written);
+  ob->writes = ob->written = 0;
+  if (ret < 0) fprintf(stderr, "scrape: %s\n", strerror(-ret));
+}
+
+static int station_serve_open(struct nl80211_state *st, const char *spec) {
+  int ret = prom_listen(spec);
+
+  if (ret < 0) {
+    fprintf(stderr, "serve %s: %s\n", spec, strerror(-ret));
+    return ret;
+  }
+  st->serve = (struct evloop_source){.fd = ret, .ready = station_serve_ready, .arg = st};
+  ret = prom_init(&st->prom, 64);
+  if (ret < 0) {
+    fprintf(stderr, "failed to allocate the exporter table!\n");
+    close(st->serve.fd);
+    return ret;
+  }
+  /* a scraper that hangs up makes the write fail, not the process */
+  signal(SIGPIPE, SIG_IGN);
+  return 0;
+}
+
+static void station_serve_close(struct nl80211_state *st) {
+  if (st->prom.cap == 0) return;
+  close(st->serve.fd);
+  prom_free(&st->prom);
+}
+
+/* Run rounds until the sample count is reached or a signal arrives. The stop
+ * signals are let in only while the loop waits, one that comes right after
+ * the flag was checked ends that wait instead of being noticed after the
+ * next event. */
+static void station_watch_run(struct station_watch *w) {
+  sigset_t block, old;
+
+  sigemptyset(&block);
+  sigaddset(&block, SIGINT);
+  sigaddset(&block, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &block, &old);
+  w->loop.wait_mask = &old;
+  station_round_start(w);
+  while (!stop_requested && !w->done) {
+    int ret = evloop_run_once(&w->loop, -1);
+
+    if (ret < 0) {
+      fprintf(stderr, "epoll_wait: %s\n", strerror(-ret));
+      break;
     }
+  }
+  w->loop.wait_mask = NULL;
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+}
 
-    if (sta_flags->mask & NL80211_STA_FLAG_WME) {
-      printf("\n\tWMM/WME:\t");
-      if (sta_flags->set & NL80211_STA_FLAG_WME)
-        printf("yes");
-      else
-        printf("no");
+static void station_devs_close(struct station_dev *devs, int n) {
+  int i;
+
+  for (i = 0; i < n; i++)
+    if (devs[i].fd >= 0) close(devs[i].fd);
+  free(devs);
+}
+
+static void station_watch_close(struct station_watch *w) {
+  if (w->neigh.fd >= 0) close(w->neigh.fd);
+  neigh_cache_free(&w->st->neigh);
+  if (w->timer.fd >= 0) close(w->timer.fd);
+  if (w->ev.fd >= 0) close(w->ev.fd);
+  w->timer.fd = w->ev.fd = w->neigh.fd = -1;
+  evloop_free(&w->loop);
+  nlrx_free(&w->rx);
+}
+
+/* register the sources of the requested mode, the dump sockets always */
+static int station_watch_open(struct station_watch *w, unsigned interval_ms, int events,
+                              int neigh) {
+  int i, ret;
+
+  w->timer.fd = w->ev.fd = w->neigh.fd = -1;
+  ret = evloop_init(&w->loop);
+  if (ret < 0) return ret;
+  ret = nlrx_init(&w->rx, NLRX_NBUF, NLRX_BUFSIZE);
+  if (ret < 0) goto fail;
+
+  for (i = 0; i < w->n; i++) {
+    struct station_dev *dev = &w->devs[i];
+
+    if (fcntl(dev->fd, F_SETFL, O_NONBLOCK) < 0) {
+      ret = -errno;
+      goto fail;
     }
+    /* the whole dump can be queued while the loop is busy elsewhere */
+    nlrx_rcvbuf(dev->fd, NLRX_RCVBUF);
+    dev->w = w;
+    dev->src = (struct evloop_source){.fd = dev->fd, .ready = station_dev_ready, .arg = dev};
+    ret = evloop_add(&w->loop, &dev->src);
+    if (ret < 0) goto fail;
+  }
 
-    if (sta_flags->mask & NL80211_STA_FLAG_MFP) {
-      printf("\n\tMFP:\t\t");
-      if (sta_flags->set & NL80211_STA_FLAG_MFP)
-        printf("yes");
-      else
-        printf("no");
+  if (interval_ms) {
+    ret = evloop_timer_open(interval_ms);
+    if (ret < 0) goto fail;
+    w->timer = (struct evloop_source){.fd = ret, .ready = station_timer_ready, .arg = w};
+    ret = evloop_add(&w->loop, &w->timer);
+    if (ret < 0) goto fail;
+  }
+
+  /* subscribe before the first dump, a station joining in between would be
+   * missed otherwise */
+  if (events) {
+    ret = station_events_open(w->st);
+    if (ret < 0) goto fail;
+    nlrx_rcvbuf(ret, NLRX_RCVBUF); /* association storms overflow the default */
+    w->ev = (struct evloop_source){.fd = ret, .ready = station_events_ready, .arg = w};
+    ret = evloop_add(&w->loop, &w->ev);
+    if (ret < 0) goto fail;
+  }
+
+  if (neigh) {
+    ret = station_neigh_open();
+    if (ret < 0) goto fail;
+    nlrx_rcvbuf(ret, NLRX_RCVBUF);
+    w->neigh = (struct evloop_source){.fd = ret, .ready = station_neigh_ready, .arg = w};
+    ret = evloop_add(&w->loop, &w->neigh);
+    if (ret < 0) goto fail;
+    ret = station_neigh_load(w->st);
+    if (ret < 0) goto fail;
+  }
+  return 0;
+
+fail:
+  fprintf(stderr, "event loop: %s\n", strerror(-ret));
+  station_watch_close(w);
+  return ret;
+}
+
+/* worker mode: a radio serves all its interfaces one after the other, so one
+ * poll thread per wiphy has no reason to wait for another */
+#define WORKER_RING_SLOTS 2048 /* samples in flight per worker, a busy radio's dump */
+
+struct station_worker {
+  struct nl80211_state st; /* own ids copy, decode buffers and counters */
+  struct station_watch w;  /* own sockets, loop and timer */
+  struct spsc ring;        /* to the writer thread */
+  struct evloop_source stop;
+  pthread_t tid;
+  atomic_int finished; /* the last sample is published */
+  int drained;         /* writer side: finished and emptied */
+};
+
+struct station_writer {
+  struct nl80211_state *st;
+  struct station_worker *wk;
+  int n, running;
+};
+
+/* interfaces given by name do not know their radio yet */
+static int station_devs_wiphy(struct nl80211_state *st, struct station_dev *devs, int n) {
+  struct station_dev *all = NULL;
+  int i, j, nall;
+
+  for (i = 0; i < n && devs[i].wiphy >= 0; i++)
+    ;
+  if (i == n) return 0;
+  nall = station_devs_parse(st, "all", &all);
+  if (nall < 0) return nall;
+  for (i = 0; i < n; i++)
+    for (j = 0; j < nall; j++)
+      if (all[j].ifindex == devs[i].ifindex) devs[i].wiphy = all[j].wiphy;
+  free(all);
+  return 0;
+}
+
+static int station_dev_cmp(const void *a, const void *b) {
+  const struct station_dev *x = a, *y = b;
+
+  if (x->wiphy != y->wiphy) return x->wiphy < y->wiphy ? -1 : 1;
+  return x->ifindex < y->ifindex ? -1 : x->ifindex > y->ifindex;
+}
+
+static void station_worker_stop(void *arg) {
+  struct station_worker *wk = arg;
+
+  wk->w.done = 1; /* the eventfd stays readable, every worker sees it */
+}
+
+static void *station_worker_run(void *arg) {
+  struct station_worker *wk = arg;
+
+  station_watch_run(&wk->w);
+  atomic_store_explicit(&wk->finished, 1, memory_order_release);
+  station_out_flush(&wk->st); /* wake the writer */
+  return NULL;
+}
+
+/* format everything the workers published, one write for the whole batch */
+static void station_writer_ready(void *arg) {
+  struct station_writer *wr = arg;
+  struct station_out *out = &wr->st->out;
+  const struct station_sample *s;
+  eventfd_t v;
+  int i;
+
+  eventfd_read(wr->st->wake_fd, &v);
+  for (i = 0; i < wr->n; i++) {
+    struct station_worker *wk = &wr->wk[i];
+    /* read before draining: whatever it published before finishing is seen */
+    int finished = atomic_load_explicit(&wk->finished, memory_order_acquire);
+
+    while ((s = spsc_peek(&wk->ring)) != NULL) {
+      uint64_t start = stats_start(&wr->st->stats);
+
+      out->fmt->sample(out, s);
+      stats_end(&wr->st->stats, STATS_FORMAT, start);
+      spsc_release(&wk->ring);
+    }
+    if (finished && !wk->drained) {
+      wk->drained = 1;
+      wr->running--;
+    }
+  }
+  station_out_flush(wr->st);
+}
+
+static void station_workers_free(struct station_worker *wk, int n) {
+  int i;
+
+  for (i = 0; i < n; i++) {
+    station_watch_close(&wk[i].w);
+    station_rates_free(&wk[i].st.rates);
+    spsc_free(&wk[i].ring);
+  }
+  free(wk);
+}
+
+/* worker i runs on CPU i + 1, the writer keeps CPU 0 when there are enough */
+static void station_worker_attr(pthread_attr_t *attr, int i) {
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  cpu_set_t cpus;
+
+  pthread_attr_init(attr);
+  if (ncpu < 2) return;
+  CPU_ZERO(&cpus);
+  CPU_SET((i + 1) % ncpu, &cpus);
+  pthread_attr_setaffinity_np(attr, sizeof(cpus), &cpus);
+}
+
+/* One poll thread per wiphy, each with the sockets of its interfaces, and the
+ * calling thread as the only writer. Workers never wait for each other or
+ * for output; when the writer falls behind a full ring drops samples. */
+static int station_workers_run(struct nl80211_state *st, const struct station_watch *tmpl,
+                               unsigned interval_ms, int events, int neigh) {
+  struct station_writer wr = {.st = st};
+  struct evloop loop = {.epfd = -1};
+  struct evloop_source wake;
+  struct station_worker *wk;
+  int i, j, nw = 0, started = 0, stop_fd, ret;
+  sigset_t block, old;
+
+  ret = station_devs_wiphy(st, tmpl->devs, tmpl->n);
+  if (ret < 0) return ret;
+  qsort(tmpl->devs, tmpl->n, sizeof(*tmpl->devs), station_dev_cmp);
+  for (i = 0; i < tmpl->n; i++)
+    nw += i == 0 || tmpl->devs[i].wiphy < 0 || tmpl->devs[i].wiphy != tmpl->devs[i - 1].wiphy;
+
+  wk = aligned_alloc(_Alignof(struct station_worker), nw * sizeof(*wk));
+  st->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wk == NULL || st->wake_fd < 0 || stop_fd < 0) {
+    ret = wk == NULL ? -ENOMEM : -errno;
+    goto out;
+  }
+  memset(wk, 0, nw * sizeof(*wk));
+
+  for (i = j = 0; i < nw; i++) {
+    struct station_worker *k = &wk[i];
+    int first = j;
+
+    /* the interfaces of one radio, or a single interface of an unknown one */
+    for (j++; j < tmpl->n && tmpl->devs[j].wiphy >= 0 &&
+              tmpl->devs[j].wiphy == tmpl->devs[first].wiphy; j++)
+      ;
+    k->st.nl80211_id = st->nl80211_id;
+    k->st.ids = st->ids;
+    k->st.cache_path = st->cache_path;
+    k->st.out.verbose = st->out.verbose;
+    k->st.fields = st->fields;
+    k->st.decode_fields = st->decode_fields;
+    k->st.filter = st->filter;
+    k->st.ring = &k->ring;
+    k->st.wake_fd = st->wake_fd;
+    k->st.stats.on = st->stats.on;
+    k->st.stats_period_ns = st->stats_period_ns;
+    k->st.stats_name = tmpl->devs[first].name;
+    k->w = *tmpl;
+    k->w.st = &k->st;
+    k->w.devs = &tmpl->devs[first];
+    k->w.n = j - first;
+    k->w.timer.fd = k->w.ev.fd = k->w.neigh.fd = -1;
+    k->w.loop.epfd = -1;
+    ret = spsc_init(&k->ring, WORKER_RING_SLOTS, sizeof(struct station_sample));
+    if (ret == 0) ret = station_rates_init(&k->st.rates, 64 * k->w.n);
+    if (ret == 0) ret = station_watch_open(&k->w, interval_ms, events, neigh);
+    if (ret < 0) {
+      nw = i + 1;
+      goto out;
     }
+    k->stop = (struct evloop_source){.fd = stop_fd, .ready = station_worker_stop, .arg = k};
+    ret = evloop_add(&k->w.loop, &k->stop);
+    if (ret < 0) {
+      nw = i + 1;
+      goto out;
+    }
+  }
 
-    if (sta_flags->mask & NL80211_STA_FLAG_TDLS_PEER) {
-      printf("\n\tTDLS peer:\t");
-      if (sta_flags->set & NL80211_STA_FLAG_TDLS_PEER)
-        printf("yes");
+  wr.wk = wk;
+  wr.n = wr.running = nw;
+  wake = (struct evloop_source){.fd = st->wake_fd, .ready = station_writer_ready, .arg = &wr};
+  ret = evloop_init(&loop);
+  if (ret == 0) ret = evloop_add(&loop, &wake);
+  if (ret == 0 && st->links_src.fd >= 0) ret = evloop_add(&loop, &st->links_src);
+  if (ret < 0) goto out;
+
+  /* signals are for the writer, it tells the workers; the writer lets them
+   * in only while it waits, like station_watch_run() */
+  signal(SIGINT, on_stop_signal);
+  signal(SIGTERM, on_stop_signal);
+  sigemptyset(&block);
+  sigaddset(&block, SIGINT);
+  sigaddset(&block, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &block, &old);
+  for (; started < nw; started++) {
+    pthread_attr_t attr;
+
+    station_worker_attr(&attr, started);
+    ret = -pthread_create(&wk[started].tid, &attr, station_worker_run, &wk[started]);
+    pthread_attr_destroy(&attr);
+    if (ret < 0) {
+      fprintf(stderr, "worker thread: %s\n", strerror(-ret));
+      break;
+    }
+  }
+
+  /* a worker that could not start ends the run */
+  loop.wait_mask = &old;
+  while (started == nw && wr.running > 0) {
+    if (stop_requested) eventfd_write(stop_fd, 1);
+    ret = evloop_run_once(&loop, -1);
+    if (ret < 0) {
+      fprintf(stderr, "epoll_wait: %s\n", strerror(-ret));
+      break;
+    }
+  }
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+  eventfd_write(stop_fd, 1);
+  for (i = 0; i < started; i++) pthread_join(wk[i].tid, NULL);
+  station_writer_ready(&wr);
+
+  for (i = 0; i < nw; i++) {
+    struct stats *s = &wk[i].st.stats_total;
+
+    stats_merge(s, &wk[i].st.stats);
+    if (s->count[STATS_DROPPED])
+      fprintf(stderr, "%s: %llu samples dropped, the writer fell behind\n", wk[i].w.devs[0].name,
+              (unsigned long long)s->count[STATS_DROPPED]);
+    stats_merge(&st->stats_total, s);
+  }
+  ret = ret < 0 ? ret : 0;
+
+out:
+  evloop_free(&loop);
+  if (wk) station_workers_free(wk, nw);
+  if (stop_fd >= 0) close(stop_fd);
+  if (st->wake_fd >= 0) close(st->wake_fd);
+  return ret;
+}
+
+/* bench, stress and stress -w over one recorded dump */
+static int station_bench(struct nl80211_state *st, const struct bench_dump *dump, unsigned bench,
+                         unsigned threads, int workers) {
+  int ret;
+
+  if (threads && workers)
+    ret = bench_pipeline(dump, threads, bench ? bench : STRESS_ITERATIONS, st->out.fmt,
+                         st->out.verbose, stdout);
+  else if (threads)
+    ret = bench_threads(dump, threads, bench ? bench : STRESS_ITERATIONS, st->out.fmt,
+                        st->out.verbose, stdout);
+  else
+    ret = bench_decode(dump, bench, st->decode_fields, stdout);
+  if (ret == -ENODATA) fprintf(stderr, "no stations to benchmark\n");
+  return ret;
+}
+
+/* Benchmark generated dumps of every size in the comma separated 'sizes', no
+ * device needed. With stress <n> the thread benchmarks run on them instead. */
+static int station_synth(struct nl80211_state *st, const char *sizes, const char *mix,
+                         unsigned bench, unsigned threads, int workers) {
+  struct synth_cfg cfg = {.family_id = GENL_MIN_ID, .ifindex = 1};
+  const char *p = sizes;
+  char *end;
+  int ret = 0;
+
+  if (synth_mix(&cfg, mix) < 0) {
+    fprintf(stderr, "unknown attribute mix '%s'\n", mix);
+    return -EINVAL;
+  }
+  while (ret == 0 && *p) {
+    struct bench_dump d = {};
+    unsigned long n = strtoul(p, &end, 10);
+    unsigned iterations;
+
+    if (n == 0 || n > UINT32_MAX || (*end && *end != ',')) {
+      fprintf(stderr, "bad station count '%s'\n", p);
+      return -EINVAL;
+    }
+    p = *end ? end + 1 : end;
+    cfg.stations = n;
+    ret = synth_dump(&d, &cfg);
+    if (ret == 0) {
+      iterations = bench ? bench : n < SYNTH_STATIONS ? SYNTH_STATIONS / n : 1;
+      if (threads)
+        ret = station_bench(st, &d, iterations, threads, workers);
       else
-        printf("no");
+        ret = bench_scale(&d, iterations, st->fields, st->out.fmt, st->out.verbose, stdout);
+      if (*p) putchar('\n');
     }
+    bench_dump_free(&d);
   }
+  if (ret < 0 && ret != -EBADMSG) fprintf(stderr, "synthetic benchmark: %s\n", strerror(-ret));
+  return ret;
+}
 
-  if (tb_msg[NL80211_STA_INFO_TID_STATS] && arg != NULL &&
-      !strcmp((char *)arg, "-v"))
-    parse_tid_stats(tb_msg[NL80211_STA_INFO_TID_STATS]);
-  if (tb_msg[NL80211_STA_INFO_BSS_PARAM])
-    parse_bss_param(tb_msg[NL80211_STA_INFO_BSS_PARAM]);
-  if (tb_msg[NL80211_STA_INFO_CONNECTED_TIME])
-    printf("\n\tconnected time:\t%u seconds",
-           nla_get_u32(tb_msg[NL80211_STA_INFO_CONNECTED_TIME]));
-  if (tb_msg[NL80211_STA_INFO_ASSOC_AT_BOOTTIME]) {
-    unsigned long long bt;
-    struct timespec now_ts;
-    unsigned long long boot_ns;
-    unsigned long long assoc_at_ms;
+/* the capture starts with the polled interfaces, main() closes it */
+static int station_record_open(struct nl80211_state *st, const struct station_dev *devs, int n) {
+  int i, ret;
 
-    clock_gettime(CLOCK_BOOTTIME, &now_ts);
-    boot_ns = now_ts.tv_sec * 1000000000ULL;
-    boot_ns += now_ts.tv_nsec;
+  ret = capture_open(&st->cap, st->record_path, st->nl80211_id);
+  if (ret < 0) {
+    fprintf(stderr, "%s: %s\n", st->record_path, strerror(-ret));
+    return ret;
+  }
+  for (i = 0; i < n; i++) {
+    struct capture_dev d = {.wiphy = devs[i].wiphy};
 
-    bt = (unsigned long long)nla_get_u64(tb_msg[NL80211_STA_INFO_ASSOC_AT_BOOTTIME]);
-    printf("\n\tassociated at [boottime]:\t%llu.%.3llus",
-           bt / 1000000000, (bt % 1000000000) / 1000000);
-    assoc_at_ms = now_ms - ((boot_ns - bt) / 1000000);
-    printf("\n\tassociated at:\t%llu ms", assoc_at_ms);
+    snprintf(d.name, sizeof(d.name), "%s", devs[i].name);
+    capture_put(&st->cap, CAPTURE_DEV, devs[i].ifindex, 0, 0, &d, sizeof(d));
   }
+  return 0;
+}
+
+/* replies the capture does not have end the round like a lost dump */
+static void station_replay_round_end(struct station_watch *w) {
+  int i;
 
-  printf("\n\tcurrent time:\t%llu ms\n", now_ms);
-  return NL_SKIP;
+  if (w->pending == 0) return;
+  for (i = 0; i < w->n; i++) w->devs[i].pending = 0;
+  w->pending = 0;
+  station_round_done(w);
 }
 
-/* Returns true if 'prefix' is a not empty prefix of 'string'. */
-static bool matches(const char *prefix, const char *string) {
-  if (!*prefix)
-    return false;
-  while (*string && *prefix == *string) {
-    prefix++;
-    string++;
-  }
-  return !*prefix;
+static struct station_dev *station_replay_dev(struct station_watch *w, uint32_t ifindex) {
+  int i;
+
+  for (i = 0; i < w->n; i++)
+    if (w->devs[i].ifindex == (int)ifindex) return &w->devs[i];
+  return NULL;
 }
 
-static void incomplete_command(void) {
-  fprintf(stderr, "Command line is not complete. Try option \"help\"\n");
-  exit(-1);
+/* Feed the records through what the sockets feed: the round bookkeeping,
+ * station_dev_msgs(), station_event_msg() and station_neigh_msg(), under
+ * the recorded clock. */
+static void station_replay_feed(struct station_watch *w, struct capture_file *cf) {
+  struct nl80211_state *st = w->st;
+  const struct capture_rec *r;
+
+  while (!w->done && !stop_requested && (r = capture_next(cf)) != NULL) {
+    const struct nlmsghdr *nlh = capture_data(r);
+    const struct capture_req *req = capture_data(r);
+    struct station_dev *dev;
+    struct neigh_msg m;
+    int len = r->len;
+    unsigned i;
+
+    st->replay = r;
+    if (r->kind >= CAPTURE_DUMP && r->kind <= CAPTURE_NEIGH) stats_count(&st->stats, STATS_BYTES_IN, len);
+    switch (r->kind) {
+    case CAPTURE_ROUND:
+      station_replay_round_end(w);
+      station_round_begin(w);
+      for (i = 0; i < r->len / sizeof(*req); i++) {
+        dev = station_replay_dev(w, req[i].ifindex);
+        if (dev == NULL || dev->pending) continue;
+        dev->seq = req[i].seq;
+        dev->ret = dev->last_error = 0;
+        dev->pending = 1;
+        w->pending++;
+      }
+      if (w->pending == 0) station_round_done(w);
+      break;
+    case CAPTURE_DUMP:
+      dev = station_replay_dev(w, r->ifindex);
+      if (dev == NULL || !dev->pending) break;
+      stats_count(&st->stats, STATS_DATAGRAMS, 1);
+      station_dev_msgs(w, dev, nlh, len);
+      if (!dev->pending && --w->pending == 0) station_round_done(w);
+      break;
+    case CAPTURE_MLME:
+      station_clock(st, &st->note);
+      for (; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) station_event_msg(w, nlh);
+      station_out_flush(st);
+      break;
+    case CAPTURE_NEIGH:
+      station_clock(st, &st->note);
+      for (; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) station_neigh_msg(w, nlh);
+      station_out_flush(st);
+      break;
+    case CAPTURE_NEIGH_DUMP: /* the cache (re)load, no samples */
+      if (len == 0) neigh_cache_clear(&st->neigh);
+      for (; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len))
+        if (neigh_decode(nlh, &m) == 0) neigh_cache_update(&st->neigh, &m);
+      break;
+    }
+  }
+  station_replay_round_end(w);
+  st->replay = NULL;
 }
 
-static int nl80211_cmd_get_station(const char *dev, const char *mac, int flags, int is_brief) {
-  int ret; /* to store returning values */
-  /* nl_socket_alloc(), genl_connect() replacement */
-  struct nl_sock sk = {
-      .s_fd = -1,
-      .s_cb = nl_cb_alloc(NL_CB_DEFAULT), /* callback */
-      .s_local.nl_family = AF_NETLINK,
-      .s_peer.nl_family = AF_NETLINK,
-      .s_seq_expect = time(NULL),
-      .s_seq_next = time(NULL),
-
-      /* the port is 0 (unspecified), meaning NL_OWN_PORT */
-      .s_flags = NL_OWN_PORT,
-  };
-
-  sk.s_fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_GENERIC);
-  nl80211State.nl_sock = &sk;
-
-  // find the nl80211 driver ID
-  nl80211State.nl80211_id = genl_ctrl_resolve(&sk, "nl80211");
-
-  // attach a callback
-  if (is_brief) {
-    nl_socket_modify_cb(&sk, NL_CB_VALID, NL_CB_CUSTOM, nl_cb_brief, NULL);
-  } else {
-    nl_socket_modify_cb(&sk, NL_CB_VALID, NL_CB_CUSTOM, nl_cb, NULL);
+/* Replay a capture without any device: print it in the selected format, or
+ * run bench/stress over its station messages. */
+static int station_replay(struct nl80211_state *st, const char *path, unsigned long count,
+                          unsigned bench, unsigned threads, int workers) {
+  struct capture_file cf;
+  struct bench_dump dump = {};
+  struct station_watch w = {};
+  struct iface_list list = {};
+  const struct capture_rec *r;
+  int i, ret, neigh = 0;
+
+  ret = capture_load(&cf, path);
+  if (ret < 0) {
+    fprintf(stderr, "%s: %s\n", path, ret == -EINVAL ? "not a capture file" : strerror(-ret));
+    return ret;
+  }
+  st->nl80211_id = cf.family_id;
+
+  /* the interfaces first, and the station messages for the benchmarks */
+  while ((r = capture_next(&cf)) != NULL) {
+    if (r->kind == CAPTURE_DEV && r->len >= sizeof(struct capture_dev)) {
+      const struct capture_dev *d = capture_data(r);
+      struct station_dev *dev;
+
+      if (list.n == list.cap) {
+        list.cap = list.cap ? list.cap * 2 : 8;
+        list.devs = realloc(list.devs, list.cap * sizeof(*list.devs));
+        if (list.devs == NULL) {
+          ret = -ENOMEM;
+          goto out;
+        }
+      }
+      dev = &list.devs[list.n++];
+      memset(dev, 0, sizeof(*dev));
+      dev->fd = -1;
+      dev->ifindex = r->ifindex;
+      dev->wiphy = d->wiphy;
+      snprintf(dev->name, sizeof(dev->name), "%.*s", (int)sizeof(d->name), d->name);
+    } else if (r->kind == CAPTURE_NEIGH || r->kind == CAPTURE_NEIGH_DUMP) {
+      neigh = 1; /* recorded with -n */
+    } else if (r->kind == CAPTURE_DUMP && (bench || threads)) {
+      const struct nlmsghdr *nlh = capture_data(r);
+      int len = r->len;
+
+      for (; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len))
+        if (nlh->nlmsg_type == cf.family_id && bench_dump_append(&dump, nlh) < 0) {
+          ret = -ENOMEM;
+          goto out;
+        }
+    }
   }
 
-  // allocate a message
-  struct nl_msg *msg = nlmsg_alloc();
+  if (bench || threads) {
+    ret = station_bench(st, &dump, bench, threads, workers);
+    goto out;
+  }
 
-  int if_index = if_nametoindex(dev);
-  if (if_index == 0) if_index = -1;
+  w.st = st;
+  w.devs = list.devs;
+  w.n = list.n;
+  w.quiet_enoent = list.n > 1;
+  w.count = count;
+  ret = station_rates_init(&st->rates, 64 * (list.n ? list.n : 1));
+  if (ret == 0 && neigh) ret = neigh_cache_init(&st->neigh, 256);
+  if (ret == 0) ret = link_cache_init(&st->links, list.n);
+  /* the names the interfaces had while recording, not the ones here */
+  for (i = 0; ret == 0 && i < list.n; i++) {
+    struct link_msg m = {.type = RTM_NEWLINK, .ifindex = list.devs[i].ifindex,
+                         .name = list.devs[i].name};
+
+    ret = link_cache_update(&st->links, &m) < 0 ? -ENOMEM : 0;
+  }
+  if (ret < 0) goto out;
+  st->out.links = &st->links;
+  cf.off = sizeof(struct capture_hdr);
+  station_replay_feed(&w, &cf);
+  st->out.links = NULL;
+  neigh_cache_free(&st->neigh);
+  station_rates_free(&st->rates);
+  ret = w.ret;
+
+out:
+  link_cache_free(&st->links);
+  free(list.devs);
+  bench_dump_free(&dump);
+  capture_free(&cf);
+  return ret;
+}
 
+static int nl80211_cmd_get_station(struct nl80211_state *st, const char *dev, const char *mac, int flags,
+                                   unsigned interval_ms, unsigned long count, unsigned bench,
+                                   unsigned threads, int events, int neigh, int workers) {
+  int ret, i, n;
+  struct bench_dump dump = {};
+  struct station_watch w = {};
+  struct station_dev *devs = NULL;
   uint8_t mac_addr[ETH_ALEN];
+
   if (!mac_addr_atoi((uint8_t *)&mac_addr, mac)) {
     fprintf(stderr, "invalid mac address\n");
     return 2;
   }
 
-  enum nl80211_commands cmd = NL80211_CMD_GET_STATION;
+  n = station_devs_parse(st, dev, &devs);
+  if (n <= 0) {
+    if (n == 0) fprintf(stderr, "no interfaces\n");
+    free(devs);
+    return n < 0 ? n : -ENODEV;
+  }
 
-  // setup the message
-  genlmsg_put(msg, 0, 0, nl80211State.nl80211_id, 0, flags, cmd, 0);
+  for (i = 0; i < n; i++) {
+    ret = nl80211_open(st);
+    if (ret < 0) {
+      station_devs_close(devs, n);
+      return ret;
+    }
+    devs[i].fd = ret;
+    nl80211_station_req(&devs[i], st->nl80211_id, mac ? mac_addr : NULL, flags);
+  }
 
-  // add message attributes
-  NLA_PUT_U32(msg, NL80211_ATTR_IFINDEX, if_index);
+  if (st->record_path) {
+    ret = station_record_open(st, devs, n);
+    if (ret < 0) {
+      station_devs_close(devs, n);
+      return ret;
+    }
+  }
 
-  if (mac != NULL) {
-    NLA_PUT(msg, NL80211_ATTR_MAC, ETH_ALEN, mac_addr);
+  w.st = st;
+  w.devs = devs;
+  w.n = n;
+  w.mac = mac ? mac_addr : NULL;
+  w.flags = flags;
+  w.quiet_enoent = n > 1;
+  w.count = count;
+  w.dump = bench || threads ? &dump : NULL;
+
+  /* bench and stress record one dump, a one-shot query prints one */
+  if (w.dump || (interval_ms == 0 && !events && !neigh)) {
+    w.count = 1;
+    ret = station_watch_open(&w, 0, 0, 0);
+    if (ret == 0) {
+      station_watch_run(&w);
+      ret = w.ret;
+      station_watch_close(&w);
+    }
+    station_devs_close(devs, n);
+    if (w.dump && ret >= 0) ret = station_bench(st, &dump, bench, threads, workers);
+    bench_dump_free(&dump);
+    return ret;
   }
-  // send the message (this frees it)
-  ret = nl_send_auto_complete(&sk, msg);
-  if (ret < 0) {
-    /* -ret bacause nl commands returns negative error code if false */
-    fprintf(stderr, "nl_send_auto_complete: %d %s\n", ret, strerror(-ret));
-    return (ret);
+
+  if (workers) {
+    ret = station_workers_run(st, &w, interval_ms, events, neigh);
+    station_devs_close(devs, n);
+    return ret;
   }
 
-  // block for message to return
-  ret = nl_recvmsgs_default(&sk);
+  ret = station_rates_init(&st->rates, 64 * n);
+  if (ret < 0) {
+    station_devs_close(devs, n);
+    return ret;
+  }
 
+  /* without a watch interval the dump is repeated only after lost
+   * notifications, in between only joins, leaves and neighbour changes are
+   * reported */
+  ret = station_watch_open(&w, interval_ms, events, neigh);
+  if (ret == 0) {
+    if (st->links_src.fd >= 0) ret = evloop_add(&w.loop, &st->links_src);
+    if (ret == 0 && st->prom.cap) ret = evloop_add(&w.loop, &st->serve);
+    if (ret < 0) station_watch_close(&w);
+  }
   if (ret < 0) {
-    /* -ret bacause nl commands returns negative error code if false */
-    fprintf(stderr, "nl_send_auto_complete: %d %s\n", ret, strerror(-ret));
+    station_rates_free(&st->rates);
+    station_devs_close(devs, n);
+    return ret;
   }
 
-  return (ret);
+  signal(SIGINT, on_stop_signal);
+  signal(SIGTERM, on_stop_signal);
+  /* errors are reported and polling goes on, the interface may come back */
+  station_watch_run(&w);
 
-nla_put_failure: /* this tag is used in NLA_PUT macros */
-  nlmsg_free(msg);
-  return -ENOBUFS;
+  station_watch_close(&w);
+  station_rates_free(&st->rates);
+  station_devs_close(devs, n);
+  return 0;
 }
 
 int main(int argc, char **argv) {
+  struct nl80211_state st = {};
   int ret;
   char *dev = NULL, *mac = NULL;
-  int is_brief = 0;
+  const char *out_path = NULL;
+  const char *replay_path = NULL; /* replay a capture instead of polling */
+  const char *serve = NULL;  /* exporter listen address */
+  int out_fd;
+  const struct station_formatter *fmt = &station_fmt_text;
+  unsigned interval_ms = 0; /* 0 means one-shot */
+  unsigned long count = 0;  /* 0 means until signalled */
+  unsigned bench = 0;       /* decode benchmark iterations */
+  unsigned threads = 0;     /* stress mode threads */
+  unsigned table_bench = 0; /* station table benchmark size */
+  const char *synth = NULL; /* synthetic dump sizes to benchmark */
+  const char *mix = "typical"; /* attributes of the synthetic stations */
+  int events = 0;           /* follow station join/leave notifications */
+  int neigh = 0;            /* follow neighbour changes of the stations */
+  int workers = 0;          /* one poll thread per wiphy */
+  unsigned stats_s = 0;     /* report interval of the statistics */
   int flags = 0; /* netlink generic msg flags */
+  st.fields = st.decode_fields = STATION_FIELDS_ALL; /* until -f */
   /* cli arguments parse */
   argv0 = *argv; /* first arg is program name */
   while (argc > 1) {
     NEXT_ARG();
     if (matches(*argv, "dev")) {
       NEXT_ARG();
-      dev = *argv; /* device interface name e.g. wlan0 */
+      dev = *argv; /* interface name e.g. wlan0, a list wlan0,wlan1 or all */
     } else if (matches(*argv, "mac")) {
       NEXT_ARG();
       mac = *argv; /* mac address e.g. aa:bb:cc:dd:ee:ff */
+    } else if (matches(*argv, "watch")) {
+      NEXT_ARG();
+      interval_ms = strtoul(*argv, NULL, 10); /* poll interval in ms */
+      if (interval_ms == 0) usage();
+    } else if (matches(*argv, "count")) {
+      NEXT_ARG();
+      count = strtoul(*argv, NULL, 10); /* number of samples in watch mode */
+    } else if (matches(*argv, "cache")) {
+      NEXT_ARG();
+      st.cache_path = *argv; /* e.g. /run/station_get.ids */
+    } else if (matches(*argv, "bench")) {
+      NEXT_ARG();
+      bench = strtoul(*argv, NULL, 10); /* decode iterations over one dump */
+      if (bench == 0) usage();
+    } else if (matches(*argv, "stress")) {
+      NEXT_ARG();
+      threads = strtoul(*argv, NULL, 10); /* decode and format threads */
+      if (threads == 0) usage();
+    } else if (matches(*argv, "tablebench")) {
+      NEXT_ARG();
+      table_bench = strtoul(*argv, NULL, 10); /* stations in the table benchmark */
+      if (table_bench == 0) usage();
+    } else if (matches(*argv, "synth")) {
+      NEXT_ARG();
+      synth = *argv; /* e.g. 100,1000,10000,100000 */
+    } else if (matches(*argv, "mix")) {
+      NEXT_ARG();
+      mix = *argv; /* min, typical, full or a list of attribute groups */
+    } else if (matches(*argv, "out")) {
+      NEXT_ARG();
+      out_path = *argv; /* samples file, truncated */
+    } else if (matches(*argv, "record")) {
+      NEXT_ARG();
+      st.record_path = *argv; /* capture file, truncated */
+    } else if (matches(*argv, "replay")) {
+      NEXT_ARG();
+      replay_path = *argv;
     } else if (matches(*argv, "help")) {
       usage();
     } else if (matches(*argv, "-b")) {
-      is_brief = 1;
+      fmt = &station_fmt_brief;
+    } else if (matches(*argv, "-o")) {
+      NEXT_ARG();
+      fmt = station_formatter_find(*argv);
+      if (fmt == NULL) usage();
+    } else if (matches(*argv, "-e")) {
+      events = 1;
+    } else if (matches(*argv, "-n")) {
+      neigh = 1;
+    } else if (matches(*argv, "-w")) {
+      workers = 1;
+    } else if (matches(*argv, "--stats")) {
+      st.stats.on = 1; /* time the hot path, print the counters at exit */
+    } else if (matches(*argv, "stats")) {
+      NEXT_ARG();
+      stats_s = strtoul(*argv, NULL, 10); /* also print them every <s> seconds */
+      if (stats_s == 0) usage();
+      st.stats.on = 1;
+    } else if (matches(*argv, "-v")) {
+      st.out.verbose = 1; /* per TID statistics */
+    } else if (matches(*argv, "-f")) {
+      NEXT_ARG();
+      if (station_fields_parse(&st, *argv) < 0) usage();
+    } else if (matches(*argv, "filter")) {
+      const char *bad;
+
+      NEXT_ARG();
+      if (station_filter_parse(&st.filter, *argv, &bad) < 0) {
+        fprintf(stderr, "bad filter term '%s'\n", bad);
+        usage();
+      }
+    } else if (matches(*argv, "top") || matches(*argv, "bottom")) {
+      int smallest = matches(*argv, "bottom");
+      struct station_key key;
+      unsigned long n;
+
+      NEXT_ARG();
+      n = strtoul(*argv, NULL, 10); /* stations per round */
+      NEXT_ARG();
+      if (n == 0 || n > UINT32_MAX || station_key_parse(&key, *argv, strlen(*argv)) < 0) usage();
+      station_top_free(&st.top);
+      if (station_top_init(&st.top, n, &key, smallest) < 0) {
+        fprintf(stderr, "failed to allocate %lu top stations!\n", n);
+        return ENOMEM;
+      }
+    } else if (matches(*argv, "serve")) {
+      NEXT_ARG();
+      serve = *argv; /* e.g. 9101 or 192.0.2.1:9101 */
     } else {
       usage();
     }
   }
 
-  if (dev == NULL) {
+  st.out.fmt = fmt;
+  st.out.fields = st.fields; /* csv and bin cut their layout to -f */
+  st.stats_period_ns = stats_s * 1000000000ULL;
+  /* what is only read to select stations is decoded, not printed */
+  st.decode_fields |= station_filter_fields(&st.filter);
+  if (st.top.cap) st.decode_fields |= station_key_fields(&st.top.key);
+  if (st.decode_fields & STA_BIT(DELTA)) st.decode_fields |= STATION_RATE_FIELDS;
+  if (table_bench) /* needs no interface */
+    return -bench_table(table_bench, stdout);
+  if (synth) /* neither */
+    return -station_synth(&st, synth, mix, bench, threads, workers);
+  if (dev == NULL && replay_path == NULL) {
     incomplete_command();
   }
+  if (workers && st.record_path) { /* replay follows the rounds of one loop */
+    fprintf(stderr, "record does not work with -w\n");
+    return EINVAL;
+  }
+  if (workers && st.top.cap) { /* the workers' rounds are not aligned */
+    fprintf(stderr, "top and bottom do not work with -w\n");
+    return EINVAL;
+  }
+  /* scrapes are answered by the loop that polls */
+  if (serve && (!interval_ms || workers || replay_path || bench || threads || st.top.cap)) {
+    fprintf(stderr, "serve needs watch and does not work with -w, replay, bench, stress or top\n");
+    return EINVAL;
+  }
   if (mac == NULL) { /* if mac is not set than set flags to make dump */
     flags = NLM_F_DUMP;
   }
 
-  ret = nl80211_cmd_get_station(dev, mac, flags, is_brief);
+  out_fd = STDOUT_FILENO;
+  if (out_path) {
+    out_fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out_fd < 0) {
+      ret = errno;
+      fprintf(stderr, "%s: %s\n", out_path, strerror(ret));
+      return ret;
+    }
+  }
+  if (obuf_init(&st.out.ob, out_fd, OBUF_SIZE) < 0) {
+    fprintf(stderr, "failed to allocate output buffer!\n");
+    return ENOMEM;
+  }
+  if (replay_path)
+    ret = station_replay(&st, replay_path, count, bench, threads, workers);
+  else {
+    /* names are cached for a run that lasts, which follows renames, and for
+     * several interfaces, one dump instead of a lookup each; otherwise
+     * if_nametoindex() resolves the name and the formatters ask the kernel */
+    int follow = interval_ms || events || neigh;
+
+    st.links_src.fd = -1;
+    ret = 0;
+    if (follow || !strcmp(dev, "all") || strchr(dev, ','))
+      ret = station_links_open(&st, follow);
+    if (ret == 0 && serve) ret = station_serve_open(&st, serve);
+    if (ret == 0)
+      ret = nl80211_cmd_get_station(&st, dev, mac, flags, interval_ms, count, bench, threads,
+                                    events, neigh, workers);
+    station_serve_close(&st);
+    station_links_close(&st);
+  }
+  if (st.stats.on) {
+    stats_merge(&st.stats_total, &st.stats);
+    stats_print(&st.stats_total, "total", stderr);
+  }
+  if (st.cap.f && capture_close(&st.cap) < 0 && ret == 0) {
+    fprintf(stderr, "%s: %s\n", st.record_path, strerror(-st.cap.err));
+    ret = st.cap.err;
+  }
+  obuf_free(&st.out.ob);
+  station_top_free(&st.top);
+  if (out_path && close(out_fd) < 0 && ret == 0) {
+    fprintf(stderr, "%s: %s\n", out_path, strerror(errno));
+    ret = -EIO;
+  }
   return -ret;
 }
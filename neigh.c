@@ -0,0 +1,417 @@
+#include <errno.h>
+#include <linux/neighbour.h>
+#include <linux/rtnetlink.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "neigh.h"
+#include "station_table.h" /* station_table_mac() */
+
+int neigh_decode(const struct nlmsghdr *nh, struct neigh_msg *m) {
+  const struct ndmsg *nd = NLMSG_DATA(nh);
+  const struct rtattr *rta;
+  int len;
+
+  if (nh->nlmsg_type != RTM_NEWNEIGH && nh->nlmsg_type != RTM_DELNEIGH) return -EINVAL;
+  if (nh->nlmsg_len < NLMSG_LENGTH(sizeof(*nd))) return -EINVAL;
+
+  memset(m, 0, sizeof(*m));
+  m->type = nh->nlmsg_type;
+  m->family = nd->ndm_family;
+  m->flags = nd->ndm_flags;
+  m->state = nd->ndm_state;
+  m->ifindex = nd->ndm_ifindex;
+
+  len = nh->nlmsg_len - NLMSG_LENGTH(sizeof(*nd));
+  for (rta = (const struct rtattr *)((const char *)nd + NLMSG_ALIGN(sizeof(*nd)));
+       RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+    switch (rta->rta_type) {
+    case NDA_LLADDR:
+      if (RTA_PAYLOAD(rta) == 6) m->lladdr = RTA_DATA(rta);
+      break;
+    case NDA_DST:
+      if (RTA_PAYLOAD(rta) != 4 && RTA_PAYLOAD(rta) != 16) break;
+      m->dst = RTA_DATA(rta);
+      m->dst_len = RTA_PAYLOAD(rta);
+      break;
+    }
+  }
+  return 0;
+}
+
+/* the kernel's NUD_VALID, the states with a usable link layer address */
+#define NUD_VALID (NUD_PERMANENT | NUD_NOARP | NUD_REACHABLE | NUD_PROBE | NUD_STALE | NUD_DELAY)
+
+/* every column, the key first */
+#define NEIGH_CACHE_COLUMNS(X) \
+  X(mac)                       \
+  X(ipv4)                      \
+  X(ipv6)
+
+#define COLUMN_ALIGN 64
+
+static size_t column_size(size_t elem, uint32_t cap) {
+  return (elem * cap + COLUMN_ALIGN - 1) & ~(size_t)(COLUMN_ALIGN - 1);
+}
+
+static uint32_t neigh_hash(uint64_t mac) {
+  return (mac * 0x9e3779b97f4a7c15ULL) >> 32;
+}
+
+static int neigh_cache_alloc(struct neigh_cache *c, uint32_t cap) {
+  size_t size = 0;
+  char *p;
+
+#define X(col) size += column_size(sizeof *c->col, cap);
+  NEIGH_CACHE_COLUMNS(X)
+#undef X
+  if (posix_memalign(&c->mem, COLUMN_ALIGN, size)) return -ENOMEM;
+  memset(c->mem, 0, size);
+
+  p = c->mem;
+#define X(col)          \
+  c->col = (void *)p;   \
+  p += column_size(sizeof *c->col, cap);
+  NEIGH_CACHE_COLUMNS(X)
+#undef X
+  c->cap = cap;
+  c->count = 0;
+  return 0;
+}
+
+static int owner_alloc(struct neigh_cache *c, uint32_t cap);
+
+int neigh_cache_init(struct neigh_cache *c, uint32_t hint) {
+  uint32_t cap = 64;
+
+  while (cap / 4 * 3 < hint) cap *= 2;
+  if (neigh_cache_alloc(c, cap) < 0) return -ENOMEM;
+  /* a MAC has an IPv4 and a link local address at least */
+  if (owner_alloc(c, cap * 2) < 0) {
+    free(c->mem);
+    return -ENOMEM;
+  }
+  return 0;
+}
+
+void neigh_cache_free(struct neigh_cache *c) {
+  free(c->mem);
+  free(c->owners);
+  memset(c, 0, sizeof(*c));
+}
+
+void neigh_cache_clear(struct neigh_cache *c) {
+  memset(c->mac, 0, c->cap * sizeof(*c->mac));
+  memset(c->owners, 0, c->owners_cap * sizeof(*c->owners));
+  c->count = c->owners_count = 0;
+}
+
+int32_t neigh_cache_find(const struct neigh_cache *c, uint64_t mac) {
+  uint32_t mask = c->cap - 1, i = neigh_hash(mac) & mask;
+
+  for (; c->mac[i]; i = (i + 1) & mask) {
+    if (c->mac[i] == mac) return i;
+  }
+  return -1;
+}
+
+static int neigh_cache_grow(struct neigh_cache *c) {
+  struct neigh_cache old = *c;
+  uint32_t i;
+
+  if (neigh_cache_alloc(c, old.cap * 2) < 0) {
+    *c = old;
+    return -ENOMEM;
+  }
+  for (i = 0; i < old.cap; i++) {
+    uint32_t mask = c->cap - 1, j;
+
+    if (!old.mac[i]) continue;
+    for (j = neigh_hash(old.mac[i]) & mask; c->mac[j]; j = (j + 1) & mask)
+      ;
+#define X(col) c->col[j] = old.col[i];
+    NEIGH_CACHE_COLUMNS(X)
+#undef X
+  }
+  c->count = old.count;
+  free(old.mem);
+  return 0;
+}
+
+static int32_t neigh_cache_insert(struct neigh_cache *c, uint64_t mac) {
+  uint32_t mask = c->cap - 1, i;
+
+  if ((c->count + 1) * 4 > c->cap * 3) {
+    if (neigh_cache_grow(c) < 0) return -ENOMEM;
+    mask = c->cap - 1;
+  }
+  for (i = neigh_hash(mac) & mask; c->mac[i]; i = (i + 1) & mask)
+    ;
+  c->mac[i] = mac;
+  memset(&c->ipv4[i], 0, sizeof(c->ipv4[i]));
+  memset(&c->ipv6[i], 0, sizeof(c->ipv6[i]));
+  c->count++;
+  return i;
+}
+
+/* backward shift, as station_table_delete() */
+static void neigh_cache_delete(struct neigh_cache *c, uint32_t slot) {
+  uint32_t mask = c->cap - 1, hole = slot, j = slot;
+
+  for (;;) {
+    uint32_t home;
+
+    j = (j + 1) & mask;
+    if (!c->mac[j]) break;
+    home = neigh_hash(c->mac[j]) & mask;
+    if (((j - home) & mask) >= ((j - hole) & mask)) {
+#define X(col) c->col[hole] = c->col[j];
+      NEIGH_CACHE_COLUMNS(X)
+#undef X
+      hole = j;
+    }
+  }
+  c->mac[hole] = 0;
+  c->count--;
+}
+
+/* the reverse index, one address per slot */
+static void owner_key(struct in6_addr *k, const void *dst, int dst_len) {
+  if (dst_len == 16) {
+    memcpy(k, dst, 16);
+    return;
+  }
+  memset(k, 0, sizeof(*k));
+  k->s6_addr[10] = k->s6_addr[11] = 0xff;
+  memcpy(&k->s6_addr[12], dst, 4);
+}
+
+static uint32_t owner_hash(const struct in6_addr *a) {
+  uint64_t h[2];
+
+  memcpy(h, a, sizeof(h));
+  h[0] ^= h[1];
+  h[0] ^= h[0] >> 32; /* an IPv4 address sits in the high half */
+  return (h[0] * 0x9e3779b97f4a7c15ULL) >> 32;
+}
+
+static int32_t owner_find(const struct neigh_cache *c, const struct in6_addr *k) {
+  uint32_t mask = c->owners_cap - 1, i = owner_hash(k) & mask;
+
+  for (; c->owners[i].mac; i = (i + 1) & mask) {
+    if (!memcmp(&c->owners[i].addr, k, sizeof(*k))) return i;
+  }
+  return -1;
+}
+
+static int owner_alloc(struct neigh_cache *c, uint32_t cap) {
+  c->owners = calloc(cap, sizeof(*c->owners));
+  if (c->owners == NULL) return -ENOMEM;
+  c->owners_cap = cap;
+  c->owners_count = 0;
+  return 0;
+}
+
+static int owner_insert(struct neigh_cache *c, const struct in6_addr *k, uint64_t mac) {
+  uint32_t mask = c->owners_cap - 1, i;
+
+  if ((c->owners_count + 1) * 4 > c->owners_cap * 3) {
+    struct neigh_owner *old = c->owners;
+    uint32_t old_cap = c->owners_cap, count = c->owners_count;
+
+    if (owner_alloc(c, old_cap * 2) < 0) {
+      c->owners = old;
+      c->owners_cap = old_cap;
+      return -ENOMEM;
+    }
+    mask = c->owners_cap - 1;
+    for (i = 0; i < old_cap; i++) {
+      uint32_t j;
+
+      if (!old[i].mac) continue;
+      for (j = owner_hash(&old[i].addr) & mask; c->owners[j].mac; j = (j + 1) & mask)
+        ;
+      c->owners[j] = old[i];
+    }
+    c->owners_count = count;
+    free(old);
+  }
+  for (i = owner_hash(k) & mask; c->owners[i].mac; i = (i + 1) & mask)
+    ;
+  c->owners[i].addr = *k;
+  c->owners[i].mac = mac;
+  c->owners_count++;
+  return 0;
+}
+
+static void owner_delete(struct neigh_cache *c, uint32_t slot) {
+  uint32_t mask = c->owners_cap - 1, hole = slot, j = slot;
+
+  for (;;) {
+    uint32_t home;
+
+    j = (j + 1) & mask;
+    if (!c->owners[j].mac) break;
+    home = owner_hash(&c->owners[j].addr) & mask;
+    if (((j - home) & mask) >= ((j - hole) & mask)) {
+      c->owners[hole] = c->owners[j];
+      hole = j;
+    }
+  }
+  c->owners[hole].mac = 0;
+  c->owners_count--;
+}
+
+/* drop the index entry of an address 'mac' no longer holds */
+static void owner_forget(struct neigh_cache *c, const void *dst, int dst_len, uint64_t mac) {
+  struct in6_addr k;
+  int32_t i;
+
+  owner_key(&k, dst, dst_len);
+  i = owner_find(c, &k);
+  if (i >= 0 && c->owners[i].mac == mac) owner_delete(c, i);
+}
+
+static int v6_find(const struct neigh_v6 *v, const void *addr) {
+  int i;
+
+  for (i = 0; i < NEIGH_MAX_V6; i++)
+    if (!memcmp(&v->addr[i], addr, sizeof(v->addr[i]))) return i;
+  return -1;
+}
+
+/* Drop 'dst' from 'slot', and the slot once it has no address left. The
+ * IPv6 addresses stay packed at the front. The index is up to the caller. */
+static void slot_drop(struct neigh_cache *c, uint32_t slot, const void *dst, int dst_len) {
+  struct neigh_v6 *v = &c->ipv6[slot];
+  int i;
+
+  if (dst_len == 4) {
+    if (!memcmp(&c->ipv4[slot], dst, 4)) c->ipv4[slot].s_addr = INADDR_ANY;
+  } else if ((i = v6_find(v, dst)) >= 0) {
+    memmove(&v->addr[i], &v->addr[i + 1], (NEIGH_MAX_V6 - 1 - i) * sizeof(v->addr[0]));
+    memset(&v->addr[NEIGH_MAX_V6 - 1], 0, sizeof(v->addr[0]));
+  }
+  if (c->ipv4[slot].s_addr == INADDR_ANY && IN6_IS_ADDR_UNSPECIFIED(&v->addr[0]))
+    neigh_cache_delete(c, slot);
+}
+
+/* 'dst' is gone, from 'mac' or, if 0, from whichever MAC held it */
+static int neigh_cache_remove(struct neigh_cache *c, const void *dst, int dst_len, uint64_t mac) {
+  struct in6_addr k;
+  int32_t i, slot;
+  uint64_t owner;
+
+  owner_key(&k, dst, dst_len);
+  i = owner_find(c, &k);
+  if (i < 0) return 0;
+  owner = c->owners[i].mac;
+  if (mac && owner != mac) return 0;
+  owner_delete(c, i);
+  slot = neigh_cache_find(c, owner);
+  if (slot >= 0) slot_drop(c, slot, dst, dst_len);
+  return 1;
+}
+
+/* 'dst' belongs to 'mac' now, one IPv4 address per MAC */
+static int neigh_cache_add(struct neigh_cache *c, const void *dst, int dst_len, uint64_t mac) {
+  struct neigh_v6 *v;
+  struct in6_addr k;
+  int32_t i, slot;
+
+  owner_key(&k, dst, dst_len);
+  i = owner_find(c, &k);
+  if (i >= 0 && c->owners[i].mac == mac) return 0;
+
+  slot = neigh_cache_find(c, mac);
+  if (slot < 0) {
+    slot = neigh_cache_insert(c, mac);
+    if (slot < 0) return slot;
+  }
+  if (i >= 0) { /* moved, e.g. a DHCP lease handed to another client */
+    int32_t old = neigh_cache_find(c, c->owners[i].mac);
+
+    c->owners[i].mac = mac;
+    /* deleting the old owner shifts slots, 'slot' among them */
+    if (old >= 0) slot_drop(c, old, dst, dst_len);
+    slot = neigh_cache_find(c, mac);
+  } else if (owner_insert(c, &k, mac) < 0) {
+    if (c->ipv4[slot].s_addr == INADDR_ANY && IN6_IS_ADDR_UNSPECIFIED(&c->ipv6[slot].addr[0]))
+      neigh_cache_delete(c, slot);
+    return -ENOMEM;
+  }
+
+  if (dst_len == 4) {
+    if (c->ipv4[slot].s_addr != INADDR_ANY) owner_forget(c, &c->ipv4[slot], 4, mac);
+    memcpy(&c->ipv4[slot], dst, 4);
+    return 1;
+  }
+  v = &c->ipv6[slot];
+  if (!IN6_IS_ADDR_UNSPECIFIED(&v->addr[NEIGH_MAX_V6 - 1])) { /* full: the oldest goes */
+    owner_forget(c, &v->addr[0], 16, mac);
+    memmove(&v->addr[0], &v->addr[1], (NEIGH_MAX_V6 - 1) * sizeof(v->addr[0]));
+    memset(&v->addr[NEIGH_MAX_V6 - 1], 0, sizeof(v->addr[0]));
+  }
+  memcpy(&v->addr[v6_find(v, &in6addr_any)], dst, 16);
+  return 1;
+}
+
+int neigh_cache_update(struct neigh_cache *c, const struct neigh_msg *m) {
+  uint64_t mac = m->lladdr ? station_table_mac(m->lladdr) : 0;
+
+  if (m->flags & NTF_PROXY || m->dst == NULL) return 0;
+  if ((m->family == AF_INET) != (m->dst_len == 4)) return 0;
+  if (m->family != AF_INET && m->family != AF_INET6) return 0;
+
+  /* failed entries carry no link layer address, multicast ones no station */
+  if (m->type == RTM_DELNEIGH || !(m->state & NUD_VALID) || mac == 0 || m->lladdr[0] & 1)
+    return neigh_cache_remove(c, m->dst, m->dst_len, mac);
+  return neigh_cache_add(c, m->dst, m->dst_len, mac);
+}
+
+const struct in6_addr *neigh_cache_ipv6(const struct neigh_cache *c, uint32_t slot) {
+  const struct neigh_v6 *v = &c->ipv6[slot];
+  int i;
+
+  for (i = 0; i < NEIGH_MAX_V6 && !IN6_IS_ADDR_UNSPECIFIED(&v->addr[i]); i++)
+    if (!IN6_IS_ADDR_LINKLOCAL(&v->addr[i])) return &v->addr[i];
+  return IN6_IS_ADDR_UNSPECIFIED(&v->addr[0]) ? NULL : &v->addr[0];
+}
+
+struct neigh_dump {
+  struct neigh_cache *c;
+  nlraw_cb each;
+  void *arg;
+};
+
+static int neigh_dump_cb(const struct nlmsghdr *nh, void *arg) {
+  struct neigh_dump *d = arg;
+  struct neigh_msg m;
+  int ret;
+
+  if (d->each) {
+    ret = d->each(nh, d->arg);
+    if (ret < 0) return ret;
+  }
+  if (neigh_decode(nh, &m) < 0) return 0;
+  ret = neigh_cache_update(d->c, &m);
+  return ret < 0 ? ret : 0;
+}
+
+int neigh_cache_dump(struct neigh_cache *c, int fd, nlraw_cb each, void *arg) {
+  struct {
+    struct nlmsghdr nlh;
+    struct ndmsg nd;
+  } req = {
+      .nlh = {.nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg)),
+              .nlmsg_type = RTM_GETNEIGH,
+              .nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP},
+      .nd = {.ndm_family = AF_UNSPEC},
+  };
+  struct neigh_dump d = {.c = c, .each = each, .arg = arg};
+  int ret;
+
+  ret = nlraw_transact_msg(fd, &req.nlh, neigh_dump_cb, &d);
+  return ret < 0 ? ret : (int)c->count;
+}
@@ -0,0 +1,81 @@
+//
+// rtnetlink neighbour (ARP/ND) decoder and MAC -> IP address cache
+//
+
+#ifndef NETLINK_DEMO_NEIGH_H
+#define NETLINK_DEMO_NEIGH_H
+
+#include <linux/netlink.h>
+#include <netinet/in.h>
+#include <stdint.h>
+
+#include "nlraw.h"
+
+#define NEIGH_MAX_V6 4 /* IPv6 addresses kept per MAC, link local included */
+
+/* One RTM_NEWNEIGH/RTM_DELNEIGH message. The pointers point into the
+ * message, they are only good as long as it is. */
+struct neigh_msg {
+  uint16_t type;         /* RTM_NEWNEIGH or RTM_DELNEIGH */
+  uint8_t family;        /* AF_INET, AF_INET6, AF_BRIDGE... */
+  uint8_t flags;         /* NTF_* */
+  uint16_t state;        /* NUD_* */
+  uint32_t ifindex;      /* the bridge or routed interface, not the wlan one */
+  const uint8_t *lladdr; /* NDA_LLADDR, NULL unless it is a 6 byte MAC */
+  const void *dst;       /* NDA_DST in network order, NULL if missing */
+  int dst_len;           /* 4 or 16 */
+};
+
+/* Returns 0, or -EINVAL if 'nh' is no neighbour message or is truncated. */
+int neigh_decode(const struct nlmsghdr *nh, struct neigh_msg *m);
+
+/* IPv6 addresses of one MAC, oldest first, unused ones unspecified (::) */
+struct neigh_v6 {
+  struct in6_addr addr[NEIGH_MAX_V6];
+};
+
+/* an address and the MAC holding it, IPv4 as ::ffff:a.b.c.d */
+struct neigh_owner {
+  struct in6_addr addr;
+  uint64_t mac; /* 0 marks a free slot */
+};
+
+/* Open addressing over MACs, the same layout as the station table: one
+ * array per field, linear probing, backward shift deletion. MAC 0 marks a
+ * free slot, no neighbour entry carries it. The key is the MAC alone: the
+ * entries hang off the bridge, whatever wlan interface the station is on.
+ * A second table indexes every cached address by address, so one that moves
+ * to another MAC or fails without a link layer address finds its owner. */
+struct neigh_cache {
+  uint32_t cap, count;
+  uint64_t *mac;          /* station_table_mac() */
+  struct in_addr *ipv4;   /* INADDR_ANY if none */
+  struct neigh_v6 *ipv6;
+  void *mem;
+
+  uint32_t owners_cap, owners_count;
+  struct neigh_owner *owners;
+};
+
+int neigh_cache_init(struct neigh_cache *c, uint32_t hint);
+void neigh_cache_free(struct neigh_cache *c);
+/* forget every MAC, the room stays */
+void neigh_cache_clear(struct neigh_cache *c);
+
+/* slot of 'mac', -1 if none of its addresses is known */
+int32_t neigh_cache_find(const struct neigh_cache *c, uint64_t mac);
+
+/* Apply a decoded message: a valid (NUD_VALID) entry adds its address, a
+ * failed or deleted one removes it. Proxy entries are ignored. Returns 1 if
+ * the cache changed, 0 if not, -ENOMEM. */
+int neigh_cache_update(struct neigh_cache *c, const struct neigh_msg *m);
+
+/* Fill the cache from an RTM_GETNEIGH dump over the NETLINK_ROUTE socket
+ * 'fd'. 'each', if not NULL, sees every message first (recording). Returns
+ * the number of MACs cached or a negative errno. */
+int neigh_cache_dump(struct neigh_cache *c, int fd, nlraw_cb each, void *arg);
+
+/* best IPv6 address of a slot: global before link local, NULL if none */
+const struct in6_addr *neigh_cache_ipv6(const struct neigh_cache *c, uint32_t slot);
+
+#endif // NETLINK_DEMO_NEIGH_H
@@ -0,0 +1,140 @@
+#define _GNU_SOURCE 1 /* mkostemp() */
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "nl80211_ids.h"
+#include "nlraw.h" /* controller lookup */
+
+#define BOOT_ID_PATH "/proc/sys/kernel/random/boot_id"
+#define BOOT_ID_LEN 36 /* uuid string without the trailing newline */
+
+/* in-process cache, shared by every socket and thread of the process */
+static struct nl80211_ids ids_cache = {.family_id = -1, .mlme_grp = -1};
+static pthread_mutex_t ids_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int read_boot_id(char *buf) {
+  int fd = open(BOOT_ID_PATH, O_RDONLY | O_CLOEXEC);
+  ssize_t len;
+
+  if (fd < 0) return -errno;
+  len = read(fd, buf, BOOT_ID_LEN);
+  close(fd);
+  if (len != BOOT_ID_LEN) return -EIO;
+  buf[BOOT_ID_LEN] = '\0';
+  return 0;
+}
+
+/* the file is a single line: "<boot id> <family id> <mlme group id>" */
+static int disk_load(const char *path, struct nl80211_ids *ids) {
+  char boot_id[BOOT_ID_LEN + 1], file_boot_id[BOOT_ID_LEN + 1];
+  int family_id, mlme_grp;
+  FILE *f;
+
+  if (path == NULL || read_boot_id(boot_id) < 0) return -ENOENT;
+  f = fopen(path, "re");
+  if (f == NULL) return -errno;
+  if (fscanf(f, "%36s %d %d", file_boot_id, &family_id, &mlme_grp) != 3 ||
+      strcmp(boot_id, file_boot_id) != 0 || family_id <= 0) {
+    fclose(f);
+    return -ESTALE;
+  }
+  fclose(f);
+
+  ids->family_id = family_id;
+  ids->mlme_grp = mlme_grp;
+  ids->from_disk = 1;
+  return 0;
+}
+
+/* Write to a temporary file next to 'path' and rename it, readers never see
+ * a partial line. mkostemp() creates the file exclusively with a random name,
+ * so a link planted where the name would be cannot redirect the write. */
+static void disk_store(const char *path, const struct nl80211_ids *ids) {
+  char boot_id[BOOT_ID_LEN + 1], tmp[4096];
+  FILE *f;
+  int fd;
+
+  if (path == NULL || read_boot_id(boot_id) < 0) return;
+  if (snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >= (int)sizeof(tmp)) return;
+  fd = mkostemp(tmp, O_CLOEXEC);
+  if (fd < 0) return;
+  fchmod(fd, 0644); /* mkostemp() makes it 0600, other users may read it */
+  f = fdopen(fd, "w");
+  if (f == NULL) {
+    close(fd);
+    unlink(tmp);
+    return;
+  }
+  fprintf(f, "%s %d %d\n", boot_id, ids->family_id, ids->mlme_grp);
+  if (fclose(f) != 0 || rename(tmp, path) != 0) unlink(tmp);
+}
+
+static int ids_get(int fd, const char *path, struct nl80211_ids *ids) {
+  int id;
+
+  if (ids_cache.family_id > 0) {
+    *ids = ids_cache;
+    return 0;
+  }
+  if (disk_load(path, &ids_cache) == 0) {
+    *ids = ids_cache;
+    return 0;
+  }
+
+  // find the nl80211 driver ID
+  id = nlraw_genl_resolve(fd, "nl80211", NULL, NULL);
+  if (id < 0) return id;
+  ids_cache.family_id = id;
+  ids_cache.from_disk = 0;
+  disk_store(path, &ids_cache);
+  *ids = ids_cache;
+  return 0;
+}
+
+int nl80211_ids_get(int fd, const char *path, struct nl80211_ids *ids) {
+  int ret;
+
+  pthread_mutex_lock(&ids_lock);
+  ret = ids_get(fd, path, ids);
+  pthread_mutex_unlock(&ids_lock);
+  return ret;
+}
+
+int nl80211_ids_mlme(int fd, const char *path, struct nl80211_ids *ids) {
+  int ret, grp;
+
+  pthread_mutex_lock(&ids_lock);
+  ret = ids_get(fd, path, ids);
+  if (ret < 0 || ids->mlme_grp >= 0) goto out;
+
+  ret = nlraw_genl_resolve(fd, "nl80211", "mlme", &grp);
+  if (ret < 0) goto out;
+  ret = 0;
+  ids_cache.mlme_grp = grp;
+  disk_store(path, &ids_cache);
+  *ids = ids_cache;
+out:
+  pthread_mutex_unlock(&ids_lock);
+  return ret;
+}
+
+int nl80211_ids_refresh(int fd, const char *path, struct nl80211_ids *ids) {
+  int old_id, ret;
+
+  pthread_mutex_lock(&ids_lock);
+  old_id = ids->family_id; /* another thread may have refreshed the cache already */
+  ids_cache.family_id = -1;
+  ids_cache.mlme_grp = -1;
+  if (path != NULL) unlink(path);
+
+  ret = ids_get(fd, path, ids);
+  if (ret == 0) ret = ids->family_id != old_id;
+  pthread_mutex_unlock(&ids_lock);
+  return ret;
+}
@@ -0,0 +1,30 @@
+//
+// nl80211 generic netlink family and multicast group id cache
+//
+
+#ifndef NETLINK_DEMO_NL80211_IDS_H
+#define NETLINK_DEMO_NL80211_IDS_H
+
+struct nl80211_ids {
+  int family_id; /* nl80211 generic netlink family id */
+  int mlme_grp;  /* "mlme" multicast group id, -1 if not resolved yet */
+  int from_disk; /* ids were taken from the on-disk cache, not the controller */
+};
+
+/* Resolve the nl80211 family id. The in-process cache is tried first, then the
+ * on-disk cache at 'path' (NULL disables it) if it was written during the
+ * current boot, and only then the generic netlink controller, asked over
+ * the netlink socket 'fd'.
+ * Returns 0 or a negative error code. */
+int nl80211_ids_get(int fd, const char *path, struct nl80211_ids *ids);
+
+/* Resolve the "mlme" multicast group id, caching it the same way. */
+int nl80211_ids_mlme(int fd, const char *path, struct nl80211_ids *ids);
+
+/* Drop both caches and resolve again through the controller. The "mlme"
+ * group is resolved again by the next nl80211_ids_mlme(), a socket that
+ * joined the old one has to join anew. Returns 1 if the family id differs
+ * from the one in 'ids', 0 if not, or a negative error code. */
+int nl80211_ids_refresh(int fd, const char *path, struct nl80211_ids *ids);
+
+#endif // NETLINK_DEMO_NL80211_IDS_H
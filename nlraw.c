@@ -0,0 +1,155 @@
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "nlraw.h"
+
+#define NLRAW_BUFSIZE 32768      /* the largest datagram the kernel sends */
+#define NLRAW_TIMEOUT_MS 5000    /* give up on a transaction without reply */
+
+void nlraw_req_init(struct nlraw_req *r, uint16_t family, uint8_t cmd, uint16_t flags) {
+  memset(r, 0, sizeof(*r));
+  r->nlh.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+  r->nlh.nlmsg_type = family;
+  r->nlh.nlmsg_flags = NLM_F_REQUEST | flags;
+  r->genl.cmd = cmd;
+}
+
+int nlraw_req_put(struct nlraw_req *r, uint16_t type, const void *data, uint16_t len) {
+  struct nlattr *a = (struct nlattr *)((char *)r + NLMSG_ALIGN(r->nlh.nlmsg_len));
+
+  if (NLMSG_ALIGN(r->nlh.nlmsg_len) + NLA_ALIGN(NLA_HDRLEN + len) > sizeof(*r)) return -EMSGSIZE;
+  a->nla_type = type;
+  a->nla_len = NLA_HDRLEN + len;
+  memcpy((char *)a + NLA_HDRLEN, data, len);
+  r->nlh.nlmsg_len = NLMSG_ALIGN(r->nlh.nlmsg_len) + NLA_ALIGN(a->nla_len);
+  return 0;
+}
+
+uint32_t nlraw_seq(void) {
+  static uint32_t seq;
+
+  return __atomic_add_fetch(&seq, 1, __ATOMIC_RELAXED);
+}
+
+int nlraw_open(int proto) {
+  int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, proto);
+
+  return fd < 0 ? -errno : fd;
+}
+
+int nlraw_send_msg(int fd, struct nlmsghdr *nlh, uint32_t seq) {
+  nlh->nlmsg_seq = seq;
+  while (send(fd, nlh, nlh->nlmsg_len, 0) < 0) {
+    if (errno != EINTR) return -errno;
+  }
+  return 0;
+}
+
+int nlraw_send(int fd, struct nlraw_req *r, uint32_t seq) {
+  return nlraw_send_msg(fd, &r->nlh, seq);
+}
+
+static int nlraw_recv(int fd, void *buf) {
+  struct pollfd pfd = {.fd = fd, .events = POLLIN};
+  int len;
+
+  for (;;) {
+    len = recv(fd, buf, NLRAW_BUFSIZE, MSG_DONTWAIT);
+    if (len >= 0) return len;
+    if (errno == EINTR) continue;
+    if (errno != EAGAIN && errno != EWOULDBLOCK) return -errno;
+    len = poll(&pfd, 1, NLRAW_TIMEOUT_MS);
+    if (len == 0) return -ETIMEDOUT;
+    if (len < 0 && errno != EINTR) return -errno;
+  }
+}
+
+int nlraw_transact_msg(int fd, struct nlmsghdr *req, nlraw_cb cb, void *arg) {
+  uint32_t seq = nlraw_seq();
+  void *buf = malloc(NLRAW_BUFSIZE);
+  int ret, len;
+
+  if (buf == NULL) return -ENOMEM;
+  ret = nlraw_send_msg(fd, req, seq);
+  while (ret == 0) {
+    const struct nlmsghdr *nlh;
+
+    len = nlraw_recv(fd, buf);
+    if (len < 0) {
+      ret = len;
+      break;
+    }
+    for (nlh = buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+      if (nlh->nlmsg_seq != seq) continue;
+      if (nlh->nlmsg_type == NLMSG_DONE) goto out;
+      if (nlh->nlmsg_type == NLMSG_ERROR) {
+        const struct nlmsgerr *e = NLMSG_DATA(nlh);
+
+        ret = nlh->nlmsg_len >= NLMSG_LENGTH(sizeof(*e)) ? e->error : -EPROTO;
+        goto out;
+      }
+      ret = cb(nlh, arg);
+      if (ret < 0) goto out;
+    }
+  }
+out:
+  free(buf);
+  return ret;
+}
+
+int nlraw_transact(int fd, struct nlraw_req *r, nlraw_cb cb, void *arg) {
+  return nlraw_transact_msg(fd, &r->nlh, cb, arg);
+}
+
+struct genl_family {
+  const char *group;
+  int id, grp_id;
+};
+
+static int genl_family_cb(const struct nlmsghdr *nlh, void *arg) {
+  struct genl_family *f = arg;
+  const struct nlattr *a, *g, *ga;
+  int rem, grem, garem;
+
+  attr_for_each(a, genl_attrs(nlh), genl_attrs_len(nlh), rem) {
+    if (attr_type(a) == CTRL_ATTR_FAMILY_ID && attr_len(a) >= (int)sizeof(uint16_t))
+      f->id = attr_u16(a);
+    if (attr_type(a) != CTRL_ATTR_MCAST_GROUPS || f->group == NULL) continue;
+
+    /* an array of nests, each with a name and an id */
+    attr_for_each_nested(g, a, grem) {
+      const char *name = NULL;
+      int id = -1;
+
+      attr_for_each_nested(ga, g, garem) {
+        if (attr_type(ga) == CTRL_ATTR_MCAST_GRP_NAME && attr_len(ga) > 0 &&
+            ((const char *)attr_data(ga))[attr_len(ga) - 1] == '\0')
+          name = attr_data(ga);
+        if (attr_type(ga) == CTRL_ATTR_MCAST_GRP_ID && attr_len(ga) >= (int)sizeof(uint32_t))
+          id = attr_u32(ga);
+      }
+      if (name && !strcmp(name, f->group)) f->grp_id = id;
+    }
+  }
+  return 0;
+}
+
+int nlraw_genl_resolve(int fd, const char *family, const char *group, int *grp_id) {
+  struct genl_family f = {.group = group, .id = -1, .grp_id = -1};
+  struct nlraw_req r;
+  int ret;
+
+  nlraw_req_init(&r, GENL_ID_CTRL, CTRL_CMD_GETFAMILY, NLM_F_ACK);
+  r.genl.version = 1;
+  ret = nlraw_req_put(&r, CTRL_ATTR_FAMILY_NAME, family, strlen(family) + 1);
+  if (ret < 0) return ret;
+
+  ret = nlraw_transact(fd, &r, genl_family_cb, &f);
+  if (ret < 0) return ret;
+  if (f.id < 0 || (group && f.grp_id < 0)) return -ENOENT;
+  if (group) *grp_id = f.grp_id;
+  return f.id;
+}
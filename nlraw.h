@@ -0,0 +1,93 @@
+//
+// raw netlink without libnl: prebuilt requests, transactions, attribute walking
+//
+
+#ifndef NETLINK_DEMO_NLRAW_H
+#define NETLINK_DEMO_NLRAW_H
+
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Attribute walking over the linux/netlink.h layout, every attribute is
+ * visited once and bounds checked against what is left of its parent. */
+#define attr_len(a) ((int)(a)->nla_len - NLA_HDRLEN)
+#define attr_data(a) ((const void *)((const char *)(a) + NLA_HDRLEN))
+#define attr_type(a) ((a)->nla_type & NLA_TYPE_MASK)
+
+#define attr_ok(a, rem) \
+  ((rem) >= (int)sizeof(struct nlattr) && (a)->nla_len >= sizeof(struct nlattr) && (a)->nla_len <= (rem))
+#define attr_next(a, rem) \
+  ((rem) -= NLA_ALIGN((a)->nla_len), (const struct nlattr *)((const char *)(a) + NLA_ALIGN((a)->nla_len)))
+
+#define attr_for_each(a, head, len, rem) \
+  for ((a) = (head), (rem) = (len); attr_ok(a, rem); (a) = attr_next(a, rem))
+#define attr_for_each_nested(a, nest, rem) \
+  attr_for_each(a, (const struct nlattr *)attr_data(nest), attr_len(nest), rem)
+
+/* top level attributes of a generic netlink message */
+#define genl_attrs(nlh) \
+  ((const struct nlattr *)((const char *)NLMSG_DATA(nlh) + GENL_HDRLEN))
+#define genl_attrs_len(nlh) ((int)(nlh)->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN))
+
+static inline uint8_t attr_u8(const struct nlattr *a) { return *(const uint8_t *)attr_data(a); }
+static inline uint16_t attr_u16(const struct nlattr *a) { return *(const uint16_t *)attr_data(a); }
+static inline uint32_t attr_u32(const struct nlattr *a) { return *(const uint32_t *)attr_data(a); }
+static inline int8_t attr_s8(const struct nlattr *a) { return (int8_t)attr_u8(a); }
+
+/* u64 payloads are only 4 byte aligned in the message */
+static inline uint64_t attr_u64(const struct nlattr *a) {
+  uint64_t v;
+
+  memcpy(&v, attr_data(a), sizeof(v));
+  return v;
+}
+
+/* A generic netlink request built once in place and resent as is, only the
+ * sequence number changes. Room for a few small attributes. */
+#define NLRAW_REQ_ATTRS 64
+
+struct nlraw_req {
+  struct nlmsghdr nlh;
+  struct genlmsghdr genl;
+  unsigned char attrs[NLRAW_REQ_ATTRS];
+};
+
+void nlraw_req_init(struct nlraw_req *r, uint16_t family, uint8_t cmd, uint16_t flags);
+
+/* append an attribute, -EMSGSIZE if the request is full */
+int nlraw_req_put(struct nlraw_req *r, uint16_t type, const void *data, uint16_t len);
+
+static inline int nlraw_req_put_u32(struct nlraw_req *r, uint16_t type, uint32_t v) {
+  return nlraw_req_put(r, type, &v, sizeof(v));
+}
+
+/* sequence numbers are unique per process, replies are matched on them */
+uint32_t nlraw_seq(void);
+
+/* netlink socket of 'proto', the kernel assigns the port on the first send.
+ * Returns the fd or a negative errno. */
+int nlraw_open(int proto);
+
+/* returns 0 or a negative errno */
+int nlraw_send(int fd, struct nlraw_req *r, uint32_t seq);
+/* the same for any request, e.g. an rtnetlink one, 'nlh' leads it */
+int nlraw_send_msg(int fd, struct nlmsghdr *nlh, uint32_t seq);
+
+/* called for every reply of the transaction, a negative return ends it */
+typedef int (*nlraw_cb)(const struct nlmsghdr *nlh, void *arg);
+
+/* Send 'r' and hand the replies to 'cb' until NLMSG_DONE, the ACK or an
+ * error. Waits on non-blocking sockets too. Replies to other requests are
+ * dropped. Returns 0, the negative errno of the kernel, of the socket or of
+ * the callback. */
+int nlraw_transact(int fd, struct nlraw_req *r, nlraw_cb cb, void *arg);
+int nlraw_transact_msg(int fd, struct nlmsghdr *nlh, nlraw_cb cb, void *arg);
+
+/* Resolve a generic netlink family id through the controller and, if 'group'
+ * is not NULL, one of its multicast group ids into '*grp_id'. Returns the
+ * family id or a negative errno (-ENOENT: unknown family or group). */
+int nlraw_genl_resolve(int fd, const char *family, const char *group, int *grp_id);
+
+#endif // NETLINK_DEMO_NLRAW_H
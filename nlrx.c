@@ -0,0 +1,61 @@
+#define _GNU_SOURCE 1 /* recvmmsg() */
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "nlrx.h"
+
+int nlrx_init(struct nlrx *rx, unsigned nbuf, size_t bufsize) {
+  unsigned i;
+  char *p;
+
+  rx->msgs = calloc(nbuf, sizeof(*rx->msgs));
+  rx->iov = calloc(nbuf, sizeof(*rx->iov));
+  if (posix_memalign(&rx->mem, 4096, nbuf * bufsize)) rx->mem = NULL;
+  if (rx->msgs == NULL || rx->iov == NULL || rx->mem == NULL) {
+    nlrx_free(rx);
+    return -ENOMEM;
+  }
+
+  p = rx->mem;
+  for (i = 0; i < nbuf; i++, p += bufsize) {
+    rx->iov[i].iov_base = p;
+    rx->iov[i].iov_len = bufsize;
+  }
+  rx->nbuf = nbuf;
+  rx->bufsize = bufsize;
+  return 0;
+}
+
+void nlrx_free(struct nlrx *rx) {
+  free(rx->msgs);
+  free(rx->iov);
+  free(rx->mem);
+  memset(rx, 0, sizeof(*rx));
+}
+
+int nlrx_recv(struct nlrx *rx, int fd) {
+  unsigned i;
+  int n;
+
+  /* the kernel writes back msg_flags and the lengths, start from clean headers */
+  for (i = 0; i < rx->nbuf; i++) {
+    rx->msgs[i].msg_hdr = (struct msghdr){.msg_iov = &rx->iov[i], .msg_iovlen = 1};
+  }
+  do {
+    n = recvmmsg(fd, rx->msgs, rx->nbuf, MSG_DONTWAIT, NULL);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -errno;
+  return n;
+}
+
+int nlrx_rcvbuf(int fd, int bytes) {
+  socklen_t len = sizeof(bytes);
+
+  if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &bytes, sizeof(bytes)) < 0 &&
+      setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes)) < 0)
+    return -errno;
+  if (getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bytes, &len) < 0) return -errno;
+  return bytes;
+}
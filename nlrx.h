@@ -0,0 +1,48 @@
+//
+// batched netlink receive: recvmmsg() into a ring of dump sized buffers
+//
+
+#ifndef NETLINK_DEMO_NLRX_H
+#define NETLINK_DEMO_NLRX_H
+
+#include <stddef.h>
+#include <sys/socket.h>
+
+/* The kernel sizes dump datagrams after the largest buffer the reader
+ * offered, up to 32 KiB, so large buffers mean fewer datagrams and a batch
+ * of them is taken per syscall. */
+#define NLRX_BUFSIZE 32768
+#define NLRX_NBUF 16
+#define NLRX_RCVBUF (4 << 20) /* socket receive buffer asked for */
+
+struct nlrx {
+  struct mmsghdr *msgs;
+  struct iovec *iov;
+  unsigned nbuf;
+  size_t bufsize;
+  void *mem; /* all buffers in one allocation */
+};
+
+int nlrx_init(struct nlrx *rx, unsigned nbuf, size_t bufsize);
+void nlrx_free(struct nlrx *rx);
+
+/* Receive up to nbuf datagrams without blocking. Returns how many arrived, 0
+ * if none was queued, or a negative errno (-ENOBUFS: the kernel dropped
+ * notifications). Datagram i is nlrx_buf(rx, i), nlrx_len(rx, i) bytes,
+ * truncated ones (larger than bufsize) come back with length 0. */
+int nlrx_recv(struct nlrx *rx, int fd);
+
+static inline const void *nlrx_buf(const struct nlrx *rx, unsigned i) {
+  return rx->iov[i].iov_base;
+}
+
+static inline int nlrx_len(const struct nlrx *rx, unsigned i) {
+  return rx->msgs[i].msg_hdr.msg_flags & MSG_TRUNC ? 0 : (int)rx->msgs[i].msg_len;
+}
+
+/* Grow the socket receive buffer to 'bytes': SO_RCVBUFFORCE when privileged,
+ * otherwise SO_RCVBUF, which the kernel caps at net.core.rmem_max. Returns
+ * the size in effect or a negative errno. */
+int nlrx_rcvbuf(int fd, int bytes);
+
+#endif // NETLINK_DEMO_NLRX_H
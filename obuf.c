@@ -0,0 +1,137 @@
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "obuf.h"
+
+int obuf_init(struct obuf *b, int fd, size_t cap) {
+  b->data = malloc(cap);
+  if (b->data == NULL) return -ENOMEM;
+  b->len = 0;
+  b->cap = cap;
+  b->fd = fd;
+  b->err = 0;
+  b->written = 0;
+  b->writes = 0;
+  b->deadline_ns = 0;
+  return 0;
+}
+
+void obuf_free(struct obuf *b) {
+  free(b->data);
+  b->data = NULL;
+  b->len = b->cap = 0;
+}
+
+static uint64_t obuf_now_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void obuf_deadline(struct obuf *b, unsigned ms) {
+  b->deadline_ns = ms ? obuf_now_ns() + ms * 1000000ULL : 0;
+}
+
+/* wait until the fd takes more or the deadline passes, 0 or a negative errno */
+static int obuf_wait(const struct obuf *b) {
+  struct pollfd pfd = {.fd = b->fd, .events = POLLOUT};
+  uint64_t now = obuf_now_ns();
+  int n;
+
+  if (now >= b->deadline_ns) return -ETIMEDOUT;
+  n = poll(&pfd, 1, (b->deadline_ns - now + 999999) / 1000000);
+  if (n < 0) return errno == EINTR ? 0 : -errno;
+  return n ? 0 : -ETIMEDOUT;
+}
+
+int obuf_flush(struct obuf *b) {
+  size_t off = 0;
+
+  while (off < b->len && !b->err) {
+    ssize_t n = write(b->fd, b->data + off, b->len - off);
+
+    b->writes++;
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      b->err = errno == EAGAIN && b->deadline_ns ? obuf_wait(b) : -errno;
+    } else {
+      off += n;
+      b->written += n;
+    }
+  }
+  b->len = 0; /* drop what could not be written, the error is kept */
+  return b->err;
+}
+
+char *obuf_reserve(struct obuf *b, size_t n) {
+  if (n > b->cap) return NULL;
+  if (b->cap - b->len < n) obuf_flush(b);
+  return b->data + b->len;
+}
+
+void obuf_write(struct obuf *b, const void *p, size_t n) {
+  while (n) {
+    size_t room;
+
+    if (b->len == b->cap) obuf_flush(b);
+    room = b->cap - b->len;
+    if (room > n) room = n;
+    memcpy(b->data + b->len, p, room);
+    b->len += room;
+    p = (const char *)p + room;
+    n -= room;
+  }
+}
+
+void obuf_puts(struct obuf *b, const char *s) {
+  obuf_write(b, s, strlen(s));
+}
+
+void obuf_printf(struct obuf *b, const char *fmt, ...) {
+  va_list ap;
+  size_t room = b->cap - b->len;
+  int n;
+
+  va_start(ap, fmt);
+  n = vsnprintf(b->data + b->len, room, fmt, ap);
+  va_end(ap);
+  if (n < 0) return;
+  if ((size_t)n < room) {
+    b->len += n;
+    return;
+  }
+
+  /* did not fit, retry on an empty buffer */
+  if (!obuf_reserve(b, (size_t)n + 1)) return;
+  va_start(ap, fmt);
+  n = vsnprintf(b->data + b->len, b->cap - b->len, fmt, ap);
+  va_end(ap);
+  if (n > 0) b->len += n;
+}
+
+/* the JSON and CSV formatters print mostly counters, skip vsnprintf for them */
+void obuf_u64(struct obuf *b, uint64_t v) {
+  char tmp[20], *p = tmp + sizeof tmp;
+
+  do {
+    *--p = '0' + v % 10;
+    v /= 10;
+  } while (v);
+  obuf_write(b, p, tmp + sizeof tmp - p);
+}
+
+void obuf_s64(struct obuf *b, int64_t v) {
+  if (v < 0) {
+    obuf_putc(b, '-');
+    obuf_u64(b, -(uint64_t)v);
+  } else {
+    obuf_u64(b, v);
+  }
+}
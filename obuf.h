@@ -0,0 +1,51 @@
+//
+// buffered output writer, one write() per flush
+//
+
+#ifndef NETLINK_DEMO_OBUF_H
+#define NETLINK_DEMO_OBUF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OBUF_SIZE (1 << 20) /* a 2000 station JSON dump takes one or two writes */
+
+/* Formatters append into 'data', the owner calls obuf_flush() once per dump
+ * round. When the buffer fills up it is flushed early rather than grown. */
+struct obuf {
+  char *data;
+  size_t len, cap;
+  int fd;
+  int err;          /* first write error, negative errno, sticky */
+  uint64_t written; /* bytes written out since obuf_init(), the owner may zero it */
+  uint64_t writes;  /* write() calls, the same */
+  uint64_t deadline_ns; /* obuf_deadline(), CLOCK_MONOTONIC, 0 if none */
+};
+
+int obuf_init(struct obuf *b, int fd, size_t cap);
+void obuf_free(struct obuf *b);
+
+/* write out everything buffered so far, returns 0 or b->err */
+int obuf_flush(struct obuf *b);
+
+/* For a non-blocking fd: flushes wait for room until 'ms' from now, in all,
+ * and then fail with -ETIMEDOUT. 0 removes the deadline, EAGAIN then fails
+ * the flush at once. */
+void obuf_deadline(struct obuf *b, unsigned ms);
+
+/* room for at least 'n' more bytes, flushing first if needed; NULL if 'n' is
+ * larger than the whole buffer */
+char *obuf_reserve(struct obuf *b, size_t n);
+
+void obuf_write(struct obuf *b, const void *p, size_t n);
+void obuf_puts(struct obuf *b, const char *s);
+void obuf_printf(struct obuf *b, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void obuf_u64(struct obuf *b, uint64_t v);
+void obuf_s64(struct obuf *b, int64_t v);
+
+static inline void obuf_putc(struct obuf *b, char c) {
+  if (b->len == b->cap && !obuf_reserve(b, 1)) return;
+  b->data[b->len++] = c;
+}
+
+#endif // NETLINK_DEMO_OBUF_H
@@ -0,0 +1,389 @@
+#include <arpa/inet.h>      /* inet_ntop() */
+#include <linux/nl80211.h> /* 802.11 netlink interface */
+#include <linux/rtnetlink.h> /* RTM_NEWNEIGH */
+#include <net/if.h>        /* if_indextoname() */
+#include <string.h>
+
+#include "link.h"
+#include "nl80211_attrs_map.h" /* netlink attribute types names, generated */
+#include "output.h"
+
+enum plink_state {
+  LISTEN,
+  OPN_SNT,
+  OPN_RCVD,
+  CNF_RCVD,
+  ESTAB,
+  HOLDING,
+  BLOCKED
+};
+
+static const char *get_nl_attr_type(unsigned type) {
+  if (type < sizeof nl_attr_names / sizeof nl_attr_names[0] && nl_attr_names[type])
+    return nl_attr_names[type];
+  return "unknown";
+}
+
+const char *station_out_ifname(struct station_out *out, uint32_t ifindex) {
+  if (out->links) {
+    const char *name = link_cache_name(out->links, ifindex);
+
+    return name ? name : "";
+  }
+  if (out->ifindex != ifindex) {
+    out->ifindex = ifindex;
+    if (!if_indextoname(ifindex, out->ifname)) out->ifname[0] = '\0';
+  }
+  return out->ifname;
+}
+
+const char *station_power_mode_name(uint32_t pm) {
+  switch (pm) {
+  case NL80211_MESH_POWER_ACTIVE:
+    return "ACTIVE";
+  case NL80211_MESH_POWER_LIGHT_SLEEP:
+    return "LIGHT SLEEP";
+  case NL80211_MESH_POWER_DEEP_SLEEP:
+    return "DEEP SLEEP";
+  default:
+    return "UNKNOWN";
+  }
+}
+
+const char *station_event_name(uint8_t event) {
+  switch (event) {
+  case NL80211_CMD_NEW_STATION:
+    return "joined";
+  case NL80211_CMD_DEL_STATION:
+    return "left";
+  case RTM_NEWNEIGH:
+    return "neigh";
+  case RTM_DELNEIGH:
+    return "neigh-del";
+  default:
+    return NULL;
+  }
+}
+
+const char *station_plink_state_name(uint8_t state) {
+  switch (state) {
+  case LISTEN:
+    return "LISTEN";
+  case OPN_SNT:
+    return "OPN_SNT";
+  case OPN_RCVD:
+    return "OPN_RCVD";
+  case CNF_RCVD:
+    return "CNF_RCVD";
+  case ESTAB:
+    return "ESTAB";
+  case HOLDING:
+    return "HOLDING";
+  case BLOCKED:
+    return "BLOCKED";
+  default:
+    return "UNKNOWN";
+  }
+}
+
+static void print_chain_signal(struct obuf *b, const int8_t *chains, int n) {
+  int i;
+
+  for (i = 0; i < n; i++)
+    obuf_printf(b, "%s%d", i ? ", " : "[", chains[i]);
+  if (n) obuf_puts(b, "] ");
+}
+
+static void print_bitrate(struct obuf *b, const struct station_rate *r) {
+  if (r->bitrate > 0)
+    obuf_printf(b, "%u.%u MBit/s", r->bitrate / 10, r->bitrate % 10);
+  else
+    obuf_puts(b, "(unknown)");
+
+  if (r->flags & STA_RATE_MCS) obuf_printf(b, " MCS %d", r->mcs);
+  if (r->flags & STA_RATE_VHT_MCS) obuf_printf(b, " VHT-MCS %d", r->vht_mcs);
+  if (r->flags & STA_RATE_40MHZ) obuf_puts(b, " 40MHz");
+  if (r->flags & STA_RATE_80MHZ) obuf_puts(b, " 80MHz");
+  if (r->flags & STA_RATE_80P80MHZ) obuf_puts(b, " 80P80MHz");
+  if (r->flags & STA_RATE_160MHZ) obuf_puts(b, " 160MHz");
+  if (r->flags & STA_RATE_320MHZ) obuf_puts(b, " 320MHz");
+  if (r->flags & STA_RATE_SHORT_GI) obuf_puts(b, " short GI");
+  if (r->flags & STA_RATE_VHT_NSS) obuf_printf(b, " VHT-NSS %d", r->vht_nss);
+  if (r->flags & STA_RATE_HE_MCS) obuf_printf(b, " HE-MCS %d", r->he_mcs);
+  if (r->flags & STA_RATE_HE_NSS) obuf_printf(b, " HE-NSS %d", r->he_nss);
+  if (r->flags & STA_RATE_HE_GI) obuf_printf(b, " HE-GI %d", r->he_gi);
+  if (r->flags & STA_RATE_HE_DCM) obuf_printf(b, " HE-DCM %d", r->he_dcm);
+  if (r->flags & STA_RATE_HE_RU_ALLOC) obuf_printf(b, " HE-RU-ALLOC %d", r->he_ru_alloc);
+  if (r->flags & STA_RATE_EHT_MCS) obuf_printf(b, " EHT-MCS %d", r->eht_mcs);
+  if (r->flags & STA_RATE_EHT_NSS) obuf_printf(b, " EHT-NSS %d", r->eht_nss);
+  if (r->flags & STA_RATE_EHT_GI) obuf_printf(b, " EHT-GI %d", r->eht_gi);
+  if (r->flags & STA_RATE_EHT_RU_ALLOC) obuf_printf(b, " EHT-RU-ALLOC %d", r->eht_ru_alloc);
+}
+
+static void print_tid_stats(struct obuf *b, const struct station_sample *s) {
+  static const char *const txq_spacer[NL80211_TXQ_STATS_TX_PACKETS + 1] = {
+      [NL80211_TXQ_STATS_BACKLOG_BYTES] = "\t",
+      [NL80211_TXQ_STATS_BACKLOG_PACKETS] = "\t",
+      [NL80211_TXQ_STATS_FLOWS] = "\t",
+      [NL80211_TXQ_STATS_DROPS] = "\t",
+      [NL80211_TXQ_STATS_ECN_MARKS] = "\t",
+      [NL80211_TXQ_STATS_OVERLIMIT] = "\t",
+      [NL80211_TXQ_STATS_COLLISIONS] = "\t",
+      [NL80211_TXQ_STATS_TX_BYTES] = "\t",
+      [NL80211_TXQ_STATS_TX_PACKETS] = "\t\t",
+  };
+  int i, j, foundtxq = 0;
+
+  obuf_puts(b, "\n\tMSDU:\n\t\tTID\trx\ttx\ttx retries\ttx failed");
+  for (i = 0; i < s->ntids; i++) {
+    const struct station_tid *tid = &s->tid[i];
+
+    obuf_printf(b, "\n\t\t%d", i);
+    if (tid->present & (1 << NL80211_TID_STATS_RX_MSDU))
+      obuf_printf(b, "\t%llu", (unsigned long long)tid->rx_msdu);
+    if (tid->present & (1 << NL80211_TID_STATS_TX_MSDU))
+      obuf_printf(b, "\t%llu", (unsigned long long)tid->tx_msdu);
+    if (tid->present & (1 << NL80211_TID_STATS_TX_MSDU_RETRIES))
+      obuf_printf(b, "\t%llu", (unsigned long long)tid->tx_msdu_retries);
+    if (tid->present & (1 << NL80211_TID_STATS_TX_MSDU_FAILED))
+      obuf_printf(b, "\t\t%llu", (unsigned long long)tid->tx_msdu_failed);
+  }
+
+  for (i = 0; i < s->ntids; i++) {
+    const struct station_tid *tid = &s->tid[i];
+
+    if (!(tid->present & (1 << NL80211_TID_STATS_TXQ_STATS))) continue;
+    if (!foundtxq)
+      obuf_puts(b, "\n\tTXQs:\n\t\tTID\tqsz-byt\tqsz-pkt\tflows\tdrops\tmarks\toverlmt\t"
+                   "hashcol\ttx-bytes\ttx-packets");
+    foundtxq = 1;
+    obuf_printf(b, "\n\t\t%d", i);
+    for (j = NL80211_TXQ_STATS_BACKLOG_BYTES; j <= NL80211_TXQ_STATS_TX_PACKETS; j++) {
+      if (!txq_spacer[j]) continue;
+      obuf_puts(b, txq_spacer[j]);
+      if (tid->txq_present & (1 << j)) obuf_printf(b, "%u", tid->txq[j]);
+    }
+  }
+}
+
+static void print_bss_param(struct obuf *b, const struct station_bss_param *bss) {
+  if (bss->flags & STA_BSS_DTIM_PERIOD)
+    obuf_printf(b, "\n\tDTIM period:\t%u", bss->dtim_period);
+  if (bss->flags & STA_BSS_BEACON_INTERVAL)
+    obuf_printf(b, "\n\tbeacon interval:%u", bss->beacon_interval);
+  if (bss->flags & STA_BSS_CTS_PROT)
+    obuf_puts(b, "\n\tCTS protection:\tyes");
+  if (bss->flags & STA_BSS_SHORT_PREAMBLE)
+    obuf_puts(b, "\n\tshort preamble:\tyes");
+  if (bss->flags & STA_BSS_SHORT_SLOT_TIME)
+    obuf_puts(b, "\n\tshort slot time:yes");
+}
+
+static void print_delta(struct obuf *b, const struct station_delta *d) {
+  obuf_printf(b, "\n\tinterval:\t%u ms", d->interval_ms);
+  if (d->present & STA_BIT(RX_BYTES))
+    obuf_printf(b, "\n\trx bytes/s:\t%.0f (+%llu)", d->rx_bytes_rate,
+                (unsigned long long)d->rx_bytes);
+  if (d->present & STA_BIT(RX_PACKETS))
+    obuf_printf(b, "\n\trx packets/s:\t%.1f (+%u)", d->rx_packets_rate, d->rx_packets);
+  if (d->present & STA_BIT(TX_BYTES))
+    obuf_printf(b, "\n\ttx bytes/s:\t%.0f (+%llu)", d->tx_bytes_rate,
+                (unsigned long long)d->tx_bytes);
+  if (d->present & STA_BIT(TX_PACKETS))
+    obuf_printf(b, "\n\ttx packets/s:\t%.1f (+%u)", d->tx_packets_rate, d->tx_packets);
+  if (d->present & STA_BIT(TX_RETRIES))
+    obuf_printf(b, "\n\ttx retry ratio:\t%.3f (+%u)", d->retry_ratio, d->tx_retries);
+  if (d->present & STA_BIT(TX_FAILED))
+    obuf_printf(b, "\n\ttx fail ratio:\t%.3f (+%u)", d->fail_ratio, d->tx_failed);
+  if (d->present & STA_BIT(BEACON_LOSS))
+    obuf_printf(b, "\n\tbeacon loss:\t+%u", d->beacon_loss);
+  if (d->present & STA_BIT(RX_DROP_MISC))
+    obuf_printf(b, "\n\trx drop misc:\t+%llu", (unsigned long long)d->rx_drop_misc);
+}
+
+static void print_addr(struct obuf *b, const char *label, int af, const void *addr) {
+  char buf[INET6_ADDRSTRLEN];
+
+  if (inet_ntop(af, addr, buf, sizeof(buf))) obuf_printf(b, "\n\t%s%s", label, buf);
+}
+
+static void print_sta_flag(struct obuf *b, const struct nl80211_sta_flag_update *fl, uint32_t flag,
+                           const char *label, const char *yes, const char *no) {
+  if (!(fl->mask & flag)) return;
+  obuf_printf(b, "\n\t%s%s", label, fl->set & flag ? yes : no);
+}
+
+static void fmt_text_sample(struct station_out *out, const struct station_sample *s) {
+  struct obuf *b = &out->ob;
+  int i;
+
+  if (s->event)
+    obuf_printf(b, "event: %s\n", station_event_name(s->event));
+  for (i = 0; i < s->nattrs; i++)
+    obuf_printf(b, "attr. type: %d %s\n", s->attrs[i], get_nl_attr_type(s->attrs[i]));
+
+  if (STA_HAS(s, IFINDEX))
+    obuf_printf(b, "dev idx: %u if: %s\n", s->ifindex, station_out_ifname(out, s->ifindex));
+  if (STA_HAS(s, MAC))
+    obuf_printf(b, "mac: %02X:%02X:%02X:%02X:%02X:%02X\n",
+                s->mac[0], s->mac[1], s->mac[2], s->mac[3], s->mac[4], s->mac[5]);
+
+  if (STA_HAS(s, INACTIVE_TIME))
+    obuf_printf(b, "\n\tinactive time:\t%u ms", s->inactive_time);
+  if (STA_HAS(s, RX_BYTES))
+    obuf_printf(b, "\n\trx bytes:\t%llu", (unsigned long long)s->rx_bytes);
+  if (STA_HAS(s, RX_PACKETS))
+    obuf_printf(b, "\n\trx packets:\t%u", s->rx_packets);
+  if (STA_HAS(s, TX_BYTES))
+    obuf_printf(b, "\n\ttx bytes:\t%llu", (unsigned long long)s->tx_bytes);
+  if (STA_HAS(s, TX_PACKETS))
+    obuf_printf(b, "\n\ttx packets:\t%u", s->tx_packets);
+  if (STA_HAS(s, TX_RETRIES))
+    obuf_printf(b, "\n\ttx retries:\t%u", s->tx_retries);
+  if (STA_HAS(s, TX_FAILED))
+    obuf_printf(b, "\n\ttx failed:\t%u", s->tx_failed);
+  if (STA_HAS(s, BEACON_LOSS))
+    obuf_printf(b, "\n\tbeacon loss:\t%u", s->beacon_loss);
+  if (STA_HAS(s, BEACON_RX))
+    obuf_printf(b, "\n\tbeacon rx:\t%llu", (unsigned long long)s->beacon_rx);
+  if (STA_HAS(s, RX_DROP_MISC))
+    obuf_printf(b, "\n\trx drop misc:\t%llu", (unsigned long long)s->rx_drop_misc);
+
+  if (STA_HAS(s, SIGNAL)) {
+    obuf_printf(b, "\n\tsignal:  \t%d ", s->signal);
+    if (STA_HAS(s, CHAIN_SIGNAL)) print_chain_signal(b, s->chain_signal, s->chains);
+    obuf_puts(b, "dBm");
+  }
+  if (STA_HAS(s, SIGNAL_AVG)) {
+    obuf_printf(b, "\n\tsignal avg:\t%d ", s->signal_avg);
+    if (STA_HAS(s, CHAIN_SIGNAL_AVG)) print_chain_signal(b, s->chain_signal_avg, s->chains_avg);
+    obuf_puts(b, "dBm");
+  }
+  if (STA_HAS(s, BEACON_SIGNAL_AVG))
+    obuf_printf(b, "\n\tbeacon signal avg:\t%d dBm", s->beacon_signal_avg);
+  if (STA_HAS(s, T_OFFSET))
+    obuf_printf(b, "\n\tToffset:\t%llu us", (unsigned long long)s->t_offset);
+
+  if (STA_HAS(s, TX_BITRATE)) {
+    obuf_puts(b, "\n\ttx bitrate:\t");
+    print_bitrate(b, &s->tx_rate);
+  }
+  if (STA_HAS(s, TX_DURATION))
+    obuf_printf(b, "\n\ttx duration:\t%llu us", (unsigned long long)s->tx_duration);
+  if (STA_HAS(s, RX_BITRATE)) {
+    obuf_puts(b, "\n\trx bitrate:\t");
+    print_bitrate(b, &s->rx_rate);
+  }
+  if (STA_HAS(s, RX_DURATION))
+    obuf_printf(b, "\n\trx duration:\t%llu us", (unsigned long long)s->rx_duration);
+
+  if (STA_HAS(s, ACK_SIGNAL))
+    obuf_printf(b, "\n\tlast ack signal:%d dBm", s->ack_signal);
+  if (STA_HAS(s, ACK_SIGNAL_AVG))
+    obuf_printf(b, "\n\tavg ack signal:\t%d dBm", s->ack_signal_avg);
+  if (STA_HAS(s, AIRTIME_WEIGHT))
+    obuf_printf(b, "\n\tairtime weight: %d", s->airtime_weight);
+  if (STA_HAS(s, EXPECTED_THROUGHPUT)) {
+    /* convert in Mbps but scale by 1000 to save kbps units */
+    uint32_t thr = s->expected_throughput * 1000 / 1024;
+
+    obuf_printf(b, "\n\texpected throughput:\t%u.%uMbps", thr / 1000, thr % 1000);
+  }
+
+  if (STA_HAS(s, LLID))
+    obuf_printf(b, "\n\tmesh llid:\t%d", s->llid);
+  if (STA_HAS(s, PLID))
+    obuf_printf(b, "\n\tmesh plid:\t%d", s->plid);
+  if (STA_HAS(s, PLINK_STATE))
+    obuf_printf(b, "\n\tmesh plink:\t%s", station_plink_state_name(s->plink_state));
+  if (STA_HAS(s, AIRTIME_LINK_METRIC))
+    obuf_printf(b, "\n\tmesh airtime link metric: %d", s->airtime_link_metric);
+  if (STA_HAS(s, CONNECTED_TO_GATE))
+    obuf_printf(b, "\n\tmesh connected to gate:\t%s", s->connected_to_gate ? "yes" : "no");
+  if (STA_HAS(s, CONNECTED_TO_AS))
+    obuf_printf(b, "\n\tmesh connected to auth server:\t%s", s->connected_to_as ? "yes" : "no");
+  if (STA_HAS(s, LOCAL_PM))
+    obuf_printf(b, "\n\tmesh local PS mode:\t%s", station_power_mode_name(s->local_pm));
+  if (STA_HAS(s, PEER_PM))
+    obuf_printf(b, "\n\tmesh peer PS mode:\t%s", station_power_mode_name(s->peer_pm));
+  if (STA_HAS(s, NONPEER_PM))
+    obuf_printf(b, "\n\tmesh non-peer PS mode:\t%s", station_power_mode_name(s->nonpeer_pm));
+
+  if (STA_HAS(s, STA_FLAGS)) {
+    const struct nl80211_sta_flag_update *fl = &s->sta_flags;
+
+    print_sta_flag(b, fl, 1 << NL80211_STA_FLAG_AUTHORIZED, "authorized:\t", "yes", "no");
+    print_sta_flag(b, fl, 1 << NL80211_STA_FLAG_AUTHENTICATED, "authenticated:\t", "yes", "no");
+    print_sta_flag(b, fl, 1 << NL80211_STA_FLAG_ASSOCIATED, "associated:\t", "yes", "no");
+    print_sta_flag(b, fl, 1 << NL80211_STA_FLAG_SHORT_PREAMBLE, "preamble:\t", "short", "long");
+    print_sta_flag(b, fl, 1 << NL80211_STA_FLAG_WME, "WMM/WME:\t", "yes", "no");
+    print_sta_flag(b, fl, 1 << NL80211_STA_FLAG_MFP, "MFP:\t\t", "yes", "no");
+    print_sta_flag(b, fl, 1 << NL80211_STA_FLAG_TDLS_PEER, "TDLS peer:\t", "yes", "no");
+  }
+
+  if (STA_HAS(s, TID_STATS) && out->verbose)
+    print_tid_stats(b, s);
+  if (STA_HAS(s, BSS_PARAM))
+    print_bss_param(b, &s->bss_param);
+  if (STA_HAS(s, CONNECTED_TIME))
+    obuf_printf(b, "\n\tconnected time:\t%u seconds", s->connected_time);
+  if (STA_HAS(s, ASSOC_AT_BOOTTIME)) {
+    unsigned long long bt = s->assoc_at_boottime;
+
+    obuf_printf(b, "\n\tassociated at [boottime]:\t%llu.%.3llus",
+                bt / 1000000000, (bt % 1000000000) / 1000000);
+    obuf_printf(b, "\n\tassociated at:\t%llu ms",
+                (unsigned long long)(s->now_ms - ((s->boot_ns - bt) / 1000000)));
+  }
+
+  if (STA_HAS(s, DELTA))
+    print_delta(b, &s->delta);
+  if (STA_HAS(s, IPV4))
+    print_addr(b, "ipv4 address:\t", AF_INET, s->ipv4);
+  if (STA_HAS(s, IPV6))
+    print_addr(b, "ipv6 address:\t", AF_INET6, s->ipv6);
+
+  obuf_printf(b, "\n\tcurrent time:\t%llu ms\n", (unsigned long long)s->now_ms);
+}
+
+/* notifications are prefixed with + (joined), - (left) or ~ (neighbour) */
+static void fmt_brief_sample(struct station_out *out, const struct station_sample *s) {
+  const char *mark = "";
+
+  if (!STA_HAS(s, MAC)) return;
+  if (s->event == NL80211_CMD_NEW_STATION)
+    mark = "+";
+  else if (s->event == NL80211_CMD_DEL_STATION)
+    mark = "-";
+  else if (s->event)
+    mark = "~";
+  obuf_printf(&out->ob, "%s%02X:%02X:%02X:%02X:%02X:%02X\n", mark,
+              s->mac[0], s->mac[1], s->mac[2], s->mac[3], s->mac[4], s->mac[5]);
+}
+
+const struct station_formatter station_fmt_text = {
+    .name = "text",
+    .sample = fmt_text_sample,
+};
+
+const struct station_formatter station_fmt_brief = {
+    .name = "brief",
+    .sample = fmt_brief_sample,
+};
+
+static const struct station_formatter *const formatters[] = {
+    &station_fmt_text,
+    &station_fmt_brief,
+    &station_fmt_bin,
+    &station_fmt_json,
+    &station_fmt_csv,
+};
+
+const struct station_formatter *station_formatter_find(const char *name) {
+  size_t i;
+
+  for (i = 0; i < sizeof formatters / sizeof formatters[0]; i++) {
+    if (!strcmp(formatters[i]->name, name)) return formatters[i];
+  }
+  return NULL;
+}
@@ -0,0 +1,55 @@
+//
+// station sample formatters
+//
+
+#ifndef NETLINK_DEMO_OUTPUT_H
+#define NETLINK_DEMO_OUTPUT_H
+
+#include <net/if.h> /* IF_NAMESIZE */
+
+#include "obuf.h"
+#include "station.h"
+
+struct station_out;
+struct link_cache;
+
+struct station_formatter {
+  const char *name;
+  /* called for every decoded station */
+  void (*sample)(struct station_out *out, const struct station_sample *s);
+  /* called once after every dump round, may be NULL */
+  void (*flush)(struct station_out *out);
+};
+
+/* Formatters only append to 'ob', the owner writes it out once per dump
+ * round after fmt->flush(). */
+struct station_out {
+  const struct station_formatter *fmt;
+  struct obuf ob;
+  int verbose; /* text, json: print per TID statistics */
+  int started; /* formatter wrote its stream header */
+  uint64_t fields; /* -f: STA_BIT()s the csv and bin layouts keep, 0 for all */
+  const struct link_cache *links; /* interface names, NULL: if_indextoname() */
+  uint32_t ifindex; /* station_out_ifname() cache without 'links' */
+  char ifname[IF_NAMESIZE];
+};
+
+extern const struct station_formatter station_fmt_text;
+extern const struct station_formatter station_fmt_brief;
+extern const struct station_formatter station_fmt_bin;  /* output_bin.c */
+extern const struct station_formatter station_fmt_json; /* output_line.c */
+extern const struct station_formatter station_fmt_csv;  /* output_line.c */
+
+/* look a formatter up by name, NULL if unknown */
+const struct station_formatter *station_formatter_find(const char *name);
+
+/* interface name of 'ifindex', "" if unknown. Taken from 'links' when
+ * set; otherwise the last lookup is cached since a dump returns the
+ * stations of one interface back to back. */
+const char *station_out_ifname(struct station_out *out, uint32_t ifindex);
+
+const char *station_plink_state_name(uint8_t state);
+const char *station_event_name(uint8_t event); /* NULL for dump samples */
+const char *station_power_mode_name(uint32_t pm);
+
+#endif // NETLINK_DEMO_OUTPUT_H
@@ -0,0 +1,235 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "output.h"
+#include "station_bin.h"
+
+#define MEMBER(f) (((struct station_record *)0)->f)
+#define FIELD(f, t, b)                                                       \
+  {                                                                          \
+    .d = {.name = #f, .offset = offsetof(struct station_record, f),          \
+          .size = sizeof MEMBER(f), .type = STATION_BIN_##t, .count = 1},    \
+    .bits = b                                                                \
+  }
+#define ARRAY(f, t, b)                                                       \
+  {                                                                          \
+    .d = {.name = #f, .offset = offsetof(struct station_record, f),          \
+          .size = sizeof MEMBER(f)[0], .type = STATION_BIN_##t,              \
+          .count = sizeof MEMBER(f) / sizeof MEMBER(f)[0]},                  \
+    .bits = b                                                                \
+  }
+
+/* a descriptor and the STA_BIT()s -f has to select for it, 0: always kept */
+struct record_field {
+  struct station_bin_field d;
+  uint64_t bits;
+};
+
+static const struct record_field record_fields[] = {
+    FIELD(ts_ms, UINT, 0),
+    FIELD(present, UINT, 0),
+    FIELD(rx_bytes, UINT, STA_BIT(RX_BYTES)),
+    FIELD(tx_bytes, UINT, STA_BIT(TX_BYTES)),
+    FIELD(rx_drop_misc, UINT, STA_BIT(RX_DROP_MISC)),
+    FIELD(beacon_rx, UINT, STA_BIT(BEACON_RX)),
+    FIELD(tx_duration, UINT, STA_BIT(TX_DURATION)),
+    FIELD(rx_duration, UINT, STA_BIT(RX_DURATION)),
+    FIELD(delta_rx_bytes, UINT, STA_BIT(DELTA)),
+    FIELD(delta_tx_bytes, UINT, STA_BIT(DELTA)),
+    FIELD(delta_rx_drop_misc, UINT, STA_BIT(DELTA)),
+    FIELD(ifindex, UINT, STA_BIT(IFINDEX)),
+    FIELD(generation, UINT, STA_BIT(GENERATION)),
+    FIELD(inactive_time, UINT, STA_BIT(INACTIVE_TIME)),
+    FIELD(connected_time, UINT, STA_BIT(CONNECTED_TIME)),
+    FIELD(rx_packets, UINT, STA_BIT(RX_PACKETS)),
+    FIELD(tx_packets, UINT, STA_BIT(TX_PACKETS)),
+    FIELD(tx_retries, UINT, STA_BIT(TX_RETRIES)),
+    FIELD(tx_failed, UINT, STA_BIT(TX_FAILED)),
+    FIELD(beacon_loss, UINT, STA_BIT(BEACON_LOSS)),
+    FIELD(expected_throughput, UINT, STA_BIT(EXPECTED_THROUGHPUT)),
+    FIELD(tx_bitrate, UINT, STA_BIT(TX_BITRATE)),
+    FIELD(rx_bitrate, UINT, STA_BIT(RX_BITRATE)),
+    FIELD(tx_rate_flags, UINT, STA_BIT(TX_BITRATE)),
+    FIELD(rx_rate_flags, UINT, STA_BIT(RX_BITRATE)),
+    FIELD(sta_flags_mask, UINT, STA_BIT(STA_FLAGS)),
+    FIELD(sta_flags_set, UINT, STA_BIT(STA_FLAGS)),
+    FIELD(delta_interval_ms, UINT, STA_BIT(DELTA)),
+    FIELD(delta_rx_packets, UINT, STA_BIT(DELTA)),
+    FIELD(delta_tx_packets, UINT, STA_BIT(DELTA)),
+    FIELD(delta_tx_retries, UINT, STA_BIT(DELTA)),
+    FIELD(delta_tx_failed, UINT, STA_BIT(DELTA)),
+    FIELD(delta_beacon_loss, UINT, STA_BIT(DELTA)),
+    ARRAY(mac, BYTES, STA_BIT(MAC)),
+    FIELD(signal, INT, STA_BIT(SIGNAL)),
+    FIELD(signal_avg, INT, STA_BIT(SIGNAL_AVG)),
+    FIELD(ack_signal, INT, STA_BIT(ACK_SIGNAL)),
+    FIELD(ack_signal_avg, INT, STA_BIT(ACK_SIGNAL_AVG)),
+    FIELD(beacon_signal_avg, INT, STA_BIT(BEACON_SIGNAL_AVG)),
+    FIELD(chains, UINT, STA_BIT(CHAIN_SIGNAL)),
+    ARRAY(chain_signal, INT, STA_BIT(CHAIN_SIGNAL)),
+    FIELD(tx_mcs, UINT, STA_BIT(TX_BITRATE)),
+    FIELD(rx_mcs, UINT, STA_BIT(RX_BITRATE)),
+    FIELD(tx_nss, UINT, STA_BIT(TX_BITRATE)),
+    FIELD(rx_nss, UINT, STA_BIT(RX_BITRATE)),
+    FIELD(event, UINT, 0),
+    ARRAY(ipv4, BYTES, STA_BIT(IPV4)),
+    ARRAY(ipv6, BYTES, STA_BIT(IPV6)),
+};
+
+_Static_assert(offsetof(struct station_record, reserved) + sizeof MEMBER(reserved) ==
+                   sizeof(struct station_record),
+               "station_record has padding");
+_Static_assert(STATION_MAX_CHAINS == sizeof MEMBER(chain_signal), "chain_signal size");
+
+/* the most specific MCS/NSS the driver reported */
+static uint8_t rate_mcs(const struct station_rate *r) {
+  if (r->flags & STA_RATE_EHT_MCS) return r->eht_mcs;
+  if (r->flags & STA_RATE_HE_MCS) return r->he_mcs;
+  if (r->flags & STA_RATE_VHT_MCS) return r->vht_mcs;
+  return r->mcs;
+}
+
+static uint8_t rate_nss(const struct station_rate *r) {
+  if (r->flags & STA_RATE_EHT_NSS) return r->eht_nss;
+  if (r->flags & STA_RATE_HE_NSS) return r->he_nss;
+  if (r->flags & STA_RATE_VHT_NSS) return r->vht_nss;
+  return 0;
+}
+
+#define NFIELDS (sizeof record_fields / sizeof record_fields[0])
+
+/* With -f the records are cut to the selected fields, packed in table order;
+ * that is struct order, so they stay aligned the way the struct is. */
+#define BIN_CUT(out) ((out)->fields && (out)->fields != STATION_FIELDS_ALL)
+
+static int bin_keeps(const struct station_out *out, const struct record_field *f) {
+  return !BIN_CUT(out) || !f->bits || (out->fields & f->bits);
+}
+
+static void fmt_bin_header(struct station_out *out) {
+  struct station_bin_header h = {
+      .version = STATION_BIN_VERSION,
+      .byte_order = STATION_BIN_BYTE_ORDER,
+      .record_size = sizeof(struct station_record),
+  };
+  struct station_bin_field d[NFIELDS];
+  uint16_t offset = 0;
+  size_t i;
+
+  for (i = 0; i < NFIELDS; i++) {
+    if (!bin_keeps(out, &record_fields[i])) continue;
+    d[h.nfields] = record_fields[i].d;
+    if (BIN_CUT(out)) d[h.nfields].offset = offset;
+    offset += d[h.nfields].size * d[h.nfields].count;
+    h.nfields++;
+  }
+  if (BIN_CUT(out)) h.record_size = offset;
+
+  memcpy(h.magic, STATION_BIN_MAGIC, sizeof h.magic);
+  obuf_write(&out->ob, &h, sizeof h);
+  obuf_write(&out->ob, d, h.nfields * sizeof d[0]);
+  out->started = 1;
+}
+
+/* the kept fields of 'r' back to back */
+static void fmt_bin_cut(struct station_out *out, const struct station_record *r) {
+  char buf[sizeof *r];
+  size_t i, len = 0;
+
+  for (i = 0; i < NFIELDS; i++) {
+    const struct station_bin_field *d = &record_fields[i].d;
+
+    if (!bin_keeps(out, &record_fields[i])) continue;
+    memcpy(buf + len, (const char *)r + d->offset, d->size * d->count);
+    len += d->size * d->count;
+  }
+  obuf_write(&out->ob, buf, len);
+}
+
+static void fmt_bin_sample(struct station_out *out, const struct station_sample *s) {
+  struct station_record r;
+
+  if (!out->started) fmt_bin_header(out);
+
+  /* The sample buffer is reused and only 'present' is reset by the
+   * decoder, so a field is copied only with its bit: absent fields and
+   * padding are zero in the stream. */
+  memset(&r, 0, sizeof r);
+  r.ts_ms = s->now_ms;
+  r.present = s->present;
+  r.event = s->event;
+#define COPY(f, bit) \
+  if (STA_HAS(s, bit)) r.f = s->f
+  COPY(ifindex, IFINDEX);
+  COPY(rx_bytes, RX_BYTES);
+  COPY(tx_bytes, TX_BYTES);
+  COPY(rx_drop_misc, RX_DROP_MISC);
+  COPY(beacon_rx, BEACON_RX);
+  COPY(tx_duration, TX_DURATION);
+  COPY(rx_duration, RX_DURATION);
+  COPY(generation, GENERATION);
+  COPY(inactive_time, INACTIVE_TIME);
+  COPY(connected_time, CONNECTED_TIME);
+  COPY(rx_packets, RX_PACKETS);
+  COPY(tx_packets, TX_PACKETS);
+  COPY(tx_retries, TX_RETRIES);
+  COPY(tx_failed, TX_FAILED);
+  COPY(beacon_loss, BEACON_LOSS);
+  COPY(expected_throughput, EXPECTED_THROUGHPUT);
+  COPY(signal, SIGNAL);
+  COPY(signal_avg, SIGNAL_AVG);
+  COPY(ack_signal, ACK_SIGNAL);
+  COPY(ack_signal_avg, ACK_SIGNAL_AVG);
+  COPY(beacon_signal_avg, BEACON_SIGNAL_AVG);
+#undef COPY
+  if (STA_HAS(s, MAC)) memcpy(r.mac, s->mac, sizeof r.mac);
+  if (STA_HAS(s, CHAIN_SIGNAL)) {
+    r.chains = s->chains;
+    memcpy(r.chain_signal, s->chain_signal, sizeof r.chain_signal);
+  }
+  if (STA_HAS(s, TX_BITRATE)) {
+    r.tx_bitrate = s->tx_rate.bitrate;
+    r.tx_rate_flags = s->tx_rate.flags;
+    r.tx_mcs = rate_mcs(&s->tx_rate);
+    r.tx_nss = rate_nss(&s->tx_rate);
+  }
+  if (STA_HAS(s, RX_BITRATE)) {
+    r.rx_bitrate = s->rx_rate.bitrate;
+    r.rx_rate_flags = s->rx_rate.flags;
+    r.rx_mcs = rate_mcs(&s->rx_rate);
+    r.rx_nss = rate_nss(&s->rx_rate);
+  }
+  if (STA_HAS(s, STA_FLAGS)) {
+    r.sta_flags_mask = s->sta_flags.mask;
+    r.sta_flags_set = s->sta_flags.set;
+  }
+  if (STA_HAS(s, IPV4)) memcpy(r.ipv4, s->ipv4, sizeof r.ipv4);
+  if (STA_HAS(s, IPV6)) memcpy(r.ipv6, s->ipv6, sizeof r.ipv6);
+  if (STA_HAS(s, DELTA)) { /* zero where the counter was missing */
+    r.delta_interval_ms = s->delta.interval_ms;
+    r.delta_rx_bytes = s->delta.rx_bytes;
+    r.delta_tx_bytes = s->delta.tx_bytes;
+    r.delta_rx_drop_misc = s->delta.rx_drop_misc;
+    r.delta_rx_packets = s->delta.rx_packets;
+    r.delta_tx_packets = s->delta.tx_packets;
+    r.delta_tx_retries = s->delta.tx_retries;
+    r.delta_tx_failed = s->delta.tx_failed;
+    r.delta_beacon_loss = s->delta.beacon_loss;
+  }
+
+  if (BIN_CUT(out))
+    fmt_bin_cut(out, &r);
+  else
+    obuf_write(&out->ob, &r, sizeof r);
+}
+
+/* an empty first dump still produces a valid stream */
+static void fmt_bin_flush(struct station_out *out) {
+  if (!out->started) fmt_bin_header(out);
+}
+
+const struct station_formatter station_fmt_bin = {
+    .name = "bin",
+    .sample = fmt_bin_sample,
+    .flush = fmt_bin_flush,
+};
@@ -0,0 +1,94 @@
+// absent fields of a reused sample buffer must be zero in binary records
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "output.h"
+#include "station_bin.h"
+#include "synth.h"
+
+static int failed;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond);      \
+      failed = 1;                                                     \
+    }                                                                 \
+  } while (0)
+
+/* the record the formatter appended last */
+static const struct station_record *last_record(const struct station_out *out) {
+  return (const void *)(out->ob.data + out->ob.len - sizeof(struct station_record));
+}
+
+static int synth_one(struct bench_dump *d, unsigned parts) {
+  struct synth_cfg cfg = {.stations = 1, .family_id = 31, .ifindex = 3, .parts = parts,
+                          .chains = 4};
+
+  return synth_dump(d, &cfg);
+}
+
+int main(void) {
+  struct bench_dump full = {}, min = {};
+  struct station_out out = {.fmt = &station_fmt_bin};
+  struct station_sample s;
+  const struct station_record *r;
+
+  if (synth_one(&full, SYNTH_TYPICAL | SYNTH_AIRTIME) < 0 || synth_one(&min, SYNTH_MIN) < 0 ||
+      obuf_init(&out.ob, -1, OBUF_SIZE) < 0) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  /* a station with everything, then one with only the counters */
+  CHECK(station_decode((const void *)full.data, &s, 0, STATION_FIELDS_ALL) == 0);
+  out.fmt->sample(&out, &s);
+  r = last_record(&out);
+  CHECK(r->signal != 0 && r->chains != 0 && r->tx_bitrate != 0 && r->connected_time != 0);
+
+  CHECK(station_decode((const void *)min.data, &s, 0, STATION_FIELDS_ALL) == 0);
+  out.fmt->sample(&out, &s);
+  r = last_record(&out);
+  CHECK(r->rx_bytes != 0 && r->ifindex == 3);
+  CHECK(r->signal == 0 && r->signal_avg == 0 && r->ack_signal == 0);
+  CHECK(r->chains == 0 && r->chain_signal[0] == 0);
+  CHECK(r->tx_bitrate == 0 && r->tx_rate_flags == 0 && r->tx_mcs == 0);
+  CHECK(r->rx_bitrate == 0 && r->rx_mcs == 0);
+  CHECK(r->connected_time == 0 && r->sta_flags_set == 0 && r->expected_throughput == 0);
+
+  /* the same station again, the -f projection leaving out all but rx_bytes */
+  CHECK(station_decode((const void *)full.data, &s, 0, STA_BIT(RX_BYTES)) == 0);
+  out.fmt->sample(&out, &s);
+  r = last_record(&out);
+  CHECK(r->rx_bytes != 0 && r->tx_bytes == 0 && r->signal == 0 && r->tx_bitrate == 0);
+
+  /* -f signal: only the selected descriptors, records packed to match */
+  obuf_free(&out.ob);
+  memset(&out, 0, sizeof out);
+  out.fmt = &station_fmt_bin;
+  out.fields = STA_BIT(IFINDEX) | STA_BIT(MAC) | STA_BIT(SIGNAL);
+  if (obuf_init(&out.ob, -1, OBUF_SIZE) < 0) return 1;
+  CHECK(station_decode((const void *)full.data, &s, 0, out.fields) == 0);
+  out.fmt->sample(&out, &s);
+  {
+    const struct station_bin_header *h = (const void *)out.ob.data;
+    const struct station_bin_field *d = (const void *)(h + 1);
+    const char *rec = (const char *)(d + h->nfields);
+    unsigned i;
+
+    CHECK(h->nfields == 6); /* ts_ms, present, ifindex, mac, signal, event */
+    CHECK(h->record_size == 8 + 8 + 4 + 6 + 1 + 1);
+    CHECK(out.ob.len == sizeof *h + h->nfields * sizeof *d + h->record_size);
+    for (i = 0; i < h->nfields && strcmp(d[i].name, "signal"); i++)
+      ;
+    CHECK(i < h->nfields && (int8_t)rec[d[i].offset] == s.signal);
+  }
+
+  obuf_free(&out.ob);
+  bench_dump_free(&full);
+  bench_dump_free(&min);
+  if (!failed) printf("output_bin_test: ok\n");
+  return failed;
+}
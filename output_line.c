@@ -0,0 +1,596 @@
+#include <arpa/inet.h> /* inet_ntop() */
+#include <stddef.h>
+#include <string.h>
+
+#include "output.h"
+
+/* plain counters, printed the same way by both line formats */
+enum column_type { COL_U8, COL_U16, COL_U32, COL_U64, COL_S8, COL_F64 };
+
+struct column {
+  const char *name;
+  uint8_t field; /* enum station_field */
+  uint8_t type;  /* enum column_type */
+  uint16_t offset;
+};
+
+#define COL(n, f, t) {#n, STA_F_##f, COL_##t, offsetof(struct station_sample, n)}
+
+static const struct column columns[] = {
+    COL(generation, GENERATION, U32),
+    COL(inactive_time, INACTIVE_TIME, U32),
+    COL(rx_bytes, RX_BYTES, U64),
+    COL(rx_packets, RX_PACKETS, U32),
+    COL(tx_bytes, TX_BYTES, U64),
+    COL(tx_packets, TX_PACKETS, U32),
+    COL(tx_retries, TX_RETRIES, U32),
+    COL(tx_failed, TX_FAILED, U32),
+    COL(beacon_loss, BEACON_LOSS, U32),
+    COL(beacon_rx, BEACON_RX, U64),
+    COL(rx_drop_misc, RX_DROP_MISC, U64),
+    COL(signal, SIGNAL, S8),
+    COL(signal_avg, SIGNAL_AVG, S8),
+    COL(beacon_signal_avg, BEACON_SIGNAL_AVG, S8),
+    COL(t_offset, T_OFFSET, U64),
+    COL(tx_duration, TX_DURATION, U64),
+    COL(rx_duration, RX_DURATION, U64),
+    COL(ack_signal, ACK_SIGNAL, S8),
+    COL(ack_signal_avg, ACK_SIGNAL_AVG, S8),
+    COL(airtime_weight, AIRTIME_WEIGHT, U16),
+    COL(expected_throughput, EXPECTED_THROUGHPUT, U32),
+    COL(llid, LLID, U16),
+    COL(plid, PLID, U16),
+    COL(airtime_link_metric, AIRTIME_LINK_METRIC, U32),
+    COL(connected_time, CONNECTED_TIME, U32),
+    COL(assoc_at_boottime, ASSOC_AT_BOOTTIME, U64),
+};
+
+/* station_delta, valid if the source counter bit is set in delta.present */
+#define DELTA_COL(n, f, t) {#n, STA_F_##f, COL_##t, offsetof(struct station_delta, n)}
+
+static const struct column delta_columns[] = {
+    DELTA_COL(rx_bytes, RX_BYTES, U64),
+    DELTA_COL(rx_bytes_rate, RX_BYTES, F64),
+    DELTA_COL(rx_packets, RX_PACKETS, U32),
+    DELTA_COL(rx_packets_rate, RX_PACKETS, F64),
+    DELTA_COL(tx_bytes, TX_BYTES, U64),
+    DELTA_COL(tx_bytes_rate, TX_BYTES, F64),
+    DELTA_COL(tx_packets, TX_PACKETS, U32),
+    DELTA_COL(tx_packets_rate, TX_PACKETS, F64),
+    DELTA_COL(tx_retries, TX_RETRIES, U32),
+    DELTA_COL(retry_ratio, TX_RETRIES, F64),
+    DELTA_COL(tx_failed, TX_FAILED, U32),
+    DELTA_COL(fail_ratio, TX_FAILED, F64),
+    DELTA_COL(beacon_loss, BEACON_LOSS, U32),
+    DELTA_COL(rx_drop_misc, RX_DROP_MISC, U64),
+};
+
+/* optional station_rate sub fields */
+struct rate_column {
+  const char *name;
+  uint32_t flag; /* enum station_rate_flag */
+  uint16_t offset;
+};
+
+#define RATE_COL(n, f) {#n, STA_RATE_##f, offsetof(struct station_rate, n)}
+
+static const struct rate_column rate_columns[] = {
+    RATE_COL(mcs, MCS),
+    RATE_COL(vht_mcs, VHT_MCS),
+    RATE_COL(vht_nss, VHT_NSS),
+    RATE_COL(he_mcs, HE_MCS),
+    RATE_COL(he_nss, HE_NSS),
+    RATE_COL(he_gi, HE_GI),
+    RATE_COL(he_dcm, HE_DCM),
+    RATE_COL(he_ru_alloc, HE_RU_ALLOC),
+    RATE_COL(eht_mcs, EHT_MCS),
+    RATE_COL(eht_nss, EHT_NSS),
+    RATE_COL(eht_gi, EHT_GI),
+    RATE_COL(eht_ru_alloc, EHT_RU_ALLOC),
+};
+
+/* mask bit, JSON key / CSV column */
+static const struct {
+  uint32_t flag;
+  const char *name;
+} sta_flag_columns[] = {
+    {1 << NL80211_STA_FLAG_AUTHORIZED, "authorized"},
+    {1 << NL80211_STA_FLAG_AUTHENTICATED, "authenticated"},
+    {1 << NL80211_STA_FLAG_ASSOCIATED, "associated"},
+    {1 << NL80211_STA_FLAG_SHORT_PREAMBLE, "short_preamble"},
+    {1 << NL80211_STA_FLAG_WME, "wme"},
+    {1 << NL80211_STA_FLAG_MFP, "mfp"},
+    {1 << NL80211_STA_FLAG_TDLS_PEER, "tdls_peer"},
+};
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+/* 'base' is the station_sample or station_delta the column belongs to */
+static void put_column(struct obuf *b, const void *base, const struct column *c) {
+  const void *p = (const char *)base + c->offset;
+
+  switch (c->type) {
+  case COL_U8:
+    obuf_u64(b, *(const uint8_t *)p);
+    break;
+  case COL_U16:
+    obuf_u64(b, *(const uint16_t *)p);
+    break;
+  case COL_U32:
+    obuf_u64(b, *(const uint32_t *)p);
+    break;
+  case COL_U64:
+    obuf_u64(b, *(const uint64_t *)p);
+    break;
+  case COL_S8:
+    obuf_s64(b, *(const int8_t *)p);
+    break;
+  case COL_F64:
+    obuf_printf(b, "%.3f", *(const double *)p);
+    break;
+  }
+}
+
+static void put_mac(struct obuf *b, const uint8_t *mac) {
+  static const char hex[] = "0123456789abcdef";
+  char *p = obuf_reserve(b, 17);
+  int i;
+
+  if (p == NULL) return;
+  for (i = 0; i < STATION_MAC_LEN; i++) {
+    if (i) *p++ = ':';
+    *p++ = hex[mac[i] >> 4];
+    *p++ = hex[mac[i] & 15];
+  }
+  b->len += 17;
+}
+
+/* bitrate in MBit/s with one decimal, as the text output prints it */
+static void put_bitrate(struct obuf *b, uint32_t bitrate) {
+  obuf_u64(b, bitrate / 10);
+  obuf_putc(b, '.');
+  obuf_putc(b, '0' + bitrate % 10);
+}
+
+static unsigned rate_width(const struct station_rate *r) {
+  if (r->flags & STA_RATE_320MHZ) return 320;
+  if (r->flags & (STA_RATE_160MHZ | STA_RATE_80P80MHZ)) return 160;
+  if (r->flags & STA_RATE_80MHZ) return 80;
+  if (r->flags & STA_RATE_40MHZ) return 40;
+  return 20;
+}
+
+static void put_chains(struct obuf *b, const int8_t *chains, int n, char sep) {
+  int i;
+
+  for (i = 0; i < n; i++) {
+    if (i) obuf_putc(b, sep);
+    obuf_s64(b, chains[i]);
+  }
+}
+
+/* JSON Lines */
+
+static void json_key(struct obuf *b, const char *key) {
+  obuf_puts(b, ",\"");
+  obuf_puts(b, key);
+  obuf_puts(b, "\":");
+}
+
+static void json_str(struct obuf *b, const char *str) {
+  obuf_putc(b, '"');
+  for (; *str; str++) {
+    if (*str == '"' || *str == '\\') obuf_putc(b, '\\');
+    if ((unsigned char)*str < 0x20) {
+      obuf_printf(b, "\\u%04x", *str);
+      continue;
+    }
+    obuf_putc(b, *str);
+  }
+  obuf_putc(b, '"');
+}
+
+static void json_bool(struct obuf *b, const char *key, int v) {
+  json_key(b, key);
+  obuf_puts(b, v ? "true" : "false");
+}
+
+static void json_chains(struct obuf *b, const char *key, const int8_t *chains, int n) {
+  json_key(b, key);
+  obuf_putc(b, '[');
+  put_chains(b, chains, n, ',');
+  obuf_putc(b, ']');
+}
+
+static void json_rate(struct obuf *b, const char *key, const struct station_rate *r) {
+  size_t i;
+
+  json_key(b, key);
+  obuf_puts(b, "{\"bitrate\":");
+  if (r->bitrate)
+    put_bitrate(b, r->bitrate);
+  else
+    obuf_puts(b, "null");
+  for (i = 0; i < ARRAY_SIZE(rate_columns); i++) {
+    if (!(r->flags & rate_columns[i].flag)) continue;
+    json_key(b, rate_columns[i].name);
+    obuf_u64(b, *((const uint8_t *)r + rate_columns[i].offset));
+  }
+  json_key(b, "width");
+  obuf_u64(b, rate_width(r));
+  if (r->flags & STA_RATE_80P80MHZ) json_bool(b, "80p80", 1);
+  if (r->flags & STA_RATE_SHORT_GI) json_bool(b, "short_gi", 1);
+  obuf_putc(b, '}');
+}
+
+static void json_tids(struct obuf *b, const struct station_sample *s) {
+  static const char *const msdu_keys[] = {
+      [NL80211_TID_STATS_RX_MSDU] = "rx_msdu",
+      [NL80211_TID_STATS_TX_MSDU] = "tx_msdu",
+      [NL80211_TID_STATS_TX_MSDU_RETRIES] = "tx_msdu_retries",
+      [NL80211_TID_STATS_TX_MSDU_FAILED] = "tx_msdu_failed",
+  };
+  static const char *const txq_keys[] = {
+      [NL80211_TXQ_STATS_BACKLOG_BYTES] = "backlog_bytes",
+      [NL80211_TXQ_STATS_BACKLOG_PACKETS] = "backlog_packets",
+      [NL80211_TXQ_STATS_FLOWS] = "flows",
+      [NL80211_TXQ_STATS_DROPS] = "drops",
+      [NL80211_TXQ_STATS_ECN_MARKS] = "ecn_marks",
+      [NL80211_TXQ_STATS_OVERLIMIT] = "overlimit",
+      [NL80211_TXQ_STATS_COLLISIONS] = "collisions",
+      [NL80211_TXQ_STATS_TX_BYTES] = "tx_bytes",
+      [NL80211_TXQ_STATS_TX_PACKETS] = "tx_packets",
+  };
+  int i, j;
+
+  json_key(b, "tid_stats");
+  obuf_putc(b, '[');
+  for (i = 0; i < s->ntids; i++) {
+    const struct station_tid *tid = &s->tid[i];
+    const uint64_t msdu[] = {
+        [NL80211_TID_STATS_RX_MSDU] = tid->rx_msdu,
+        [NL80211_TID_STATS_TX_MSDU] = tid->tx_msdu,
+        [NL80211_TID_STATS_TX_MSDU_RETRIES] = tid->tx_msdu_retries,
+        [NL80211_TID_STATS_TX_MSDU_FAILED] = tid->tx_msdu_failed,
+    };
+
+    obuf_puts(b, i ? ",{\"tid\":" : "{\"tid\":");
+    obuf_u64(b, i);
+    for (j = 0; j < (int)ARRAY_SIZE(msdu_keys); j++) {
+      if (!msdu_keys[j] || !(tid->present & (1 << j))) continue;
+      json_key(b, msdu_keys[j]);
+      obuf_u64(b, msdu[j]);
+    }
+    if (tid->present & (1 << NL80211_TID_STATS_TXQ_STATS)) {
+      const char *sep = "{";
+
+      json_key(b, "txq");
+      for (j = 0; j < (int)ARRAY_SIZE(txq_keys); j++) {
+        if (!txq_keys[j] || !(tid->txq_present & (1 << j))) continue;
+        obuf_puts(b, sep);
+        obuf_putc(b, '"');
+        obuf_puts(b, txq_keys[j]);
+        obuf_puts(b, "\":");
+        obuf_u64(b, tid->txq[j]);
+        sep = ",";
+      }
+      obuf_puts(b, *sep == '{' ? "{}" : "}");
+    }
+    obuf_putc(b, '}');
+  }
+  obuf_putc(b, ']');
+}
+
+/* AF_INET or AF_INET6 address, network order */
+static void put_addr(struct obuf *b, int af, const void *addr) {
+  char buf[INET6_ADDRSTRLEN];
+
+  if (inet_ntop(af, addr, buf, sizeof(buf))) obuf_puts(b, buf);
+}
+
+static void fmt_json_sample(struct station_out *out, const struct station_sample *s) {
+  struct obuf *b = &out->ob;
+  size_t i;
+
+  obuf_puts(b, "{\"ts_ms\":");
+  obuf_u64(b, s->now_ms);
+  if (s->event) {
+    json_key(b, "event");
+    json_str(b, station_event_name(s->event));
+  }
+  if (STA_HAS(s, IFINDEX)) {
+    json_key(b, "ifindex");
+    obuf_u64(b, s->ifindex);
+    json_key(b, "ifname");
+    json_str(b, station_out_ifname(out, s->ifindex));
+  }
+  if (STA_HAS(s, MAC)) {
+    obuf_puts(b, ",\"mac\":\"");
+    put_mac(b, s->mac);
+    obuf_putc(b, '"');
+  }
+  if (STA_HAS(s, IPV4)) {
+    obuf_puts(b, ",\"ipv4\":\"");
+    put_addr(b, AF_INET, s->ipv4);
+    obuf_putc(b, '"');
+  }
+  if (STA_HAS(s, IPV6)) {
+    obuf_puts(b, ",\"ipv6\":\"");
+    put_addr(b, AF_INET6, s->ipv6);
+    obuf_putc(b, '"');
+  }
+
+  for (i = 0; i < ARRAY_SIZE(columns); i++) {
+    if (!(s->present & (1ULL << columns[i].field))) continue;
+    json_key(b, columns[i].name);
+    put_column(b, s, &columns[i]);
+  }
+
+  if (STA_HAS(s, CHAIN_SIGNAL)) json_chains(b, "chain_signal", s->chain_signal, s->chains);
+  if (STA_HAS(s, CHAIN_SIGNAL_AVG))
+    json_chains(b, "chain_signal_avg", s->chain_signal_avg, s->chains_avg);
+  if (STA_HAS(s, TX_BITRATE)) json_rate(b, "tx_bitrate", &s->tx_rate);
+  if (STA_HAS(s, RX_BITRATE)) json_rate(b, "rx_bitrate", &s->rx_rate);
+
+  if (STA_HAS(s, PLINK_STATE)) {
+    json_key(b, "plink_state");
+    json_str(b, station_plink_state_name(s->plink_state));
+  }
+  if (STA_HAS(s, CONNECTED_TO_GATE)) json_bool(b, "connected_to_gate", s->connected_to_gate);
+  if (STA_HAS(s, CONNECTED_TO_AS)) json_bool(b, "connected_to_as", s->connected_to_as);
+  if (STA_HAS(s, LOCAL_PM)) {
+    json_key(b, "local_pm");
+    json_str(b, station_power_mode_name(s->local_pm));
+  }
+  if (STA_HAS(s, PEER_PM)) {
+    json_key(b, "peer_pm");
+    json_str(b, station_power_mode_name(s->peer_pm));
+  }
+  if (STA_HAS(s, NONPEER_PM)) {
+    json_key(b, "nonpeer_pm");
+    json_str(b, station_power_mode_name(s->nonpeer_pm));
+  }
+
+  if (STA_HAS(s, STA_FLAGS)) {
+    for (i = 0; i < ARRAY_SIZE(sta_flag_columns); i++) {
+      if (!(s->sta_flags.mask & sta_flag_columns[i].flag)) continue;
+      json_bool(b, sta_flag_columns[i].name, s->sta_flags.set & sta_flag_columns[i].flag);
+    }
+  }
+
+  if (STA_HAS(s, BSS_PARAM)) {
+    const struct station_bss_param *bss = &s->bss_param;
+
+    json_key(b, "bss_param");
+    obuf_puts(b, "{\"cts_prot\":");
+    obuf_puts(b, bss->flags & STA_BSS_CTS_PROT ? "true" : "false");
+    json_bool(b, "short_preamble", bss->flags & STA_BSS_SHORT_PREAMBLE);
+    json_bool(b, "short_slot_time", bss->flags & STA_BSS_SHORT_SLOT_TIME);
+    if (bss->flags & STA_BSS_DTIM_PERIOD) {
+      json_key(b, "dtim_period");
+      obuf_u64(b, bss->dtim_period);
+    }
+    if (bss->flags & STA_BSS_BEACON_INTERVAL) {
+      json_key(b, "beacon_interval");
+      obuf_u64(b, bss->beacon_interval);
+    }
+    obuf_putc(b, '}');
+  }
+
+  if (STA_HAS(s, DELTA)) {
+    json_key(b, "delta");
+    obuf_puts(b, "{\"interval_ms\":");
+    obuf_u64(b, s->delta.interval_ms);
+    for (i = 0; i < ARRAY_SIZE(delta_columns); i++) {
+      if (!(s->delta.present & (1ULL << delta_columns[i].field))) continue;
+      json_key(b, delta_columns[i].name);
+      put_column(b, &s->delta, &delta_columns[i]);
+    }
+    obuf_putc(b, '}');
+  }
+
+  if (STA_HAS(s, TID_STATS) && out->verbose) json_tids(b, s);
+
+  obuf_puts(b, "}\n");
+}
+
+const struct station_formatter station_fmt_json = {
+    .name = "json",
+    .sample = fmt_json_sample,
+};
+
+/* CSV, a header line then one row per station, fixed columns. Absent fields
+ * are empty cells, chain signals are ';' separated in one cell. Per TID
+ * statistics do not fit a fixed row and are left out. With -f the columns
+ * of the fields not selected are left out of header and rows alike. */
+
+#define CSV_HAS(out, bit) (!(out)->fields || ((out)->fields & (bit)))
+
+static void csv_header(struct station_out *out) {
+  static const char *const rate_prefix[] = {"tx_", "rx_"};
+  static const char *const pm_names[] = {"local_pm", "peer_pm", "nonpeer_pm"};
+  static const uint64_t pm_bits[] = {STA_BIT(LOCAL_PM), STA_BIT(PEER_PM), STA_BIT(NONPEER_PM)};
+  struct obuf *b = &out->ob;
+  size_t i, r;
+
+  obuf_puts(b, "ts_ms,ifindex,ifname,mac");
+  for (i = 0; i < ARRAY_SIZE(columns); i++) {
+    if (!CSV_HAS(out, 1ULL << columns[i].field)) continue;
+    obuf_putc(b, ',');
+    obuf_puts(b, columns[i].name);
+  }
+  if (CSV_HAS(out, STA_BIT(CHAIN_SIGNAL))) obuf_puts(b, ",chain_signal");
+  if (CSV_HAS(out, STA_BIT(CHAIN_SIGNAL_AVG))) obuf_puts(b, ",chain_signal_avg");
+  for (r = 0; r < ARRAY_SIZE(rate_prefix); r++) {
+    if (!CSV_HAS(out, r ? STA_BIT(RX_BITRATE) : STA_BIT(TX_BITRATE))) continue;
+    obuf_printf(b, ",%sbitrate", rate_prefix[r]);
+    for (i = 0; i < ARRAY_SIZE(rate_columns); i++)
+      obuf_printf(b, ",%s%s", rate_prefix[r], rate_columns[i].name);
+    obuf_printf(b, ",%swidth,%s80p80,%sshort_gi", rate_prefix[r], rate_prefix[r], rate_prefix[r]);
+  }
+  if (CSV_HAS(out, STA_BIT(PLINK_STATE))) obuf_puts(b, ",plink_state");
+  if (CSV_HAS(out, STA_BIT(CONNECTED_TO_GATE))) obuf_puts(b, ",connected_to_gate");
+  if (CSV_HAS(out, STA_BIT(CONNECTED_TO_AS))) obuf_puts(b, ",connected_to_as");
+  for (i = 0; i < ARRAY_SIZE(pm_names); i++) {
+    if (!CSV_HAS(out, pm_bits[i])) continue;
+    obuf_putc(b, ',');
+    obuf_puts(b, pm_names[i]);
+  }
+  for (i = 0; i < ARRAY_SIZE(sta_flag_columns) && CSV_HAS(out, STA_BIT(STA_FLAGS)); i++) {
+    obuf_putc(b, ',');
+    obuf_puts(b, sta_flag_columns[i].name);
+  }
+  if (CSV_HAS(out, STA_BIT(BSS_PARAM)))
+    obuf_puts(b, ",bss_cts_prot,bss_short_preamble,bss_short_slot_time,bss_dtim_period,"
+                 "bss_beacon_interval");
+  if (CSV_HAS(out, STA_BIT(DELTA))) {
+    obuf_puts(b, ",delta_interval_ms");
+    for (i = 0; i < ARRAY_SIZE(delta_columns); i++) {
+      obuf_puts(b, ",delta_");
+      obuf_puts(b, delta_columns[i].name);
+    }
+  }
+  obuf_puts(b, ",event");
+  if (CSV_HAS(out, STA_BIT(IPV4))) obuf_puts(b, ",ipv4");
+  if (CSV_HAS(out, STA_BIT(IPV6))) obuf_puts(b, ",ipv6");
+  obuf_putc(b, '\n');
+}
+
+static void csv_rate(struct obuf *b, const struct station_rate *r, int present) {
+  size_t i;
+
+  obuf_putc(b, ',');
+  if (present && r->bitrate) put_bitrate(b, r->bitrate);
+  for (i = 0; i < ARRAY_SIZE(rate_columns); i++) {
+    obuf_putc(b, ',');
+    if (present && (r->flags & rate_columns[i].flag))
+      obuf_u64(b, *((const uint8_t *)r + rate_columns[i].offset));
+  }
+  if (!present) {
+    obuf_puts(b, ",,,");
+    return;
+  }
+  obuf_putc(b, ',');
+  obuf_u64(b, rate_width(r));
+  obuf_puts(b, r->flags & STA_RATE_80P80MHZ ? ",1" : ",0");
+  obuf_puts(b, r->flags & STA_RATE_SHORT_GI ? ",1" : ",0");
+}
+
+/* RFC 4180: a cell with a separator, quote or line break is quoted and its
+ * quotes doubled, interface names may hold any of them */
+static void csv_str(struct obuf *b, const char *str, int present) {
+  obuf_putc(b, ',');
+  if (!present) return;
+  if (str[strcspn(str, ",\"\r\n")] == '\0') {
+    obuf_puts(b, str);
+    return;
+  }
+  obuf_putc(b, '"');
+  for (; *str; str++) {
+    if (*str == '"') obuf_putc(b, '"');
+    obuf_putc(b, *str);
+  }
+  obuf_putc(b, '"');
+}
+
+static void csv_flag(struct obuf *b, int v, int present) {
+  obuf_putc(b, ',');
+  if (present) obuf_putc(b, v ? '1' : '0');
+}
+
+static void fmt_csv_sample(struct station_out *out, const struct station_sample *s) {
+  struct obuf *b = &out->ob;
+  const struct station_bss_param *bss = &s->bss_param;
+  int bss_ok = STA_HAS(s, BSS_PARAM) != 0;
+  size_t i;
+
+  if (!out->started) {
+    csv_header(out);
+    out->started = 1;
+  }
+
+  obuf_u64(b, s->now_ms);
+  obuf_putc(b, ',');
+  if (STA_HAS(s, IFINDEX)) obuf_u64(b, s->ifindex);
+  csv_str(b, STA_HAS(s, IFINDEX) ? station_out_ifname(out, s->ifindex) : NULL,
+          STA_HAS(s, IFINDEX) != 0);
+  obuf_putc(b, ',');
+  if (STA_HAS(s, MAC)) put_mac(b, s->mac);
+
+  for (i = 0; i < ARRAY_SIZE(columns); i++) {
+    if (!CSV_HAS(out, 1ULL << columns[i].field)) continue;
+    obuf_putc(b, ',');
+    if (s->present & (1ULL << columns[i].field)) put_column(b, s, &columns[i]);
+  }
+
+  if (CSV_HAS(out, STA_BIT(CHAIN_SIGNAL))) {
+    obuf_putc(b, ',');
+    if (STA_HAS(s, CHAIN_SIGNAL)) put_chains(b, s->chain_signal, s->chains, ';');
+  }
+  if (CSV_HAS(out, STA_BIT(CHAIN_SIGNAL_AVG))) {
+    obuf_putc(b, ',');
+    if (STA_HAS(s, CHAIN_SIGNAL_AVG)) put_chains(b, s->chain_signal_avg, s->chains_avg, ';');
+  }
+  if (CSV_HAS(out, STA_BIT(TX_BITRATE))) csv_rate(b, &s->tx_rate, STA_HAS(s, TX_BITRATE) != 0);
+  if (CSV_HAS(out, STA_BIT(RX_BITRATE))) csv_rate(b, &s->rx_rate, STA_HAS(s, RX_BITRATE) != 0);
+
+  if (CSV_HAS(out, STA_BIT(PLINK_STATE)))
+    csv_str(b, station_plink_state_name(s->plink_state), STA_HAS(s, PLINK_STATE) != 0);
+  if (CSV_HAS(out, STA_BIT(CONNECTED_TO_GATE)))
+    csv_flag(b, s->connected_to_gate, STA_HAS(s, CONNECTED_TO_GATE) != 0);
+  if (CSV_HAS(out, STA_BIT(CONNECTED_TO_AS)))
+    csv_flag(b, s->connected_to_as, STA_HAS(s, CONNECTED_TO_AS) != 0);
+  if (CSV_HAS(out, STA_BIT(LOCAL_PM)))
+    csv_str(b, station_power_mode_name(s->local_pm), STA_HAS(s, LOCAL_PM) != 0);
+  if (CSV_HAS(out, STA_BIT(PEER_PM)))
+    csv_str(b, station_power_mode_name(s->peer_pm), STA_HAS(s, PEER_PM) != 0);
+  if (CSV_HAS(out, STA_BIT(NONPEER_PM)))
+    csv_str(b, station_power_mode_name(s->nonpeer_pm), STA_HAS(s, NONPEER_PM) != 0);
+  for (i = 0; i < ARRAY_SIZE(sta_flag_columns) && CSV_HAS(out, STA_BIT(STA_FLAGS)); i++)
+    csv_flag(b, s->sta_flags.set & sta_flag_columns[i].flag,
+             STA_HAS(s, STA_FLAGS) && (s->sta_flags.mask & sta_flag_columns[i].flag));
+
+  if (CSV_HAS(out, STA_BIT(BSS_PARAM))) {
+    csv_flag(b, bss->flags & STA_BSS_CTS_PROT, bss_ok);
+    csv_flag(b, bss->flags & STA_BSS_SHORT_PREAMBLE, bss_ok);
+    csv_flag(b, bss->flags & STA_BSS_SHORT_SLOT_TIME, bss_ok);
+    obuf_putc(b, ',');
+    if (bss_ok && (bss->flags & STA_BSS_DTIM_PERIOD)) obuf_u64(b, bss->dtim_period);
+    obuf_putc(b, ',');
+    if (bss_ok && (bss->flags & STA_BSS_BEACON_INTERVAL)) obuf_u64(b, bss->beacon_interval);
+  }
+
+  if (CSV_HAS(out, STA_BIT(DELTA))) {
+    obuf_putc(b, ',');
+    if (STA_HAS(s, DELTA)) obuf_u64(b, s->delta.interval_ms);
+    for (i = 0; i < ARRAY_SIZE(delta_columns); i++) {
+      obuf_putc(b, ',');
+      if (STA_HAS(s, DELTA) && (s->delta.present & (1ULL << delta_columns[i].field)))
+        put_column(b, &s->delta, &delta_columns[i]);
+    }
+  }
+  obuf_putc(b, ',');
+  if (s->event) obuf_puts(b, station_event_name(s->event));
+  if (CSV_HAS(out, STA_BIT(IPV4))) {
+    obuf_putc(b, ',');
+    if (STA_HAS(s, IPV4)) put_addr(b, AF_INET, s->ipv4);
+  }
+  if (CSV_HAS(out, STA_BIT(IPV6))) {
+    obuf_putc(b, ',');
+    if (STA_HAS(s, IPV6)) put_addr(b, AF_INET6, s->ipv6);
+  }
+  obuf_putc(b, '\n');
+}
+
+/* an empty first dump still gets the header line */
+static void fmt_csv_flush(struct station_out *out) {
+  if (out->started) return;
+  csv_header(out);
+  out->started = 1;
+}
+
+const struct station_formatter station_fmt_csv = {
+    .name = "csv",
+    .sample = fmt_csv_sample,
+    .flush = fmt_csv_flush,
+};
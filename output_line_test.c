@@ -0,0 +1,60 @@
+// interface names with a separator, quote or line break in CSV cells
+
+#define _GNU_SOURCE 1 /* memmem() */
+
+#include <linux/rtnetlink.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "link.h"
+#include "output.h"
+
+static int failed;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond);      \
+      failed = 1;                                                     \
+    }                                                                 \
+  } while (0)
+
+/* format a station on the interface named 'name', the start of its row
+ * has to be 'want' */
+static void check_row(struct link_cache *links, const char *name, const char *want) {
+  struct link_msg m = {.type = RTM_NEWLINK, .ifindex = 3, .name = name};
+  struct station_out out = {.fmt = &station_fmt_csv, .links = links,
+                            .fields = STA_BIT(IFINDEX) | STA_BIT(MAC)};
+  struct station_sample s = {.present = STA_BIT(IFINDEX) | STA_BIT(MAC), .ifindex = 3,
+                             .mac = {0x02, 0, 0, 0, 0, 1}, .now_ms = 7};
+  const char *row;
+
+  CHECK(link_cache_update(links, &m) == 1);
+  if (obuf_init(&out.ob, -1, OBUF_SIZE) < 0) {
+    fprintf(stderr, "out of memory\n");
+    failed = 1;
+    return;
+  }
+  out.fmt->sample(&out, &s);
+  row = memmem(out.ob.data, out.ob.len, "\n7,", 3); /* after the header */
+  CHECK(row != NULL && !strncmp(row + 1, want, strlen(want)));
+  CHECK(out.ob.data[out.ob.len - 1] == '\n');
+  obuf_free(&out.ob);
+}
+
+int main(void) {
+  struct link_cache links;
+
+  if (link_cache_init(&links, 4) < 0) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  check_row(&links, "wlan0", "7,3,wlan0,02:00:00:00:00:01");
+  check_row(&links, "wl,an", "7,3,\"wl,an\",02:00:00:00:00:01");
+  check_row(&links, "wl\"an\"", "7,3,\"wl\"\"an\"\"\",02:00:00:00:00:01");
+  check_row(&links, "wl\nan", "7,3,\"wl\nan\",02:00:00:00:00:01");
+  check_row(&links, "wl\ran", "7,3,\"wl\ran\",02:00:00:00:00:01");
+  link_cache_free(&links);
+  if (!failed) printf("output_line_test: ok\n");
+  return failed;
+}
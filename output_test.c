@@ -0,0 +1,110 @@
+// formatters keep their state in the output context: two contexts taking
+// turns, or threads each with their own, print what one context alone does
+
+#include <linux/netlink.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "output.h"
+#include "synth.h"
+
+static int failed;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond);      \
+      failed = 1;                                                     \
+    }                                                                 \
+  } while (0)
+
+#define OUT_SIZE (1 << 20) /* every stream of the test fits, nothing is written out */
+
+static const struct station_formatter *const formats[] = {
+    &station_fmt_text, &station_fmt_brief, &station_fmt_json, &station_fmt_csv, &station_fmt_bin,
+};
+
+/* format the next station message of 'd' at '*off' into 'out', 0 at the end */
+static int format_next(const struct bench_dump *d, size_t *off, struct station_out *out) {
+  const struct nlmsghdr *nlh = (const void *)(d->data + *off);
+  struct station_sample s;
+
+  if (*off >= d->len) return 0;
+  *off += NLMSG_ALIGN(nlh->nlmsg_len);
+  CHECK(station_decode(nlh, &s, out->verbose ? STATION_DECODE_TIDS : 0, STATION_FIELDS_ALL) ==
+        0);
+  s.now_ms = 1700000000000ULL;
+  out->fmt->sample(out, &s);
+  return 1;
+}
+
+static void flush(struct station_out *out) {
+  if (out->fmt->flush) out->fmt->flush(out);
+  CHECK(out->ob.err == 0);
+}
+
+/* 'a' and 'b' formatted alone, then message by message in turns */
+static void check_turns(const struct station_formatter *fmt, int verbose,
+                        const struct bench_dump *a, const struct bench_dump *b) {
+  struct station_out out[4];
+  size_t off[2] = {0, 0};
+  int i, more;
+
+  memset(out, 0, sizeof out);
+  for (i = 0; i < 4; i++) {
+    out[i].fmt = fmt;
+    out[i].verbose = verbose;
+    if (obuf_init(&out[i].ob, -1, OUT_SIZE) < 0) {
+      fprintf(stderr, "out of memory\n");
+      failed = 1;
+      goto out;
+    }
+  }
+  while (format_next(a, &off[0], &out[0])) {}
+  flush(&out[0]);
+  while (format_next(b, &off[1], &out[1])) {}
+  flush(&out[1]);
+
+  off[0] = off[1] = 0;
+  do {
+    more = format_next(a, &off[0], &out[2]);
+    more |= format_next(b, &off[1], &out[3]);
+  } while (more);
+  flush(&out[2]);
+  flush(&out[3]);
+
+  for (i = 0; i < 2; i++) {
+    CHECK(out[i].ob.len > 0 && out[i].ob.len == out[i + 2].ob.len);
+    CHECK(!memcmp(out[i].ob.data, out[i + 2].ob.data, out[i].ob.len));
+  }
+out:
+  for (i = 0; i < 4; i++) obuf_free(&out[i].ob);
+}
+
+int main(void) {
+  struct synth_cfg cfg_a = {.stations = 8, .family_id = 31, .ifindex = 3,
+                            .parts = SYNTH_TYPICAL | SYNTH_AIRTIME, .chains = 4};
+  struct synth_cfg cfg_b = {.stations = 5, .family_id = 31, .ifindex = 4,
+                            .parts = SYNTH_MIN, .chains = 2};
+  struct bench_dump a = {}, b = {};
+  FILE *null = fopen("/dev/null", "we");
+  size_t i;
+
+  if (synth_dump(&a, &cfg_a) < 0 || synth_dump(&b, &cfg_b) < 0 || null == NULL) {
+    fprintf(stderr, "cannot set up the dumps\n");
+    return 1;
+  }
+  for (i = 0; i < sizeof formats / sizeof formats[0]; i++) {
+    check_turns(formats[i], 0, &a, &b);
+    check_turns(formats[i], 1, &a, &b);
+    /* and each of 4 threads, every pass byte for byte the first one */
+    CHECK(bench_threads(&a, 4, 20, formats[i], 1, null) == 0);
+  }
+
+  fclose(null);
+  bench_dump_free(&a);
+  bench_dump_free(&b);
+  if (!failed) printf("output_test: ok\n");
+  return failed;
+}
@@ -0,0 +1,382 @@
+#define _GNU_SOURCE 1 /* accept4() */
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "prom.h"
+#include "station_table.h"
+
+#define PROM_PREFIX "wifi_station_"
+
+enum metric_type { VAL_U32, VAL_U64, VAL_S8, VAL_RATE };
+
+/* Name and HELP/TYPE lines are string literals, a scrape only copies them.
+ * Values are integers: 'scale' turns the sample's unit into the base unit
+ * (bit/s), 'decimals' prints ms and us as seconds without a double. */
+static const struct prom_metric {
+  const char *name, *head;
+  uint8_t name_len;
+  uint16_t head_len;
+  uint16_t offset;
+  uint8_t field; /* enum station_field */
+  uint8_t type;  /* enum metric_type */
+  uint8_t decimals;
+  uint32_t scale;
+} metrics[] = {
+#define METRIC(n, member, kind, f, t, scale, dec, help)                                     \
+  {PROM_PREFIX #n,                                                                         \
+   "# HELP " PROM_PREFIX #n " " help "\n# TYPE " PROM_PREFIX #n " " #kind "\n",            \
+   sizeof(PROM_PREFIX #n) - 1,                                                             \
+   sizeof("# HELP " PROM_PREFIX #n " " help "\n# TYPE " PROM_PREFIX #n " " #kind "\n") - 1, \
+   offsetof(struct station_sample, member),                                                \
+   STA_F_##f,                                                                              \
+   VAL_##t,                                                                                \
+   dec,                                                                                    \
+   scale}
+    METRIC(rx_bytes_total, rx_bytes, counter, RX_BYTES, U64, 1, 0,
+           "Bytes received from the station."),
+    METRIC(tx_bytes_total, tx_bytes, counter, TX_BYTES, U64, 1, 0, "Bytes sent to the station."),
+    METRIC(rx_packets_total, rx_packets, counter, RX_PACKETS, U32, 1, 0,
+           "Packets received from the station."),
+    METRIC(tx_packets_total, tx_packets, counter, TX_PACKETS, U32, 1, 0,
+           "Packets sent to the station."),
+    METRIC(tx_retries_total, tx_retries, counter, TX_RETRIES, U32, 1, 0,
+           "Retransmissions to the station."),
+    METRIC(tx_failed_total, tx_failed, counter, TX_FAILED, U32, 1, 0,
+           "Transmissions to the station that failed."),
+    METRIC(beacon_loss_total, beacon_loss, counter, BEACON_LOSS, U32, 1, 0,
+           "Beacon loss events of the station."),
+    METRIC(beacon_rx_total, beacon_rx, counter, BEACON_RX, U64, 1, 0,
+           "Beacons received from the station."),
+    METRIC(rx_drop_misc_total, rx_drop_misc, counter, RX_DROP_MISC, U64, 1, 0,
+           "Frames from the station dropped for other reasons."),
+    METRIC(tx_duration_seconds_total, tx_duration, counter, TX_DURATION, U64, 1, 6,
+           "Airtime spent sending to the station."),
+    METRIC(rx_duration_seconds_total, rx_duration, counter, RX_DURATION, U64, 1, 6,
+           "Airtime spent receiving from the station."),
+    METRIC(signal_dbm, signal, gauge, SIGNAL, S8, 1, 0, "Signal of the last frame."),
+    METRIC(signal_avg_dbm, signal_avg, gauge, SIGNAL_AVG, S8, 1, 0, "Average signal."),
+    METRIC(ack_signal_dbm, ack_signal, gauge, ACK_SIGNAL, S8, 1, 0, "Signal of the last ACK."),
+    METRIC(beacon_signal_avg_dbm, beacon_signal_avg, gauge, BEACON_SIGNAL_AVG, S8, 1, 0,
+           "Average beacon signal."),
+    METRIC(tx_bitrate_bps, tx_rate.bitrate, gauge, TX_BITRATE, RATE, 100000, 0,
+           "Bitrate of the last frame sent."),
+    METRIC(rx_bitrate_bps, rx_rate.bitrate, gauge, RX_BITRATE, RATE, 100000, 0,
+           "Bitrate of the last frame received."),
+    METRIC(expected_throughput_bps, expected_throughput, gauge, EXPECTED_THROUGHPUT, U32, 1000,
+           0, "Throughput the rate control expects."),
+    METRIC(inactive_seconds, inactive_time, gauge, INACTIVE_TIME, U32, 1, 3,
+           "Time since the last activity."),
+    METRIC(connected_seconds, connected_time, gauge, CONNECTED_TIME, U32, 1, 0,
+           "Time since the station connected."),
+#undef METRIC
+};
+
+_Static_assert(sizeof(metrics) / sizeof(metrics[0]) == PROM_METRICS, "PROM_METRICS");
+
+static const char stations_head[] = "# HELP wifi_stations Stations in the last dump round.\n"
+                                    "# TYPE wifi_stations gauge\n"
+                                    "wifi_stations ";
+
+static uint32_t prom_hash(uint32_t ifindex, uint64_t mac) {
+  return ((mac ^ (uint64_t)ifindex << 48) * 0x9e3779b97f4a7c15ULL) >> 32;
+}
+
+/* the index slot of the station, or the free slot it would go to */
+static uint32_t *prom_slot(const struct prom *p, uint32_t ifindex, uint64_t mac) {
+  uint32_t mask = p->index_cap - 1, i = prom_hash(ifindex, mac) & mask;
+
+  for (; p->index[i]; i = (i + 1) & mask) {
+    const struct prom_station *e = &p->sta[p->index[i] - 1];
+
+    if (e->mac == mac && e->ifindex == ifindex) break;
+  }
+  return &p->index[i];
+}
+
+static void prom_index_fill(struct prom *p) {
+  uint32_t i;
+
+  memset(p->index, 0, p->index_cap * sizeof(*p->index));
+  for (i = 0; i < p->n; i++) *prom_slot(p, p->sta[i].ifindex, p->sta[i].mac) = i + 1;
+}
+
+/* the array holds up to 3/4 of the index, both double together */
+static int prom_resize(struct prom *p, uint32_t index_cap) {
+  uint32_t cap = index_cap / 4 * 3;
+  struct prom_station *sta = realloc(p->sta, cap * sizeof(*sta));
+  uint32_t *index;
+
+  if (sta == NULL) return -ENOMEM;
+  p->sta = sta;
+  index = calloc(index_cap, sizeof(*index));
+  if (index == NULL) return -ENOMEM;
+  free(p->index);
+  p->index = index;
+  p->index_cap = index_cap;
+  p->cap = cap;
+  prom_index_fill(p);
+  return 0;
+}
+
+int prom_init(struct prom *p, uint32_t hint) {
+  uint32_t index_cap = 64;
+  int ret;
+
+  memset(p, 0, sizeof(*p));
+  while (index_cap / 4 * 3 < hint) index_cap *= 2;
+  ret = prom_resize(p, index_cap);
+  if (ret == 0) ret = obuf_init(&p->ob, -1, OBUF_SIZE);
+  if (ret < 0) prom_free(p);
+  return ret;
+}
+
+void prom_free(struct prom *p) {
+  obuf_free(&p->ob);
+  free(p->sta);
+  free(p->index);
+  memset(p, 0, sizeof(*p));
+}
+
+void prom_round(struct prom *p) {
+  p->round++;
+}
+
+/* {ifname="wlan0",mac="00:11:22:33:44:55"}, the name escaped as the format
+ * wants it */
+static void prom_labels(struct prom_station *e, const uint8_t *mac, const char *ifname) {
+  static const char hex[] = "0123456789abcdef";
+  char *p = e->labels;
+  int i;
+
+  memcpy(p, "{ifname=\"", 9);
+  p += 9;
+  for (i = 0; i < IF_NAMESIZE && ifname[i]; i++) {
+    if (ifname[i] == '\\' || ifname[i] == '"') *p++ = '\\';
+    if (ifname[i] == '\n') {
+      *p++ = '\\';
+      *p++ = 'n';
+      continue;
+    }
+    *p++ = ifname[i];
+  }
+  memcpy(p, "\",mac=\"", 7);
+  p += 7;
+  for (i = 0; i < STATION_MAC_LEN; i++) {
+    *p++ = hex[mac[i] >> 4];
+    *p++ = hex[mac[i] & 15];
+    *p++ = i < STATION_MAC_LEN - 1 ? ':' : '"';
+  }
+  *p++ = '}';
+  e->labels_len = p - e->labels;
+  snprintf(e->ifname, sizeof(e->ifname), "%s", ifname);
+}
+
+int prom_update(struct prom *p, const struct station_sample *s, const char *ifname) {
+  uint64_t mac = station_table_mac(s->mac);
+  struct prom_station *e;
+  uint32_t *slot, i;
+
+  if (!STA_HAS(s, MAC)) return 0;
+  slot = prom_slot(p, s->ifindex, mac);
+  if (*slot == 0) {
+    if (p->n == p->cap) {
+      if (prom_resize(p, p->index_cap * 2) < 0) return -ENOMEM;
+      slot = prom_slot(p, s->ifindex, mac);
+    }
+    e = &p->sta[p->n++];
+    *slot = p->n;
+    e->mac = mac;
+    e->ifindex = s->ifindex;
+    prom_labels(e, s->mac, ifname);
+  } else {
+    e = &p->sta[*slot - 1];
+    if (strncmp(e->ifname, ifname, IF_NAMESIZE)) prom_labels(e, s->mac, ifname);
+  }
+
+  e->round = p->round;
+  e->present = 0;
+  for (i = 0; i < PROM_METRICS; i++) {
+    const struct prom_metric *m = &metrics[i];
+    const void *v = (const char *)s + m->offset;
+    int64_t x = 0;
+
+    if (!(s->present & (1ULL << m->field))) continue;
+    switch (m->type) {
+    case VAL_U32:
+      x = *(const uint32_t *)v;
+      break;
+    case VAL_U64:
+      x = *(const uint64_t *)v;
+      break;
+    case VAL_S8:
+      x = *(const int8_t *)v;
+      break;
+    case VAL_RATE: /* 0 if the driver did not know */
+      x = *(const uint32_t *)v;
+      if (x == 0) continue;
+      break;
+    }
+    e->v[i] = x * m->scale;
+    e->present |= 1U << i;
+  }
+  return 0;
+}
+
+uint32_t prom_expire(struct prom *p) {
+  uint32_t i, n = 0, gone;
+
+  /* in order, the exposition keeps its station order */
+  for (i = 0; i < p->n; i++) {
+    if (p->sta[i].round != p->round) continue;
+    if (n != i) p->sta[n] = p->sta[i];
+    n++;
+  }
+  gone = p->n - n;
+  p->n = n;
+  if (gone) prom_index_fill(p);
+  return gone;
+}
+
+/* v / 10^decimals with the fraction zero padded, 'v' not negative if
+ * there are decimals */
+static void prom_value(struct obuf *b, int64_t v, unsigned decimals) {
+  char frac[8];
+  uint64_t u = v;
+  unsigned i;
+
+  if (decimals == 0) {
+    obuf_s64(b, v);
+    return;
+  }
+  for (i = decimals; i > 0; i--) {
+    frac[i - 1] = '0' + u % 10;
+    u /= 10;
+  }
+  obuf_u64(b, u);
+  obuf_putc(b, '.');
+  obuf_write(b, frac, decimals);
+}
+
+void prom_render(struct prom *p) {
+  struct obuf *b = &p->ob;
+  uint32_t i, j;
+
+  for (i = 0; i < PROM_METRICS; i++) {
+    const struct prom_metric *m = &metrics[i];
+
+    obuf_write(b, m->head, m->head_len);
+    for (j = 0; j < p->n; j++) {
+      const struct prom_station *e = &p->sta[j];
+
+      if (!(e->present & (1U << i))) continue;
+      obuf_write(b, m->name, m->name_len);
+      obuf_write(b, e->labels, e->labels_len);
+      obuf_putc(b, ' ');
+      prom_value(b, e->v[i], m->decimals);
+      obuf_putc(b, '\n');
+    }
+  }
+  obuf_write(b, stations_head, sizeof(stations_head) - 1);
+  obuf_u64(b, p->n);
+  obuf_putc(b, '\n');
+}
+
+int prom_listen(const char *spec) {
+  struct sockaddr_in sa = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+  const char *colon = strrchr(spec, ':');
+  char host[INET_ADDRSTRLEN];
+  unsigned long port;
+  char *end;
+  int fd, one = 1;
+
+  if (colon) {
+    if ((size_t)(colon - spec) >= sizeof(host)) return -EINVAL;
+    memcpy(host, spec, colon - spec);
+    host[colon - spec] = '\0';
+    if (inet_pton(AF_INET, host, &sa.sin_addr) != 1) return -EINVAL;
+    spec = colon + 1;
+  }
+  port = strtoul(spec, &end, 10);
+  if (*spec == '\0' || *end || port == 0 || port > 65535) return -EINVAL;
+  sa.sin_port = htons(port);
+
+  fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -errno;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0 || listen(fd, 16) < 0) {
+    int err = -errno;
+
+    close(fd);
+    return err;
+  }
+  return fd;
+}
+
+/* "GET /metrics" or "GET /", a query string or the version after it */
+static int prom_path_ok(const char *req) {
+  const char *path;
+
+  if (strncmp(req, "GET /", 5)) return 0;
+  path = req + 5;
+  if (!strncmp(path, "metrics", 7)) path += 7;
+  return *path == ' ' || *path == '?' || *path == '\r' || *path == '\n';
+}
+
+static const char http_ok[] = "HTTP/1.1 200 OK\r\n"
+                              "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                              "Connection: close\r\n\r\n";
+static const char http_not_found[] = "HTTP/1.1 404 Not Found\r\n"
+                                     "Content-Type: text/plain\r\n"
+                                     "Connection: close\r\n\r\n"
+                                     "try /metrics\n";
+
+int prom_serve(struct prom *p, int listen_fd) {
+  struct pollfd pfd = {.events = POLLIN};
+  char req[4096];
+  ssize_t len;
+  int fd, err;
+
+  fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if (fd < 0) {
+    /* gone before it was taken */
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED || errno == EINTR)
+      return 0;
+    return -errno;
+  }
+  /* the response gets what the request left of the timeout */
+  obuf_deadline(&p->ob, PROM_CLIENT_TIMEOUT_MS);
+
+  /* the request line is in the first segment, headers are not looked at */
+  pfd.fd = fd;
+  err = poll(&pfd, 1, PROM_CLIENT_TIMEOUT_MS);
+  len = err > 0 ? recv(fd, req, sizeof(req) - 1, 0) : -1;
+  if (len <= 0) {
+    err = err == 0 ? -ETIMEDOUT : len < 0 ? -errno : -ECONNRESET;
+    close(fd);
+    return err;
+  }
+  req[len] = '\0';
+
+  p->ob.fd = fd;
+  if (prom_path_ok(req)) {
+    obuf_write(&p->ob, http_ok, sizeof(http_ok) - 1);
+    prom_render(p);
+    p->scrapes++;
+  } else {
+    obuf_write(&p->ob, http_not_found, sizeof(http_not_found) - 1);
+  }
+  obuf_flush(&p->ob);
+  err = p->ob.err;
+  p->ob.err = 0; /* the next client starts clean */
+  p->ob.fd = -1;
+  close(fd);
+  return err < 0 ? err : 1;
+}
@@ -0,0 +1,74 @@
+//
+// Prometheus text exposition of the latest station samples over HTTP
+//
+
+#ifndef NETLINK_DEMO_PROM_H
+#define NETLINK_DEMO_PROM_H
+
+#include <net/if.h> /* IF_NAMESIZE */
+#include <stdint.h>
+
+#include "obuf.h"
+#include "station.h"
+
+#define PROM_METRICS 20 /* the metric table of prom.c */
+#define PROM_LABELS 96  /* {ifname="..",mac=".."}, every ifname byte escaped */
+
+/* One station of the last rounds. The label set is rendered when the
+ * station is first seen (and again if its interface is renamed), a sample
+ * only stores the values; a scrape copies the labels and prints numbers. */
+struct prom_station {
+  uint64_t mac;     /* station_table_mac(), with ifindex the key */
+  uint32_t ifindex;
+  uint32_t round;   /* the last round it was in */
+  uint32_t present; /* bit per metric */
+  uint8_t labels_len;
+  char ifname[IF_NAMESIZE]; /* the labels were rendered with */
+  char labels[PROM_LABELS];
+  int64_t v[PROM_METRICS]; /* in the metric's unit, scaled to an integer */
+};
+
+/* Stations in a dense array, scrapes walk it in order; an open addressing
+ * index of array position + 1 (0 free) finds a station by interface and
+ * MAC. Leaving stations are compacted out and the index rebuilt, which
+ * costs one pass per round that lost a station. */
+struct prom {
+  uint32_t n, cap;
+  struct prom_station *sta;
+  uint32_t index_cap; /* a power of two */
+  uint32_t *index;
+  uint32_t round;
+  uint64_t scrapes;
+  struct obuf ob; /* the response, its fd is the client being served */
+};
+
+int prom_init(struct prom *p, uint32_t hint);
+void prom_free(struct prom *p);
+
+/* start a dump round, stations not updated until prom_expire() go */
+void prom_round(struct prom *p);
+
+/* Store the values of sample 's' of interface 'ifname'. Returns 0 or
+ * -ENOMEM. */
+int prom_update(struct prom *p, const struct station_sample *s, const char *ifname);
+
+/* Drop the stations missing from the round, call it only after a round
+ * every interface answered. Returns how many went. */
+uint32_t prom_expire(struct prom *p);
+
+/* append the text exposition of every station to 'p->ob' */
+void prom_render(struct prom *p);
+
+/* TCP listener on "<port>" (127.0.0.1) or "<IPv4 address>:<port>", non
+ * blocking. Returns the fd or a negative errno. */
+int prom_listen(const char *spec);
+
+/* Answer one connection waiting on 'listen_fd': GET /metrics (or /) gets
+ * the exposition, anything else a 404. The client socket does not block,
+ * the whole exchange has PROM_CLIENT_TIMEOUT_MS, which bounds how long a
+ * slow scraper can hold the caller's loop. Returns 1 if a client was served,
+ * 0 if none was waiting, or a negative errno (-ETIMEDOUT). */
+#define PROM_CLIENT_TIMEOUT_MS 1000
+int prom_serve(struct prom *p, int listen_fd);
+
+#endif // NETLINK_DEMO_PROM_H
@@ -0,0 +1,72 @@
+// exposition values scaled to the base units, and the labels escaped
+
+#define _GNU_SOURCE 1 /* memmem() */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "prom.h"
+
+static int failed;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond);      \
+      failed = 1;                                                     \
+    }                                                                 \
+  } while (0)
+
+#define LABELS "{ifname=\"wl\\\"a\\\\n\\n\",mac=\"02:00:00:00:00:0a\"}"
+
+/* the rendered exposition has the line 'line' */
+static int has_line(const struct prom *p, const char *line) {
+  char want[256];
+  int n = snprintf(want, sizeof(want), "\n%s\n", line);
+
+  return memmem(p->ob.data, p->ob.len, want, n) != NULL;
+}
+
+int main(void) {
+  struct prom p;
+  struct station_sample s = {.mac = {0x02, 0, 0, 0, 0, 0x0a}, .ifindex = 3};
+
+  if (prom_init(&p, 4) < 0) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  s.present = STA_BIT(MAC) | STA_BIT(IFINDEX) | STA_BIT(TX_BITRATE) | STA_BIT(RX_BITRATE) |
+              STA_BIT(EXPECTED_THROUGHPUT) | STA_BIT(INACTIVE_TIME) | STA_BIT(TX_DURATION) |
+              STA_BIT(SIGNAL) | STA_BIT(RX_BYTES);
+  s.tx_rate.bitrate = 8667;        /* 100 kbit/s */
+  s.rx_rate.bitrate = 0;           /* unknown to the driver */
+  s.expected_throughput = 512345;  /* kbit/s */
+  s.inactive_time = 5;             /* ms */
+  s.tx_duration = 12000034;        /* us */
+  s.signal = -67;
+  s.rx_bytes = 1ULL << 40;
+
+  prom_round(&p);
+  CHECK(prom_update(&p, &s, "wl\"a\\n\n") == 0);
+  prom_render(&p);
+  CHECK(has_line(&p, "wifi_station_tx_bitrate_bps" LABELS " 866700000"));
+  CHECK(!memmem(p.ob.data, p.ob.len, "wifi_station_rx_bitrate_bps{", 28));
+  CHECK(has_line(&p, "wifi_station_expected_throughput_bps" LABELS " 512345000"));
+  CHECK(has_line(&p, "wifi_station_inactive_seconds" LABELS " 0.005"));
+  CHECK(has_line(&p, "wifi_station_tx_duration_seconds_total" LABELS " 12.000034"));
+  CHECK(has_line(&p, "wifi_station_signal_dbm" LABELS " -67"));
+  CHECK(has_line(&p, "wifi_station_rx_bytes_total" LABELS " 1099511627776"));
+  CHECK(has_line(&p, "wifi_stations 1"));
+
+  /* a round without it: gone from the next scrape */
+  p.ob.len = 0;
+  prom_round(&p);
+  CHECK(prom_expire(&p) == 1);
+  prom_render(&p);
+  CHECK(!memmem(p.ob.data, p.ob.len, LABELS, sizeof(LABELS) - 1));
+  CHECK(has_line(&p, "wifi_stations 0"));
+
+  prom_free(&p);
+  if (!failed) printf("prom_test: ok\n");
+  return failed;
+}
@@ -0,0 +1,116 @@
+#include <errno.h>
+#include <string.h>
+
+#include "rates.h"
+
+int station_rates_init(struct station_rates *r, uint32_t hint) {
+  r->round = 0;
+  return station_table_init(&r->t, hint);
+}
+
+void station_rates_free(struct station_rates *r) {
+  station_table_free(&r->t);
+}
+
+void station_rates_round(struct station_rates *r) {
+  r->round++;
+}
+
+uint32_t station_rates_expire(struct station_rates *r) {
+  return station_table_expire(&r->t, r->round);
+}
+
+static double per_second(uint64_t delta, uint32_t interval_ms) {
+  return delta * 1000.0 / interval_ms;
+}
+
+/* 64-bit counters only go backwards when the driver reset them */
+static uint64_t delta64(uint64_t cur, uint64_t prev) {
+  return cur >= prev ? cur - prev : cur;
+}
+
+int station_rates_update(struct station_rates *r, struct station_sample *s) {
+  struct station_table *t = &r->t;
+  struct station_delta *d = &s->delta;
+  uint64_t both, prev;
+  int32_t i;
+  int fresh;
+
+  s->present &= ~STA_BIT(DELTA);
+  if (!STA_HAS(s, IFINDEX) || !STA_HAS(s, MAC)) return 0;
+
+  i = station_table_insert(t, s->ifindex, station_table_mac(s->mac), &fresh);
+  if (i < 0) return i;
+
+  /* A join notification may come without counters, the first dump after it
+   * is then the first sample. A shorter connected time means the station
+   * left and came back. */
+  prev = t->present[i];
+  if (!fresh)
+    fresh = !(prev & STATION_RATE_COUNTERS) || s->boot_ns <= t->boot_ns[i] ||
+            (STA_HAS(s, CONNECTED_TIME) && (prev & STA_BIT(CONNECTED_TIME)) &&
+             s->connected_time < t->connected_time[i]);
+
+  if (!fresh) {
+    memset(d, 0, sizeof *d);
+    d->interval_ms = (s->boot_ns - t->boot_ns[i]) / 1000000;
+    if (d->interval_ms == 0) d->interval_ms = 1;
+    both = s->present & prev & STATION_RATE_COUNTERS;
+    d->present = both;
+
+    if (both & STA_BIT(RX_BYTES)) {
+      if ((s->present ^ prev) & STA_BIT(RX_BYTES64))
+        d->present &= ~STA_BIT(RX_BYTES); /* width changed, no usable delta */
+      else if (s->present & STA_BIT(RX_BYTES64))
+        d->rx_bytes = delta64(s->rx_bytes, t->rx_bytes[i]);
+      else
+        d->rx_bytes = (uint32_t)(s->rx_bytes - t->rx_bytes[i]);
+    }
+    if (both & STA_BIT(TX_BYTES)) {
+      if ((s->present ^ prev) & STA_BIT(TX_BYTES64))
+        d->present &= ~STA_BIT(TX_BYTES);
+      else if (s->present & STA_BIT(TX_BYTES64))
+        d->tx_bytes = delta64(s->tx_bytes, t->tx_bytes[i]);
+      else
+        d->tx_bytes = (uint32_t)(s->tx_bytes - t->tx_bytes[i]);
+    }
+    if (both & STA_BIT(RX_DROP_MISC))
+      d->rx_drop_misc = delta64(s->rx_drop_misc, t->rx_drop_misc[i]);
+    /* 32-bit in the kernel ABI, unsigned subtraction takes care of the wrap */
+    if (both & STA_BIT(RX_PACKETS)) d->rx_packets = s->rx_packets - t->rx_packets[i];
+    if (both & STA_BIT(TX_PACKETS)) d->tx_packets = s->tx_packets - t->tx_packets[i];
+    if (both & STA_BIT(TX_RETRIES)) d->tx_retries = s->tx_retries - t->tx_retries[i];
+    if (both & STA_BIT(TX_FAILED)) d->tx_failed = s->tx_failed - t->tx_failed[i];
+    if (both & STA_BIT(BEACON_LOSS)) d->beacon_loss = s->beacon_loss - t->beacon_loss[i];
+
+    d->rx_bytes_rate = per_second(d->rx_bytes, d->interval_ms);
+    d->tx_bytes_rate = per_second(d->tx_bytes, d->interval_ms);
+    d->rx_packets_rate = per_second(d->rx_packets, d->interval_ms);
+    d->tx_packets_rate = per_second(d->tx_packets, d->interval_ms);
+    if (d->tx_packets) {
+      d->retry_ratio = (double)d->tx_retries / d->tx_packets;
+      d->fail_ratio = (double)d->tx_failed / d->tx_packets;
+    }
+    s->present |= STA_BIT(DELTA);
+  }
+
+  t->seen[i] = r->round;
+  t->present[i] = s->present;
+  t->boot_ns[i] = s->boot_ns;
+  t->rx_bytes[i] = s->rx_bytes;
+  t->tx_bytes[i] = s->tx_bytes;
+  t->rx_drop_misc[i] = s->rx_drop_misc;
+  t->rx_packets[i] = s->rx_packets;
+  t->tx_packets[i] = s->tx_packets;
+  t->tx_retries[i] = s->tx_retries;
+  t->tx_failed[i] = s->tx_failed;
+  t->beacon_loss[i] = s->beacon_loss;
+  t->connected_time[i] = s->connected_time;
+  return 0;
+}
+
+void station_rates_forget(struct station_rates *r, uint32_t ifindex, const uint8_t *mac) {
+  int32_t i = station_table_find(&r->t, ifindex, station_table_mac(mac));
+
+  if (i >= 0) station_table_delete(&r->t, i);
+}
@@ -0,0 +1,51 @@
+//
+// per station counter deltas and rates between watch mode samples
+//
+
+#ifndef NETLINK_DEMO_RATES_H
+#define NETLINK_DEMO_RATES_H
+
+#include <stdint.h>
+
+#include "station.h"
+#include "station_table.h"
+
+/* The previous counters live in a station table that is updated in place:
+ * a stable set of stations costs no allocation per sample, stations missing
+ * from a whole round are dropped as disassociated. */
+struct station_rates {
+  struct station_table t;
+  uint32_t round; /* dump round counter, entries remember when they were seen */
+};
+
+/* counters taken over into the delta, RX/TX_BYTES64 tell the counter width */
+#define STATION_RATE_COUNTERS                                                            \
+  (STA_BIT(RX_BYTES) | STA_BIT(RX_BYTES64) | STA_BIT(TX_BYTES) | STA_BIT(TX_BYTES64) | \
+   STA_BIT(RX_PACKETS) | STA_BIT(TX_PACKETS) | STA_BIT(TX_RETRIES) | STA_BIT(TX_FAILED) | \
+   STA_BIT(BEACON_LOSS) | STA_BIT(RX_DROP_MISC))
+
+/* what a delta is computed from, to decode even if not printed; a shorter
+ * connected time tells a reconnect */
+#define STATION_RATE_FIELDS (STATION_RATE_COUNTERS | STA_BIT(CONNECTED_TIME))
+
+int station_rates_init(struct station_rates *r, uint32_t hint);
+void station_rates_free(struct station_rates *r);
+
+/* call once before every dump round */
+void station_rates_round(struct station_rates *r);
+
+/* Drop the stations the round did not report. Call it only after a round
+ * every interface answered, a failed dump says nothing about its stations.
+ * Returns how many went. */
+uint32_t station_rates_expire(struct station_rates *r);
+
+/* Fill s->delta against the previous sample of the same station and remember
+ * the current counters. Sets STA_F_DELTA unless this is the first sample of
+ * the station, it reconnected or the table could not grow. Needs IFINDEX,
+ * MAC and s->boot_ns. Returns 0 or -ENOMEM. */
+int station_rates_update(struct station_rates *r, struct station_sample *s);
+
+/* drop a station that left, its next sample starts without a delta */
+void station_rates_forget(struct station_rates *r, uint32_t ifindex, const uint8_t *mac);
+
+#endif // NETLINK_DEMO_RATES_H
@@ -0,0 +1,73 @@
+// counter deltas across a 32-bit wrap, and none across a reconnect
+
+#include <stdio.h>
+#include <string.h>
+
+#include "rates.h"
+
+static int failed;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond);      \
+      failed = 1;                                                     \
+    }                                                                 \
+  } while (0)
+
+/* a station with 32-bit byte counters, one sample a second */
+static void sample(struct station_sample *s, unsigned second, uint64_t rx_bytes,
+                   uint32_t rx_packets, uint32_t connected_time) {
+  static const uint8_t mac[STATION_MAC_LEN] = {0x02, 0, 0, 0, 0, 1};
+
+  memset(s, 0, sizeof *s);
+  s->present = STA_BIT(IFINDEX) | STA_BIT(MAC) | STA_BIT(RX_BYTES) | STA_BIT(RX_PACKETS) |
+               STA_BIT(CONNECTED_TIME);
+  s->ifindex = 3;
+  memcpy(s->mac, mac, sizeof mac);
+  s->boot_ns = second * 1000000000ULL;
+  s->rx_bytes = rx_bytes;
+  s->rx_packets = rx_packets;
+  s->connected_time = connected_time;
+}
+
+int main(void) {
+  struct station_rates r;
+  struct station_sample s;
+
+  if (station_rates_init(&r, 4) < 0) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  station_rates_round(&r);
+  sample(&s, 1, 0xfffffff0, 0xfffffffe, 100);
+  CHECK(station_rates_update(&r, &s) == 0);
+  CHECK(!STA_HAS(&s, DELTA)); /* the first sample has nothing to compare with */
+
+  /* both counters wrapped: 0x20 bytes and 4 packets, not ~4G */
+  station_rates_round(&r);
+  sample(&s, 2, 0x10, 2, 101);
+  CHECK(station_rates_update(&r, &s) == 0);
+  CHECK(STA_HAS(&s, DELTA));
+  CHECK(s.delta.interval_ms == 1000);
+  CHECK(s.delta.rx_bytes == 0x20 && s.delta.rx_bytes_rate == 0x20);
+  CHECK(s.delta.rx_packets == 4 && s.delta.rx_packets_rate == 4);
+
+  /* the same station back with a shorter connected time: a new session,
+   * whatever the counters say */
+  station_rates_round(&r);
+  sample(&s, 3, 0x1000, 10, 5);
+  CHECK(station_rates_update(&r, &s) == 0);
+  CHECK(!STA_HAS(&s, DELTA));
+
+  /* and the session after it counts from there */
+  station_rates_round(&r);
+  sample(&s, 4, 0x1800, 12, 6);
+  CHECK(station_rates_update(&r, &s) == 0);
+  CHECK(STA_HAS(&s, DELTA) && s.delta.rx_bytes == 0x800 && s.delta.rx_packets == 2);
+
+  station_rates_free(&r);
+  if (!failed) printf("rates_test: ok\n");
+  return failed;
+}
@@ -0,0 +1,143 @@
+// a synthetic capture replayed as JSON and CSV must match the golden files
+//
+// replay_test <station_dump> <dir> compares with <dir>/replay_test.json and
+// <dir>/replay_test.csv, replay_test <station_dump> <dir> update rewrites them
+
+#include <errno.h>
+#include <linux/netlink.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "capture.h"
+#include "synth.h"
+
+#define FAMILY_ID 31
+#define IFINDEX 3
+#define NOW_MS 1700000000000ULL
+#define BOOT_NS 5000000000ULL
+#define PARTS (SYNTH_TYPICAL | SYNTH_AIRTIME)
+
+/* one dump reply datagram: the stations with 'seq', then NLMSG_DONE */
+static int put_round(struct capture *c, unsigned round, uint32_t stations) {
+  struct synth_cfg cfg = {.stations = stations, .family_id = FAMILY_ID, .ifindex = IFINDEX,
+                          .parts = PARTS, .chains = 2};
+  struct capture_req req = {.ifindex = IFINDEX, .seq = 100 + round};
+  struct nlmsghdr done = {.nlmsg_len = NLMSG_LENGTH(sizeof(int)), .nlmsg_type = NLMSG_DONE,
+                          .nlmsg_flags = NLM_F_MULTI, .nlmsg_seq = req.seq};
+  uint64_t now_ms = NOW_MS + round * 1000ULL, boot_ns = BOOT_NS + round * 1000000000ULL;
+  struct bench_dump d = {};
+  struct nlmsghdr *nlh;
+  size_t off;
+  int ret;
+
+  ret = synth_dump(&d, &cfg);
+  if (ret < 0) return ret;
+  for (off = 0; off < d.len; off += NLMSG_ALIGN(nlh->nlmsg_len)) {
+    nlh = (struct nlmsghdr *)(d.data + off);
+    nlh->nlmsg_seq = req.seq;
+    nlh->nlmsg_flags = NLM_F_MULTI;
+  }
+  if (bench_dump_append(&d, &done) < 0) {
+    bench_dump_free(&d);
+    return -ENOMEM;
+  }
+  capture_put(c, CAPTURE_ROUND, 0, now_ms, boot_ns, &req, sizeof(req));
+  capture_put(c, CAPTURE_DUMP, IFINDEX, now_ms, boot_ns, d.data, d.len);
+  bench_dump_free(&d);
+  return 0;
+}
+
+/* an interface, three stations, a join notification and a round without the
+ * last station, which also gives the others their deltas */
+static int write_capture(const char *path) {
+  struct capture_dev dev = {.wiphy = 0, .name = "wlan0"};
+  struct synth_cfg cfg = {.stations = 1, .family_id = FAMILY_ID, .ifindex = IFINDEX,
+                          .parts = PARTS, .chains = 2};
+  struct capture c;
+  struct bench_dump ev = {};
+  int ret;
+
+  ret = capture_open(&c, path, FAMILY_ID);
+  if (ret < 0) return ret;
+  capture_put(&c, CAPTURE_DEV, IFINDEX, 0, 0, &dev, sizeof(dev));
+  ret = put_round(&c, 0, 3);
+  if (ret == 0) ret = synth_dump(&ev, &cfg);
+  if (ret == 0)
+    capture_put(&c, CAPTURE_MLME, 0, NOW_MS + 500, BOOT_NS + 500000000ULL, ev.data, ev.len);
+  if (ret == 0) ret = put_round(&c, 1, 2);
+  bench_dump_free(&ev);
+  if (capture_close(&c) < 0 && ret == 0) ret = c.err;
+  return ret;
+}
+
+static char *read_file(const char *path, size_t *len) {
+  FILE *f = fopen(path, "re");
+  char *buf = NULL;
+  long n;
+
+  if (f == NULL) return NULL;
+  if (fseek(f, 0, SEEK_END) == 0 && (n = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0 &&
+      (buf = malloc(n + 1)) != NULL) {
+    *len = fread(buf, 1, n, f);
+    buf[*len] = '\0';
+  }
+  fclose(f);
+  return buf;
+}
+
+/* replay 'cap' as 'fmt' and compare with, or with 'update' write, the golden
+ * file; 0 if they match */
+static int check_format(const char *bin, const char *dir, const char *cap, const char *fmt,
+                        int update) {
+  char golden[4096], out[4096], cmd[8192];
+  char *got, *want;
+  size_t got_len = 0, want_len = 0, i, line = 1;
+  int ret = 1;
+
+  snprintf(golden, sizeof(golden), "%s/replay_test.%s", dir, fmt);
+  snprintf(out, sizeof(out), "%s.%s", cap, fmt);
+  snprintf(cmd, sizeof(cmd), "%s -o %s replay %s out %s", bin, fmt, cap, update ? golden : out);
+  if (system(cmd) != 0) {
+    fprintf(stderr, "%s failed\n", cmd);
+    return 1;
+  }
+  if (update) return 0;
+
+  got = read_file(out, &got_len);
+  want = read_file(golden, &want_len);
+  if (got == NULL || want == NULL) {
+    fprintf(stderr, "%s: %s\n", got == NULL ? out : golden, strerror(errno));
+  } else if (got_len != want_len || memcmp(got, want, got_len)) {
+    for (i = 0; i < got_len && i < want_len && got[i] == want[i]; i++)
+      if (got[i] == '\n') line++;
+    fprintf(stderr, "%s differs from %s from line %zu\n", out, golden, line);
+  } else {
+    ret = 0;
+  }
+  free(got);
+  free(want);
+  unlink(out);
+  return ret;
+}
+
+int main(int argc, char **argv) {
+  char cap[] = "/tmp/replay_test.XXXXXX";
+  int fd, update = argc > 3 && !strcmp(argv[3], "update"), failed;
+
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <station_dump> <dir> [update]\n", argv[0]);
+    return 2;
+  }
+  fd = mkstemp(cap);
+  if (fd < 0 || close(fd) < 0 || write_capture(cap) < 0) {
+    fprintf(stderr, "%s: cannot write the capture\n", cap);
+    return 1;
+  }
+  failed = check_format(argv[1], argv[2], cap, "json", update);
+  failed |= check_format(argv[1], argv[2], cap, "csv", update);
+  unlink(cap);
+  if (!failed) printf("replay_test: %s\n", update ? "updated" : "ok");
+  return failed;
+}
@@ -0,0 +1,25 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spsc.h"
+
+int spsc_init(struct spsc *r, uint32_t nslots, size_t size) {
+  uint32_t n = 1;
+  void *mem;
+
+  while (n < nslots) n <<= 1;
+  size = (size + 63) & ~(size_t)63;
+  if (posix_memalign(&mem, 64, (size_t)n * size)) return -ENOMEM;
+
+  memset(r, 0, sizeof(*r));
+  r->mask = n - 1;
+  r->size = size;
+  r->slots = mem;
+  return 0;
+}
+
+void spsc_free(struct spsc *r) {
+  free(r->slots);
+  r->slots = NULL;
+}
@@ -0,0 +1,72 @@
+//
+// lock-free single producer, single consumer ring of fixed size slots
+//
+
+#ifndef NETLINK_DEMO_SPSC_H
+#define NETLINK_DEMO_SPSC_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* One thread claims, fills and publishes slots, one other thread peeks at and
+ * releases them, in order. Both sides only store their own index and load
+ * the other one, and only when their cached copy says the ring is full or
+ * empty, so the shared cache lines move once per batch rather than per slot.
+ * Samples are decoded straight into the slot they are handed over in. */
+struct spsc {
+  /* producer side */
+  _Atomic uint32_t head __attribute__((aligned(64))); /* next slot to publish */
+  uint32_t tail_cache;
+
+  /* consumer side */
+  _Atomic uint32_t tail __attribute__((aligned(64))); /* next slot to release */
+  uint32_t head_cache;
+
+  uint32_t mask __attribute__((aligned(64))); /* slots - 1 */
+  size_t size;                                  /* bytes per slot */
+  unsigned char *slots;
+};
+
+/* 'nslots' is rounded up to a power of two, slots are 64 byte aligned.
+ * Returns 0 or -ENOMEM. */
+int spsc_init(struct spsc *r, uint32_t nslots, size_t size);
+void spsc_free(struct spsc *r);
+
+/* producer: the next free slot, NULL if the ring is full */
+static inline void *spsc_claim(struct spsc *r) {
+  uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+  if (head - r->tail_cache > r->mask) {
+    r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (head - r->tail_cache > r->mask) return NULL;
+  }
+  return r->slots + (size_t)(head & r->mask) * r->size;
+}
+
+/* producer: hand the claimed slot over */
+static inline void spsc_publish(struct spsc *r) {
+  uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+  atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+/* consumer: the oldest published slot, NULL if the ring is empty */
+static inline void *spsc_peek(struct spsc *r) {
+  uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+  if (tail == r->head_cache) {
+    r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (tail == r->head_cache) return NULL;
+  }
+  return r->slots + (size_t)(tail & r->mask) * r->size;
+}
+
+/* consumer: give the peeked slot back to the producer */
+static inline void spsc_release(struct spsc *r) {
+  uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+  atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+}
+
+#endif // NETLINK_DEMO_SPSC_H
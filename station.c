@@ -0,0 +1,408 @@
+#include <errno.h>
+#include <linux/genetlink.h> /* GENL_HDRLEN */
+#include <string.h>
+#include <time.h>
+
+#include "nlraw.h" /* attribute walker */
+#include "station.h"
+
+/* Single pass attribute walker. Every attribute is visited once and
+ * dispatched on its type by a switch (compiled to a jump table), nothing is
+ * cleared or looked up for types that are not in the message. Only the
+ * linux/netlink.h layout is used, no libnl. */
+
+/* case for a scalar station attribute: skip it unless selected in 'fields',
+ * check the payload size, store, mark */
+#define SCALAR(ns, key, field, type, get)   \
+  case ns##key:                             \
+    if (!(fields & STA_BIT(key)))           \
+      break;                                \
+    if (attr_len(a) < (int)sizeof(type))    \
+      return -EINVAL;                       \
+    s->field = get(a);                      \
+    s->present |= STA_BIT(key);             \
+    break
+
+#define STA_SCALAR(key, field, type, get) SCALAR(NL80211_STA_INFO_, key, field, type, get)
+
+static int walk_txq_stats(const struct nlattr *nest, struct station_tid *tid) {
+  const struct nlattr *a;
+  int rem, type;
+
+  attr_for_each_nested(a, nest, rem) {
+    type = attr_type(a);
+    if (type < NL80211_TXQ_STATS_BACKLOG_BYTES || type > NL80211_TXQ_STATS_TX_PACKETS)
+      continue;
+    if (attr_len(a) < (int)sizeof(uint32_t)) return -EINVAL;
+    tid->txq[type] = attr_u32(a);
+    tid->txq_present |= 1 << type;
+  }
+  return 0;
+}
+
+static int walk_tid_stats(const struct nlattr *nest, struct station_sample *s) {
+  const struct nlattr *tidattr, *a;
+  int rem, trem;
+
+  s->ntids = 0;
+  attr_for_each_nested(tidattr, nest, trem) {
+    struct station_tid *tid;
+
+    if (s->ntids == STATION_MAX_TIDS) break;
+    tid = &s->tid[s->ntids++];
+    tid->present = 0;
+    tid->txq_present = 0;
+
+    attr_for_each_nested(a, tidattr, rem) {
+      switch (attr_type(a)) {
+#define TID_U64(key, field)                           \
+  case NL80211_TID_STATS_##key:                       \
+    if (attr_len(a) < (int)sizeof(uint64_t))          \
+      return -EINVAL;                                 \
+    tid->field = attr_u64(a);                         \
+    tid->present |= 1 << NL80211_TID_STATS_##key;     \
+    break
+
+        TID_U64(RX_MSDU, rx_msdu);
+        TID_U64(TX_MSDU, tx_msdu);
+        TID_U64(TX_MSDU_RETRIES, tx_msdu_retries);
+        TID_U64(TX_MSDU_FAILED, tx_msdu_failed);
+
+#undef TID_U64
+      case NL80211_TID_STATS_TXQ_STATS:
+        if (walk_txq_stats(a, tid)) return -EINVAL;
+        tid->present |= 1 << NL80211_TID_STATS_TXQ_STATS;
+        break;
+      }
+    }
+  }
+  return 0;
+}
+
+static int walk_bss_param(const struct nlattr *nest, struct station_bss_param *bss) {
+  const struct nlattr *a;
+  int rem;
+
+  bss->flags = 0;
+  attr_for_each_nested(a, nest, rem) {
+    switch (attr_type(a)) {
+    case NL80211_STA_BSS_PARAM_DTIM_PERIOD:
+      if (attr_len(a) < (int)sizeof(uint8_t)) return -EINVAL;
+      bss->dtim_period = attr_u8(a);
+      bss->flags |= STA_BSS_DTIM_PERIOD;
+      break;
+    case NL80211_STA_BSS_PARAM_BEACON_INTERVAL:
+      if (attr_len(a) < (int)sizeof(uint16_t)) return -EINVAL;
+      bss->beacon_interval = attr_u16(a);
+      bss->flags |= STA_BSS_BEACON_INTERVAL;
+      break;
+    case NL80211_STA_BSS_PARAM_CTS_PROT:
+      bss->flags |= STA_BSS_CTS_PROT;
+      break;
+    case NL80211_STA_BSS_PARAM_SHORT_PREAMBLE:
+      bss->flags |= STA_BSS_SHORT_PREAMBLE;
+      break;
+    case NL80211_STA_BSS_PARAM_SHORT_SLOT_TIME:
+      bss->flags |= STA_BSS_SHORT_SLOT_TIME;
+      break;
+    }
+  }
+  return 0;
+}
+
+static uint8_t walk_chain_signal(const struct nlattr *nest, int8_t *chains) {
+  const struct nlattr *a;
+  int rem;
+  uint8_t i = 0;
+
+  attr_for_each_nested(a, nest, rem) {
+    if (i == STATION_MAX_CHAINS) break;
+    if (attr_len(a) < (int)sizeof(uint8_t)) continue;
+    chains[i++] = attr_s8(a);
+  }
+  return i;
+}
+
+static int walk_bitrate(const struct nlattr *nest, struct station_rate *r) {
+  const struct nlattr *a;
+  int rem, has_bitrate32 = 0;
+
+  r->bitrate = 0;
+  r->flags = 0;
+  attr_for_each_nested(a, nest, rem) {
+    switch (attr_type(a)) {
+    case NL80211_RATE_INFO_BITRATE32:
+      if (attr_len(a) < (int)sizeof(uint32_t)) return -EINVAL;
+      r->bitrate = attr_u32(a);
+      has_bitrate32 = 1;
+      break;
+    case NL80211_RATE_INFO_BITRATE:
+      if (attr_len(a) < (int)sizeof(uint16_t)) return -EINVAL;
+      if (!has_bitrate32) r->bitrate = attr_u16(a);
+      break;
+
+#define RATE_U8(key, field)                \
+  case NL80211_RATE_INFO_##key:            \
+    if (attr_len(a) < (int)sizeof(uint8_t)) \
+      return -EINVAL;                      \
+    r->field = attr_u8(a);                 \
+    r->flags |= STA_RATE_##key;            \
+    break
+#define RATE_FLAG(key, flag)    \
+  case NL80211_RATE_INFO_##key: \
+    r->flags |= flag;           \
+    break
+
+      RATE_U8(MCS, mcs);
+      RATE_U8(VHT_MCS, vht_mcs);
+      RATE_U8(VHT_NSS, vht_nss);
+      RATE_U8(HE_MCS, he_mcs);
+      RATE_U8(HE_NSS, he_nss);
+      RATE_U8(HE_GI, he_gi);
+      RATE_U8(HE_DCM, he_dcm);
+      RATE_U8(HE_RU_ALLOC, he_ru_alloc);
+      RATE_U8(EHT_MCS, eht_mcs);
+      RATE_U8(EHT_NSS, eht_nss);
+      RATE_U8(EHT_GI, eht_gi);
+      RATE_U8(EHT_RU_ALLOC, eht_ru_alloc);
+      RATE_FLAG(40_MHZ_WIDTH, STA_RATE_40MHZ);
+      RATE_FLAG(80_MHZ_WIDTH, STA_RATE_80MHZ);
+      RATE_FLAG(80P80_MHZ_WIDTH, STA_RATE_80P80MHZ);
+      RATE_FLAG(160_MHZ_WIDTH, STA_RATE_160MHZ);
+      RATE_FLAG(320_MHZ_WIDTH, STA_RATE_320MHZ);
+      RATE_FLAG(SHORT_GI, STA_RATE_SHORT_GI);
+
+#undef RATE_FLAG
+#undef RATE_U8
+    }
+  }
+  return 0;
+}
+
+/* nested attributes that were not selected are not walked at all */
+static int walk_sta_info(const struct nlattr *nest, struct station_sample *s, unsigned flags,
+                         uint64_t fields) {
+  const struct nlattr *a;
+  int rem;
+
+  attr_for_each_nested(a, nest, rem) {
+    switch (attr_type(a)) {
+      STA_SCALAR(INACTIVE_TIME, inactive_time, uint32_t, attr_u32);
+      STA_SCALAR(RX_PACKETS, rx_packets, uint32_t, attr_u32);
+      STA_SCALAR(TX_PACKETS, tx_packets, uint32_t, attr_u32);
+      STA_SCALAR(TX_RETRIES, tx_retries, uint32_t, attr_u32);
+      STA_SCALAR(TX_FAILED, tx_failed, uint32_t, attr_u32);
+      STA_SCALAR(BEACON_LOSS, beacon_loss, uint32_t, attr_u32);
+      STA_SCALAR(BEACON_RX, beacon_rx, uint64_t, attr_u64);
+      STA_SCALAR(RX_DROP_MISC, rx_drop_misc, uint64_t, attr_u64);
+      STA_SCALAR(SIGNAL, signal, uint8_t, attr_s8);
+      STA_SCALAR(SIGNAL_AVG, signal_avg, uint8_t, attr_s8);
+      STA_SCALAR(BEACON_SIGNAL_AVG, beacon_signal_avg, uint8_t, attr_s8);
+      STA_SCALAR(T_OFFSET, t_offset, uint64_t, attr_u64);
+      STA_SCALAR(TX_DURATION, tx_duration, uint64_t, attr_u64);
+      STA_SCALAR(RX_DURATION, rx_duration, uint64_t, attr_u64);
+      STA_SCALAR(ACK_SIGNAL, ack_signal, uint8_t, attr_s8);
+      STA_SCALAR(ACK_SIGNAL_AVG, ack_signal_avg, uint8_t, attr_s8);
+      STA_SCALAR(AIRTIME_WEIGHT, airtime_weight, uint16_t, attr_u16);
+      STA_SCALAR(EXPECTED_THROUGHPUT, expected_throughput, uint32_t, attr_u32);
+      STA_SCALAR(LLID, llid, uint16_t, attr_u16);
+      STA_SCALAR(PLID, plid, uint16_t, attr_u16);
+      STA_SCALAR(PLINK_STATE, plink_state, uint8_t, attr_u8);
+      STA_SCALAR(AIRTIME_LINK_METRIC, airtime_link_metric, uint32_t, attr_u32);
+      STA_SCALAR(CONNECTED_TO_GATE, connected_to_gate, uint8_t, attr_u8);
+      STA_SCALAR(CONNECTED_TO_AS, connected_to_as, uint8_t, attr_u8);
+      STA_SCALAR(LOCAL_PM, local_pm, uint32_t, attr_u32);
+      STA_SCALAR(PEER_PM, peer_pm, uint32_t, attr_u32);
+      STA_SCALAR(NONPEER_PM, nonpeer_pm, uint32_t, attr_u32);
+      STA_SCALAR(CONNECTED_TIME, connected_time, uint32_t, attr_u32);
+      STA_SCALAR(ASSOC_AT_BOOTTIME, assoc_at_boottime, uint64_t, attr_u64);
+
+    /* the 64-bit byte counters win over the 32-bit ones in any order */
+    case NL80211_STA_INFO_RX_BYTES64:
+      if (!(fields & STA_BIT(RX_BYTES64))) break;
+      if (attr_len(a) < (int)sizeof(uint64_t)) return -EINVAL;
+      s->rx_bytes = attr_u64(a);
+      s->present |= STA_BIT(RX_BYTES) | STA_BIT(RX_BYTES64);
+      break;
+    case NL80211_STA_INFO_RX_BYTES:
+      if (!(fields & STA_BIT(RX_BYTES))) break;
+      if (attr_len(a) < (int)sizeof(uint32_t)) return -EINVAL;
+      if (STA_HAS(s, RX_BYTES64)) break;
+      s->rx_bytes = attr_u32(a);
+      s->present |= STA_BIT(RX_BYTES);
+      break;
+    case NL80211_STA_INFO_TX_BYTES64:
+      if (!(fields & STA_BIT(TX_BYTES64))) break;
+      if (attr_len(a) < (int)sizeof(uint64_t)) return -EINVAL;
+      s->tx_bytes = attr_u64(a);
+      s->present |= STA_BIT(TX_BYTES) | STA_BIT(TX_BYTES64);
+      break;
+    case NL80211_STA_INFO_TX_BYTES:
+      if (!(fields & STA_BIT(TX_BYTES))) break;
+      if (attr_len(a) < (int)sizeof(uint32_t)) return -EINVAL;
+      if (STA_HAS(s, TX_BYTES64)) break;
+      s->tx_bytes = attr_u32(a);
+      s->present |= STA_BIT(TX_BYTES);
+      break;
+
+    case NL80211_STA_INFO_CHAIN_SIGNAL:
+      if (!(fields & STA_BIT(CHAIN_SIGNAL))) break;
+      s->chains = walk_chain_signal(a, s->chain_signal);
+      s->present |= STA_BIT(CHAIN_SIGNAL);
+      break;
+    case NL80211_STA_INFO_CHAIN_SIGNAL_AVG:
+      if (!(fields & STA_BIT(CHAIN_SIGNAL_AVG))) break;
+      s->chains_avg = walk_chain_signal(a, s->chain_signal_avg);
+      s->present |= STA_BIT(CHAIN_SIGNAL_AVG);
+      break;
+    case NL80211_STA_INFO_TX_BITRATE:
+      if (!(fields & STA_BIT(TX_BITRATE))) break;
+      if (walk_bitrate(a, &s->tx_rate)) return -EINVAL;
+      s->present |= STA_BIT(TX_BITRATE);
+      break;
+    case NL80211_STA_INFO_RX_BITRATE:
+      if (!(fields & STA_BIT(RX_BITRATE))) break;
+      if (walk_bitrate(a, &s->rx_rate)) return -EINVAL;
+      s->present |= STA_BIT(RX_BITRATE);
+      break;
+    case NL80211_STA_INFO_STA_FLAGS:
+      if (!(fields & STA_BIT(STA_FLAGS))) break;
+      if (attr_len(a) < (int)sizeof(s->sta_flags)) return -EINVAL;
+      memcpy(&s->sta_flags, attr_data(a), sizeof(s->sta_flags));
+      s->present |= STA_BIT(STA_FLAGS);
+      break;
+    case NL80211_STA_INFO_TID_STATS:
+      if (!(flags & STATION_DECODE_TIDS) || !(fields & STA_BIT(TID_STATS))) break;
+      if (walk_tid_stats(a, s)) return -EINVAL;
+      s->present |= STA_BIT(TID_STATS);
+      break;
+    case NL80211_STA_INFO_BSS_PARAM:
+      if (!(fields & STA_BIT(BSS_PARAM))) break;
+      if (walk_bss_param(a, &s->bss_param)) return -EINVAL;
+      s->present |= STA_BIT(BSS_PARAM);
+      break;
+    }
+  }
+  return 0;
+}
+
+/* keep the trace list sorted by type, as the old table walk printed it */
+static void trace_attr(struct station_sample *s, uint16_t type) {
+  int i;
+
+  if (s->nattrs == STATION_MAX_ATTRS) return;
+  for (i = s->nattrs; i > 0 && s->attrs[i - 1] > type; i--)
+    s->attrs[i] = s->attrs[i - 1];
+  s->attrs[i] = type;
+  s->nattrs++;
+}
+
+int station_decode(const struct nlmsghdr *nlh, struct station_sample *s, unsigned flags,
+                   uint64_t fields) {
+  const struct nlattr *a, *sta_info = NULL;
+  int rem, len = (int)nlh->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+
+  s->present = 0;
+  s->nattrs = 0;
+  s->ntids = 0;
+
+  if (len < 0) return -EINVAL;
+  attr_for_each(a, (const struct nlattr *)((const char *)NLMSG_DATA(nlh) + GENL_HDRLEN), len, rem) {
+    trace_attr(s, attr_type(a));
+    switch (attr_type(a)) {
+    case NL80211_ATTR_IFINDEX:
+      if (attr_len(a) < (int)sizeof(uint32_t)) return -EINVAL;
+      s->ifindex = attr_u32(a);
+      s->present |= STA_BIT(IFINDEX);
+      break;
+    case NL80211_ATTR_MAC:
+      if (attr_len(a) < STATION_MAC_LEN) return -EINVAL;
+      memcpy(s->mac, attr_data(a), STATION_MAC_LEN);
+      s->present |= STA_BIT(MAC);
+      break;
+    case NL80211_ATTR_GENERATION:
+      if (!(fields & STA_BIT(GENERATION))) break;
+      if (attr_len(a) < (int)sizeof(uint32_t)) return -EINVAL;
+      s->generation = attr_u32(a);
+      s->present |= STA_BIT(GENERATION);
+      break;
+    case NL80211_ATTR_STA_INFO:
+      sta_info = a;
+      break;
+    }
+  }
+
+  if (sta_info == NULL) return -ENODATA;
+  return walk_sta_info(sta_info, s, flags, fields);
+}
+
+/* -f names, the JSON keys where there is one; the 64-bit byte counter bits
+ * go with the others */
+static const char *const field_names[STA_F__MAX] = {
+    [STA_F_IFINDEX] = "ifindex",
+    [STA_F_MAC] = "mac",
+    [STA_F_GENERATION] = "generation",
+    [STA_F_INACTIVE_TIME] = "inactive_time",
+    [STA_F_RX_BYTES] = "rx_bytes",
+    [STA_F_RX_PACKETS] = "rx_packets",
+    [STA_F_TX_BYTES] = "tx_bytes",
+    [STA_F_TX_PACKETS] = "tx_packets",
+    [STA_F_TX_RETRIES] = "tx_retries",
+    [STA_F_TX_FAILED] = "tx_failed",
+    [STA_F_BEACON_LOSS] = "beacon_loss",
+    [STA_F_BEACON_RX] = "beacon_rx",
+    [STA_F_RX_DROP_MISC] = "rx_drop_misc",
+    [STA_F_SIGNAL] = "signal",
+    [STA_F_SIGNAL_AVG] = "signal_avg",
+    [STA_F_CHAIN_SIGNAL] = "chain_signal",
+    [STA_F_CHAIN_SIGNAL_AVG] = "chain_signal_avg",
+    [STA_F_BEACON_SIGNAL_AVG] = "beacon_signal_avg",
+    [STA_F_T_OFFSET] = "t_offset",
+    [STA_F_TX_BITRATE] = "tx_bitrate",
+    [STA_F_TX_DURATION] = "tx_duration",
+    [STA_F_RX_BITRATE] = "rx_bitrate",
+    [STA_F_RX_DURATION] = "rx_duration",
+    [STA_F_ACK_SIGNAL] = "ack_signal",
+    [STA_F_ACK_SIGNAL_AVG] = "ack_signal_avg",
+    [STA_F_AIRTIME_WEIGHT] = "airtime_weight",
+    [STA_F_EXPECTED_THROUGHPUT] = "expected_throughput",
+    [STA_F_LLID] = "llid",
+    [STA_F_PLID] = "plid",
+    [STA_F_PLINK_STATE] = "plink_state",
+    [STA_F_AIRTIME_LINK_METRIC] = "airtime_link_metric",
+    [STA_F_CONNECTED_TO_GATE] = "connected_to_gate",
+    [STA_F_CONNECTED_TO_AS] = "connected_to_as",
+    [STA_F_LOCAL_PM] = "local_pm",
+    [STA_F_PEER_PM] = "peer_pm",
+    [STA_F_NONPEER_PM] = "nonpeer_pm",
+    [STA_F_STA_FLAGS] = "sta_flags",
+    [STA_F_TID_STATS] = "tid_stats",
+    [STA_F_BSS_PARAM] = "bss_param",
+    [STA_F_CONNECTED_TIME] = "connected_time",
+    [STA_F_ASSOC_AT_BOOTTIME] = "assoc_at_boottime",
+    [STA_F_DELTA] = "delta",
+    [STA_F_IPV4] = "ipv4",
+    [STA_F_IPV6] = "ipv6",
+};
+
+uint64_t station_field_bits(const char *name, size_t len) {
+  int i;
+
+  for (i = 0; i < STA_F__MAX; i++) {
+    if (field_names[i] == NULL || strncmp(field_names[i], name, len) || field_names[i][len])
+      continue;
+    if (i == STA_F_RX_BYTES) return STA_BIT(RX_BYTES) | STA_BIT(RX_BYTES64);
+    if (i == STA_F_TX_BYTES) return STA_BIT(TX_BYTES) | STA_BIT(TX_BYTES64);
+    return 1ULL << i;
+  }
+  return 0;
+}
+
+void station_stamp(struct station_sample *s) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  s->now_ms = ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+  clock_gettime(CLOCK_BOOTTIME, &ts);
+  s->boot_ns = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
@@ -0,0 +1,221 @@
+//
+// decoded nl80211 station record
+//
+
+#ifndef NETLINK_DEMO_STATION_H
+#define NETLINK_DEMO_STATION_H
+
+#include <linux/netlink.h> /* struct nlmsghdr */
+#include <linux/nl80211.h> /* struct nl80211_sta_flag_update */
+#include <stddef.h>
+#include <stdint.h>
+
+#define STATION_MAC_LEN 6
+#define STATION_MAX_CHAINS 4 /* IEEE80211_MAX_CHAINS */
+#define STATION_MAX_TIDS 17  /* IEEE80211_NUM_TIDS + 1 for non-QoS */
+#define STATION_MAX_ATTRS 16 /* top level attribute types kept for tracing */
+
+/* one bit per decoded field in station_sample.present */
+enum station_field {
+  STA_F_IFINDEX,
+  STA_F_MAC,
+  STA_F_GENERATION,
+  STA_F_INACTIVE_TIME,
+  STA_F_RX_BYTES,
+  STA_F_RX_BYTES64, /* rx_bytes came from the 64-bit attribute */
+  STA_F_RX_PACKETS,
+  STA_F_TX_BYTES,
+  STA_F_TX_BYTES64, /* tx_bytes came from the 64-bit attribute */
+  STA_F_TX_PACKETS,
+  STA_F_TX_RETRIES,
+  STA_F_TX_FAILED,
+  STA_F_BEACON_LOSS,
+  STA_F_BEACON_RX,
+  STA_F_RX_DROP_MISC,
+  STA_F_SIGNAL,
+  STA_F_SIGNAL_AVG,
+  STA_F_CHAIN_SIGNAL,
+  STA_F_CHAIN_SIGNAL_AVG,
+  STA_F_BEACON_SIGNAL_AVG,
+  STA_F_T_OFFSET,
+  STA_F_TX_BITRATE,
+  STA_F_TX_DURATION,
+  STA_F_RX_BITRATE,
+  STA_F_RX_DURATION,
+  STA_F_ACK_SIGNAL,
+  STA_F_ACK_SIGNAL_AVG,
+  STA_F_AIRTIME_WEIGHT,
+  STA_F_EXPECTED_THROUGHPUT,
+  STA_F_LLID,
+  STA_F_PLID,
+  STA_F_PLINK_STATE,
+  STA_F_AIRTIME_LINK_METRIC,
+  STA_F_CONNECTED_TO_GATE,
+  STA_F_CONNECTED_TO_AS,
+  STA_F_LOCAL_PM,
+  STA_F_PEER_PM,
+  STA_F_NONPEER_PM,
+  STA_F_STA_FLAGS,
+  STA_F_TID_STATS,
+  STA_F_BSS_PARAM,
+  STA_F_CONNECTED_TIME,
+  STA_F_ASSOC_AT_BOOTTIME,
+  STA_F_DELTA, /* 'delta' is valid, watch mode only */
+  STA_F_IPV4,  /* client addresses from the neighbour cache, -n only */
+  STA_F_IPV6,
+  STA_F__MAX
+};
+
+#define STA_BIT(f) (1ULL << STA_F_##f)
+#define STA_HAS(s, f) ((s)->present & STA_BIT(f))
+
+/* station_rate.flags, a bit per optional rate info sub attribute */
+enum station_rate_flag {
+  STA_RATE_MCS = 1 << 0,
+  STA_RATE_VHT_MCS = 1 << 1,
+  STA_RATE_VHT_NSS = 1 << 2,
+  STA_RATE_HE_MCS = 1 << 3,
+  STA_RATE_HE_NSS = 1 << 4,
+  STA_RATE_HE_GI = 1 << 5,
+  STA_RATE_HE_DCM = 1 << 6,
+  STA_RATE_HE_RU_ALLOC = 1 << 7,
+  STA_RATE_EHT_MCS = 1 << 8,
+  STA_RATE_EHT_NSS = 1 << 9,
+  STA_RATE_EHT_GI = 1 << 10,
+  STA_RATE_EHT_RU_ALLOC = 1 << 11,
+  STA_RATE_40MHZ = 1 << 12,
+  STA_RATE_80MHZ = 1 << 13,
+  STA_RATE_80P80MHZ = 1 << 14,
+  STA_RATE_160MHZ = 1 << 15,
+  STA_RATE_320MHZ = 1 << 16,
+  STA_RATE_SHORT_GI = 1 << 17,
+};
+
+struct station_rate {
+  uint32_t bitrate; /* 100 kbit/s units, 0 if unknown */
+  uint32_t flags;   /* enum station_rate_flag */
+  uint8_t mcs, vht_mcs, vht_nss;
+  uint8_t he_mcs, he_nss, he_gi, he_dcm, he_ru_alloc;
+  uint8_t eht_mcs, eht_nss, eht_gi, eht_ru_alloc;
+};
+
+/* station_bss_param.flags */
+enum station_bss_flag {
+  STA_BSS_DTIM_PERIOD = 1 << 0,
+  STA_BSS_BEACON_INTERVAL = 1 << 1,
+  STA_BSS_CTS_PROT = 1 << 2,
+  STA_BSS_SHORT_PREAMBLE = 1 << 3,
+  STA_BSS_SHORT_SLOT_TIME = 1 << 4,
+};
+
+struct station_bss_param {
+  uint16_t beacon_interval;
+  uint8_t dtim_period;
+  uint8_t flags; /* enum station_bss_flag */
+};
+
+/* station_tid.present, bit (1 << NL80211_TID_STATS_*) */
+struct station_tid {
+  uint64_t rx_msdu, tx_msdu, tx_msdu_retries, tx_msdu_failed;
+  uint32_t txq[NL80211_TXQ_STATS_TX_PACKETS + 1]; /* indexed by NL80211_TXQ_STATS_* */
+  uint16_t txq_present;                           /* bit (1 << NL80211_TXQ_STATS_*) */
+  uint8_t present;
+};
+
+/* Change since the previous sample of the same station, see rates.h.
+ * Counter deltas are valid only if their STA_F_* bit is set in 'present',
+ * that is if both samples carried the counter. 32-bit counters are wrap
+ * corrected, a 64-bit counter that went backwards counts from zero. */
+struct station_delta {
+  uint64_t present; /* STA_BIT() of the source counters */
+  uint32_t interval_ms;
+  uint32_t rx_packets, tx_packets;
+  uint32_t tx_retries, tx_failed;
+  uint32_t beacon_loss;
+  uint64_t rx_bytes, tx_bytes;
+  uint64_t rx_drop_misc;
+  double rx_bytes_rate, tx_bytes_rate; /* per second */
+  double rx_packets_rate, tx_packets_rate;
+  double retry_ratio; /* tx_retries / tx_packets, 0 without tx packets */
+  double fail_ratio;  /* tx_failed / tx_packets */
+};
+
+/* Fixed size, no pointers into the netlink buffer: a sample outlives the
+ * message it was decoded from. Fields are valid only if their STA_F_* bit is
+ * set in 'present'. Hot fields come first, TID stats last. */
+struct station_sample {
+  uint64_t present; /* 1 << STA_F_* */
+  uint8_t mac[STATION_MAC_LEN];
+  int8_t signal, signal_avg;
+  uint32_t ifindex;
+  uint32_t inactive_time; /* ms */
+  uint64_t rx_bytes, tx_bytes;
+  uint32_t rx_packets, tx_packets;
+  uint32_t tx_retries, tx_failed;
+  uint32_t beacon_loss;
+  uint32_t expected_throughput; /* kbit/s */
+  uint64_t rx_drop_misc;
+  uint64_t now_ms;  /* wall clock of the dump, ms */
+  uint64_t boot_ns; /* CLOCK_BOOTTIME of the dump, ns */
+
+  struct station_rate tx_rate, rx_rate;
+  int8_t chain_signal[STATION_MAX_CHAINS];
+  int8_t chain_signal_avg[STATION_MAX_CHAINS];
+  uint8_t chains, chains_avg;
+  int8_t beacon_signal_avg, ack_signal, ack_signal_avg;
+  uint8_t plink_state;
+  uint8_t connected_to_gate, connected_to_as;
+  uint16_t airtime_weight;
+  uint16_t llid, plid;
+  uint32_t generation;
+  uint32_t connected_time; /* s */
+  uint32_t airtime_link_metric;
+  uint32_t local_pm, peer_pm, nonpeer_pm; /* enum nl80211_mesh_power_mode */
+  uint64_t beacon_rx;
+  uint64_t t_offset;    /* us */
+  uint64_t tx_duration; /* us */
+  uint64_t rx_duration; /* us */
+  uint64_t assoc_at_boottime; /* ns */
+  struct nl80211_sta_flag_update sta_flags;
+  struct station_bss_param bss_param;
+  struct station_delta delta;
+  uint8_t ipv4[4];  /* network order */
+  uint8_t ipv6[16]; /* global before link local */
+
+  uint16_t attrs[STATION_MAX_ATTRS]; /* top level attribute types, for tracing */
+  uint8_t nattrs;
+  uint8_t event; /* 0 for dumps, NL80211_CMD_NEW/DEL_STATION for notifications,
+                  * RTM_NEWNEIGH/DELNEIGH when the station's neighbour entry changed */
+  uint8_t ntids;
+  struct station_tid tid[STATION_MAX_TIDS];
+} __attribute__((aligned(64)));
+
+/* station_decode() flags */
+#define STATION_DECODE_TIDS (1 << 0) /* also decode per TID statistics */
+
+#define STATION_FIELDS_ALL (~0ULL) /* station_decode() 'fields': no projection */
+
+/* Fill 's' from one NL80211_CMD_NEW_STATION message. Does not allocate and
+ * does not touch now_ms/boot_ns, those are stamped once per dump by the
+ * caller. Only the STA_BIT()s in 'fields' are decoded, nested attributes
+ * outside of it are skipped unparsed; ifindex and MAC always are. Returns 0,
+ * -ENODATA if the station info is missing or -EINVAL if a nested attribute
+ * could not be parsed. */
+int station_decode(const struct nlmsghdr *nlh, struct station_sample *s, unsigned flags,
+                   uint64_t fields);
+
+/* STA_BIT()s of the field called 'name' ('len' bytes, the JSON key), 0 if
+ * there is none. rx_bytes and tx_bytes include their 64-bit bit. */
+uint64_t station_field_bits(const char *name, size_t len);
+
+/* set now_ms and boot_ns to the current wall clock and boot time */
+void station_stamp(struct station_sample *s);
+
+#ifndef STATION_NO_LIBNL
+/* Same result through nla_parse() attribute tables (station_nla.c), the
+ * previous implementation, kept as a reference for the decode benchmark.
+ * The only libnl user, left out of NOLIBNL=1 builds. */
+int station_decode_nla(const struct nlmsghdr *nlh, struct station_sample *s, unsigned flags);
+#endif
+
+#endif // NETLINK_DEMO_STATION_H
@@ -0,0 +1,86 @@
+//
+// binary station record stream, see README "Binary output"
+//
+
+#ifndef NETLINK_DEMO_STATION_BIN_H
+#define NETLINK_DEMO_STATION_BIN_H
+
+#include <stdint.h>
+
+#define STATION_BIN_MAGIC "STAB"
+#define STATION_BIN_VERSION 4 /* 2: delta_* fields, 3: event, 4: ipv4/ipv6 */
+#define STATION_BIN_BYTE_ORDER 0x0102 /* reads 0x0201 on a foreign endian host */
+
+/* The stream starts with one header, followed by 'nfields' field
+ * descriptors, followed by fixed size records until EOF. All integers are in
+ * the writer's byte order. A reader may map records onto struct
+ * station_record when version and record_size match, or use the descriptors
+ * to pick fields by name. With -f the descriptors and records hold only the
+ * selected fields (ts_ms, present and event always), packed in struct order,
+ * and record_size is their sum. */
+struct station_bin_header {
+  char magic[4];        /* STATION_BIN_MAGIC, not NUL terminated */
+  uint16_t version;     /* STATION_BIN_VERSION */
+  uint16_t byte_order;  /* STATION_BIN_BYTE_ORDER */
+  uint16_t record_size; /* sizeof(struct station_record) */
+  uint16_t nfields;
+};
+
+enum station_bin_type {
+  STATION_BIN_UINT = 1, /* unsigned integer of 'size' bytes */
+  STATION_BIN_INT = 2,  /* signed integer of 'size' bytes */
+  STATION_BIN_BYTES = 3 /* raw bytes, e.g. the MAC address */
+};
+
+struct station_bin_field {
+  char name[24]; /* NUL padded */
+  uint16_t offset;
+  uint8_t size;
+  uint8_t type; /* enum station_bin_type */
+  uint8_t count; /* array elements, 1 for scalars */
+  uint8_t pad[3];
+};
+
+/* One station in one sample. Fields are valid only if their STA_F_* bit
+ * (station.h) is set in 'present'. Bitrates are in 100 kbit/s units. The
+ * delta_* fields are wrap corrected changes since the previous sample of the
+ * station, zero if the counter was missing from either sample. */
+struct station_record {
+  uint64_t ts_ms; /* wall clock of the dump */
+  uint64_t present;
+  uint64_t rx_bytes, tx_bytes;
+  uint64_t rx_drop_misc;
+  uint64_t beacon_rx;
+  uint64_t tx_duration, rx_duration; /* us */
+  uint64_t delta_rx_bytes, delta_tx_bytes; /* watch mode, STA_F_DELTA */
+  uint64_t delta_rx_drop_misc;
+  uint32_t ifindex;
+  uint32_t generation;
+  uint32_t inactive_time; /* ms */
+  uint32_t connected_time; /* s */
+  uint32_t rx_packets, tx_packets;
+  uint32_t tx_retries, tx_failed;
+  uint32_t beacon_loss;
+  uint32_t expected_throughput; /* kbit/s */
+  uint32_t tx_bitrate, rx_bitrate;
+  uint32_t tx_rate_flags, rx_rate_flags; /* enum station_rate_flag */
+  uint32_t sta_flags_mask, sta_flags_set;
+  uint32_t delta_interval_ms; /* 0 without STA_F_DELTA */
+  uint32_t delta_rx_packets, delta_tx_packets;
+  uint32_t delta_tx_retries, delta_tx_failed;
+  uint32_t delta_beacon_loss;
+  uint8_t mac[6];
+  int8_t signal, signal_avg;
+  int8_t ack_signal, ack_signal_avg;
+  int8_t beacon_signal_avg;
+  uint8_t chains;
+  int8_t chain_signal[4];
+  uint8_t tx_mcs, rx_mcs; /* HT, VHT, HE or EHT MCS, whichever was reported */
+  uint8_t tx_nss, rx_nss;
+  uint8_t event; /* station_sample.event */
+  uint8_t ipv4[4];  /* network order, STA_F_IPV4 */
+  uint8_t ipv6[16]; /* STA_F_IPV6 */
+  uint8_t reserved[7]; /* zero, keeps the record free of tail padding */
+};
+
+#endif // NETLINK_DEMO_STATION_BIN_H
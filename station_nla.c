@@ -0,0 +1,348 @@
+#include <errno.h>
+#include <string.h>
+
+/* libnl-3 */
+#include <netlink/attr.h>
+#include <netlink/msg.h>
+
+/*libnl-gen-3*/
+#include <netlink/genl/genl.h>
+
+#include "station.h"
+
+/* Reference decoder: nla_parse() into full attribute tables. station_decode()
+ * replaced it on the hot path, it is kept to cross-check and benchmark the
+ * single pass walker. */
+
+static const struct nla_policy stats_policy[NL80211_STA_INFO_MAX + 1] = {
+    [NL80211_STA_INFO_INACTIVE_TIME] = {.type = NLA_U32},
+    [NL80211_STA_INFO_RX_BYTES] = {.type = NLA_U32},
+    [NL80211_STA_INFO_TX_BYTES] = {.type = NLA_U32},
+    [NL80211_STA_INFO_RX_BYTES64] = {.type = NLA_U64},
+    [NL80211_STA_INFO_TX_BYTES64] = {.type = NLA_U64},
+    [NL80211_STA_INFO_RX_PACKETS] = {.type = NLA_U32},
+    [NL80211_STA_INFO_TX_PACKETS] = {.type = NLA_U32},
+    [NL80211_STA_INFO_BEACON_RX] = {.type = NLA_U64},
+    [NL80211_STA_INFO_SIGNAL] = {.type = NLA_U8},
+    [NL80211_STA_INFO_T_OFFSET] = {.type = NLA_U64},
+    [NL80211_STA_INFO_TX_BITRATE] = {.type = NLA_NESTED},
+    [NL80211_STA_INFO_RX_BITRATE] = {.type = NLA_NESTED},
+    [NL80211_STA_INFO_LLID] = {.type = NLA_U16},
+    [NL80211_STA_INFO_PLID] = {.type = NLA_U16},
+    [NL80211_STA_INFO_PLINK_STATE] = {.type = NLA_U8},
+    [NL80211_STA_INFO_TX_RETRIES] = {.type = NLA_U32},
+    [NL80211_STA_INFO_TX_FAILED] = {.type = NLA_U32},
+    [NL80211_STA_INFO_BEACON_LOSS] = {.type = NLA_U32},
+    [NL80211_STA_INFO_RX_DROP_MISC] = {.type = NLA_U64},
+    [NL80211_STA_INFO_STA_FLAGS] = {.minlen = sizeof(struct nl80211_sta_flag_update)},
+    [NL80211_STA_INFO_LOCAL_PM] = {.type = NLA_U32},
+    [NL80211_STA_INFO_PEER_PM] = {.type = NLA_U32},
+    [NL80211_STA_INFO_NONPEER_PM] = {.type = NLA_U32},
+    [NL80211_STA_INFO_CHAIN_SIGNAL] = {.type = NLA_NESTED},
+    [NL80211_STA_INFO_CHAIN_SIGNAL_AVG] = {.type = NLA_NESTED},
+    [NL80211_STA_INFO_TID_STATS] = {.type = NLA_NESTED},
+    [NL80211_STA_INFO_BSS_PARAM] = {.type = NLA_NESTED},
+    [NL80211_STA_INFO_RX_DURATION] = {.type = NLA_U64},
+    [NL80211_STA_INFO_TX_DURATION] = {.type = NLA_U64},
+    [NL80211_STA_INFO_ACK_SIGNAL] = {.type = NLA_U8},
+    [NL80211_STA_INFO_ACK_SIGNAL_AVG] = {.type = NLA_U8},
+    [NL80211_STA_INFO_AIRTIME_LINK_METRIC] = {.type = NLA_U32},
+    [NL80211_STA_INFO_CONNECTED_TO_AS] = {.type = NLA_U8},
+    [NL80211_STA_INFO_CONNECTED_TO_GATE] = {.type = NLA_U8},
+};
+
+static int decode_txq_stats(struct nlattr *txq_stats_attr, struct station_tid *tid) {
+  struct nlattr *txqstats_info[NL80211_TXQ_STATS_MAX + 1];
+  static const struct nla_policy txqstats_policy[NL80211_TXQ_STATS_MAX + 1] = {
+      [NL80211_TXQ_STATS_BACKLOG_BYTES] = {.type = NLA_U32},
+      [NL80211_TXQ_STATS_BACKLOG_PACKETS] = {.type = NLA_U32},
+      [NL80211_TXQ_STATS_FLOWS] = {.type = NLA_U32},
+      [NL80211_TXQ_STATS_DROPS] = {.type = NLA_U32},
+      [NL80211_TXQ_STATS_ECN_MARKS] = {.type = NLA_U32},
+      [NL80211_TXQ_STATS_OVERLIMIT] = {.type = NLA_U32},
+      [NL80211_TXQ_STATS_COLLISIONS] = {.type = NLA_U32},
+      [NL80211_TXQ_STATS_TX_BYTES] = {.type = NLA_U32},
+      [NL80211_TXQ_STATS_TX_PACKETS] = {.type = NLA_U32},
+  };
+  int i;
+
+  if (nla_parse_nested(txqstats_info, NL80211_TXQ_STATS_MAX, txq_stats_attr,
+                       txqstats_policy))
+    return -EINVAL;
+
+  tid->txq_present = 0;
+  for (i = NL80211_TXQ_STATS_BACKLOG_BYTES; i <= NL80211_TXQ_STATS_TX_PACKETS; i++) {
+    if (!txqstats_info[i]) continue;
+    tid->txq[i] = nla_get_u32(txqstats_info[i]);
+    tid->txq_present |= 1 << i;
+  }
+  return 0;
+}
+
+static int decode_tid_stats(struct nlattr *tid_stats_attr, struct station_sample *s) {
+  struct nlattr *stats_info[NL80211_TID_STATS_MAX + 1], *tidattr, *info;
+  static const struct nla_policy tid_policy[NL80211_TID_STATS_MAX + 1] = {
+      [NL80211_TID_STATS_RX_MSDU] = {.type = NLA_U64},
+      [NL80211_TID_STATS_TX_MSDU] = {.type = NLA_U64},
+      [NL80211_TID_STATS_TX_MSDU_RETRIES] = {.type = NLA_U64},
+      [NL80211_TID_STATS_TX_MSDU_FAILED] = {.type = NLA_U64},
+      [NL80211_TID_STATS_TXQ_STATS] = {.type = NLA_NESTED},
+  };
+  int rem;
+
+  s->ntids = 0;
+  nla_for_each_nested(tidattr, tid_stats_attr, rem) {
+    struct station_tid *tid;
+
+    if (s->ntids == STATION_MAX_TIDS) break;
+    if (nla_parse_nested(stats_info, NL80211_TID_STATS_MAX, tidattr, tid_policy))
+      return -EINVAL;
+
+    tid = &s->tid[s->ntids++];
+    tid->present = 0;
+    tid->txq_present = 0;
+#define TID_U64(key, field)                             \
+  do {                                                  \
+    info = stats_info[NL80211_TID_STATS_##key];         \
+    if (info) {                                         \
+      tid->field = nla_get_u64(info);                   \
+      tid->present |= 1 << NL80211_TID_STATS_##key;     \
+    }                                                   \
+  } while (0)
+
+    TID_U64(RX_MSDU, rx_msdu);
+    TID_U64(TX_MSDU, tx_msdu);
+    TID_U64(TX_MSDU_RETRIES, tx_msdu_retries);
+    TID_U64(TX_MSDU_FAILED, tx_msdu_failed);
+
+#undef TID_U64
+    info = stats_info[NL80211_TID_STATS_TXQ_STATS];
+    if (info) {
+      if (decode_txq_stats(info, tid)) return -EINVAL;
+      tid->present |= 1 << NL80211_TID_STATS_TXQ_STATS;
+    }
+  }
+  return 0;
+}
+
+static int decode_bss_param(struct nlattr *bss_param_attr, struct station_bss_param *bss) {
+  struct nlattr *bss_param_info[NL80211_STA_BSS_PARAM_MAX + 1];
+  static const struct nla_policy bss_policy[NL80211_STA_BSS_PARAM_MAX + 1] = {
+      [NL80211_STA_BSS_PARAM_CTS_PROT] = {.type = NLA_FLAG},
+      [NL80211_STA_BSS_PARAM_SHORT_PREAMBLE] = {.type = NLA_FLAG},
+      [NL80211_STA_BSS_PARAM_SHORT_SLOT_TIME] = {.type = NLA_FLAG},
+      [NL80211_STA_BSS_PARAM_DTIM_PERIOD] = {.type = NLA_U8},
+      [NL80211_STA_BSS_PARAM_BEACON_INTERVAL] = {.type = NLA_U16},
+  };
+
+  if (nla_parse_nested(bss_param_info, NL80211_STA_BSS_PARAM_MAX,
+                       bss_param_attr, bss_policy))
+    return -EINVAL;
+
+  bss->flags = 0;
+  if (bss_param_info[NL80211_STA_BSS_PARAM_DTIM_PERIOD]) {
+    bss->dtim_period = nla_get_u8(bss_param_info[NL80211_STA_BSS_PARAM_DTIM_PERIOD]);
+    bss->flags |= STA_BSS_DTIM_PERIOD;
+  }
+  if (bss_param_info[NL80211_STA_BSS_PARAM_BEACON_INTERVAL]) {
+    bss->beacon_interval = nla_get_u16(bss_param_info[NL80211_STA_BSS_PARAM_BEACON_INTERVAL]);
+    bss->flags |= STA_BSS_BEACON_INTERVAL;
+  }
+  if (bss_param_info[NL80211_STA_BSS_PARAM_CTS_PROT])
+    bss->flags |= STA_BSS_CTS_PROT;
+  if (bss_param_info[NL80211_STA_BSS_PARAM_SHORT_PREAMBLE])
+    bss->flags |= STA_BSS_SHORT_PREAMBLE;
+  if (bss_param_info[NL80211_STA_BSS_PARAM_SHORT_SLOT_TIME])
+    bss->flags |= STA_BSS_SHORT_SLOT_TIME;
+  return 0;
+}
+
+static uint8_t decode_chain_signal(struct nlattr *attr_list, int8_t *chains) {
+  struct nlattr *attr;
+  int rem;
+  uint8_t i = 0;
+
+  nla_for_each_nested(attr, attr_list, rem) {
+    if (i == STATION_MAX_CHAINS) break;
+    chains[i++] = (int8_t)nla_get_u8(attr);
+  }
+  return i;
+}
+
+static int decode_bitrate(struct nlattr *bitrate_attr, struct station_rate *r) {
+  struct nlattr *rinfo[NL80211_RATE_INFO_MAX + 1];
+  static const struct nla_policy rate_policy[NL80211_RATE_INFO_MAX + 1] = {
+      [NL80211_RATE_INFO_BITRATE] = {.type = NLA_U16},
+      [NL80211_RATE_INFO_BITRATE32] = {.type = NLA_U32},
+      [NL80211_RATE_INFO_MCS] = {.type = NLA_U8},
+      [NL80211_RATE_INFO_40_MHZ_WIDTH] = {.type = NLA_FLAG},
+      [NL80211_RATE_INFO_SHORT_GI] = {.type = NLA_FLAG},
+  };
+
+  if (nla_parse_nested(rinfo, NL80211_RATE_INFO_MAX, bitrate_attr, rate_policy))
+    return -EINVAL;
+
+  r->bitrate = 0;
+  r->flags = 0;
+  if (rinfo[NL80211_RATE_INFO_BITRATE32])
+    r->bitrate = nla_get_u32(rinfo[NL80211_RATE_INFO_BITRATE32]);
+  else if (rinfo[NL80211_RATE_INFO_BITRATE])
+    r->bitrate = nla_get_u16(rinfo[NL80211_RATE_INFO_BITRATE]);
+
+#define RATE_U8(key, field)                         \
+  do {                                              \
+    if (rinfo[NL80211_RATE_INFO_##key]) {           \
+      r->field = nla_get_u8(rinfo[NL80211_RATE_INFO_##key]); \
+      r->flags |= STA_RATE_##key;                   \
+    }                                               \
+  } while (0)
+#define RATE_FLAG(key, flag)                        \
+  do {                                              \
+    if (rinfo[NL80211_RATE_INFO_##key])             \
+      r->flags |= flag;                             \
+  } while (0)
+
+  RATE_U8(MCS, mcs);
+  RATE_U8(VHT_MCS, vht_mcs);
+  RATE_U8(VHT_NSS, vht_nss);
+  RATE_U8(HE_MCS, he_mcs);
+  RATE_U8(HE_NSS, he_nss);
+  RATE_U8(HE_GI, he_gi);
+  RATE_U8(HE_DCM, he_dcm);
+  RATE_U8(HE_RU_ALLOC, he_ru_alloc);
+  RATE_U8(EHT_MCS, eht_mcs);
+  RATE_U8(EHT_NSS, eht_nss);
+  RATE_U8(EHT_GI, eht_gi);
+  RATE_U8(EHT_RU_ALLOC, eht_ru_alloc);
+  RATE_FLAG(40_MHZ_WIDTH, STA_RATE_40MHZ);
+  RATE_FLAG(80_MHZ_WIDTH, STA_RATE_80MHZ);
+  RATE_FLAG(80P80_MHZ_WIDTH, STA_RATE_80P80MHZ);
+  RATE_FLAG(160_MHZ_WIDTH, STA_RATE_160MHZ);
+  RATE_FLAG(320_MHZ_WIDTH, STA_RATE_320MHZ);
+  RATE_FLAG(SHORT_GI, STA_RATE_SHORT_GI);
+
+#undef RATE_FLAG
+#undef RATE_U8
+  return 0;
+}
+
+int station_decode_nla(const struct nlmsghdr *nlh, struct station_sample *s, unsigned flags) {
+  struct nlattr *tb_msg[NL80211_ATTR_MAX + 1];
+  struct nlattr *sinfo[NL80211_STA_INFO_MAX + 1];
+  struct genlmsghdr *gnlh = nlmsg_data(nlh);
+  int i;
+
+  s->present = 0;
+  s->nattrs = 0;
+  s->ntids = 0;
+
+  nla_parse(tb_msg, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), NULL);
+
+  for (i = 0; i <= NL80211_ATTR_MAX && s->nattrs < STATION_MAX_ATTRS; i++) {
+    if (tb_msg[i] == NULL) continue;
+    s->attrs[s->nattrs++] = i;
+  }
+
+  if (tb_msg[NL80211_ATTR_IFINDEX]) {
+    s->ifindex = nla_get_u32(tb_msg[NL80211_ATTR_IFINDEX]);
+    s->present |= STA_BIT(IFINDEX);
+  }
+  if (tb_msg[NL80211_ATTR_MAC]) {
+    memcpy(s->mac, nla_data(tb_msg[NL80211_ATTR_MAC]), STATION_MAC_LEN);
+    s->present |= STA_BIT(MAC);
+  }
+  if (tb_msg[NL80211_ATTR_GENERATION]) {
+    s->generation = nla_get_u32(tb_msg[NL80211_ATTR_GENERATION]);
+    s->present |= STA_BIT(GENERATION);
+  }
+
+  if (!tb_msg[NL80211_ATTR_STA_INFO]) return -ENODATA;
+  if (nla_parse_nested(sinfo, NL80211_STA_INFO_MAX, tb_msg[NL80211_ATTR_STA_INFO],
+                       stats_policy))
+    return -EINVAL;
+
+#define GET(key, field, getter)                     \
+  do {                                              \
+    if (sinfo[NL80211_STA_INFO_##key]) {            \
+      s->field = getter(sinfo[NL80211_STA_INFO_##key]); \
+      s->present |= STA_BIT(key);                   \
+    }                                               \
+  } while (0)
+
+  GET(INACTIVE_TIME, inactive_time, nla_get_u32);
+  if (sinfo[NL80211_STA_INFO_RX_BYTES64]) {
+    s->rx_bytes = nla_get_u64(sinfo[NL80211_STA_INFO_RX_BYTES64]);
+    s->present |= STA_BIT(RX_BYTES) | STA_BIT(RX_BYTES64);
+  } else if (sinfo[NL80211_STA_INFO_RX_BYTES]) {
+    s->rx_bytes = nla_get_u32(sinfo[NL80211_STA_INFO_RX_BYTES]);
+    s->present |= STA_BIT(RX_BYTES);
+  }
+  GET(RX_PACKETS, rx_packets, nla_get_u32);
+  if (sinfo[NL80211_STA_INFO_TX_BYTES64]) {
+    s->tx_bytes = nla_get_u64(sinfo[NL80211_STA_INFO_TX_BYTES64]);
+    s->present |= STA_BIT(TX_BYTES) | STA_BIT(TX_BYTES64);
+  } else if (sinfo[NL80211_STA_INFO_TX_BYTES]) {
+    s->tx_bytes = nla_get_u32(sinfo[NL80211_STA_INFO_TX_BYTES]);
+    s->present |= STA_BIT(TX_BYTES);
+  }
+  GET(TX_PACKETS, tx_packets, nla_get_u32);
+  GET(TX_RETRIES, tx_retries, nla_get_u32);
+  GET(TX_FAILED, tx_failed, nla_get_u32);
+  GET(BEACON_LOSS, beacon_loss, nla_get_u32);
+  GET(BEACON_RX, beacon_rx, nla_get_u64);
+  GET(RX_DROP_MISC, rx_drop_misc, nla_get_u64);
+  GET(SIGNAL, signal, (int8_t)nla_get_u8);
+  GET(SIGNAL_AVG, signal_avg, (int8_t)nla_get_u8);
+  GET(BEACON_SIGNAL_AVG, beacon_signal_avg, (int8_t)nla_get_u8);
+  GET(T_OFFSET, t_offset, nla_get_u64);
+  GET(TX_DURATION, tx_duration, nla_get_u64);
+  GET(RX_DURATION, rx_duration, nla_get_u64);
+  GET(ACK_SIGNAL, ack_signal, (int8_t)nla_get_u8);
+  GET(ACK_SIGNAL_AVG, ack_signal_avg, (int8_t)nla_get_u8);
+  GET(AIRTIME_WEIGHT, airtime_weight, nla_get_u16);
+  GET(EXPECTED_THROUGHPUT, expected_throughput, nla_get_u32);
+  GET(LLID, llid, nla_get_u16);
+  GET(PLID, plid, nla_get_u16);
+  GET(PLINK_STATE, plink_state, nla_get_u8);
+  GET(AIRTIME_LINK_METRIC, airtime_link_metric, nla_get_u32);
+  GET(CONNECTED_TO_GATE, connected_to_gate, nla_get_u8);
+  GET(CONNECTED_TO_AS, connected_to_as, nla_get_u8);
+  GET(LOCAL_PM, local_pm, nla_get_u32);
+  GET(PEER_PM, peer_pm, nla_get_u32);
+  GET(NONPEER_PM, nonpeer_pm, nla_get_u32);
+  GET(CONNECTED_TIME, connected_time, nla_get_u32);
+  GET(ASSOC_AT_BOOTTIME, assoc_at_boottime, nla_get_u64);
+
+#undef GET
+
+  if (sinfo[NL80211_STA_INFO_CHAIN_SIGNAL]) {
+    s->chains = decode_chain_signal(sinfo[NL80211_STA_INFO_CHAIN_SIGNAL], s->chain_signal);
+    s->present |= STA_BIT(CHAIN_SIGNAL);
+  }
+  if (sinfo[NL80211_STA_INFO_CHAIN_SIGNAL_AVG]) {
+    s->chains_avg = decode_chain_signal(sinfo[NL80211_STA_INFO_CHAIN_SIGNAL_AVG],
+                                        s->chain_signal_avg);
+    s->present |= STA_BIT(CHAIN_SIGNAL_AVG);
+  }
+  if (sinfo[NL80211_STA_INFO_TX_BITRATE]) {
+    if (decode_bitrate(sinfo[NL80211_STA_INFO_TX_BITRATE], &s->tx_rate)) return -EINVAL;
+    s->present |= STA_BIT(TX_BITRATE);
+  }
+  if (sinfo[NL80211_STA_INFO_RX_BITRATE]) {
+    if (decode_bitrate(sinfo[NL80211_STA_INFO_RX_BITRATE], &s->rx_rate)) return -EINVAL;
+    s->present |= STA_BIT(RX_BITRATE);
+  }
+  if (sinfo[NL80211_STA_INFO_STA_FLAGS]) {
+    memcpy(&s->sta_flags, nla_data(sinfo[NL80211_STA_INFO_STA_FLAGS]), sizeof(s->sta_flags));
+    s->present |= STA_BIT(STA_FLAGS);
+  }
+  if (sinfo[NL80211_STA_INFO_TID_STATS] && (flags & STATION_DECODE_TIDS)) {
+    if (decode_tid_stats(sinfo[NL80211_STA_INFO_TID_STATS], s)) return -EINVAL;
+    s->present |= STA_BIT(TID_STATS);
+  }
+  if (sinfo[NL80211_STA_INFO_BSS_PARAM]) {
+    if (decode_bss_param(sinfo[NL80211_STA_INFO_BSS_PARAM], &s->bss_param)) return -EINVAL;
+    s->present |= STA_BIT(BSS_PARAM);
+  }
+  return 0;
+}
@@ -0,0 +1,171 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "station_table.h"
+
+/* every column, keys first */
+#define STATION_TABLE_COLUMNS(X) \
+  X(ifindex)                     \
+  X(mac)                         \
+  X(seen)                        \
+  X(present)                     \
+  X(boot_ns)                     \
+  X(rx_bytes)                    \
+  X(tx_bytes)                    \
+  X(rx_drop_misc)                \
+  X(rx_packets)                  \
+  X(tx_packets)                  \
+  X(tx_retries)                  \
+  X(tx_failed)                   \
+  X(beacon_loss)                 \
+  X(connected_time)
+
+#define COLUMN_ALIGN 64 /* each column starts on its own cache line */
+
+static size_t column_size(size_t elem, uint32_t cap) {
+  return (elem * cap + COLUMN_ALIGN - 1) & ~(size_t)(COLUMN_ALIGN - 1);
+}
+
+static uint32_t station_hash(uint32_t ifindex, uint64_t mac) {
+  uint64_t k = mac ^ (uint64_t)ifindex << 48;
+
+  k *= 0x9e3779b97f4a7c15ULL; /* Fibonacci hashing, the high bits are mixed best */
+  return k >> 32;
+}
+
+static int station_table_alloc(struct station_table *t, uint32_t cap) {
+  size_t size = 0;
+  char *p;
+
+#define X(col) size += column_size(sizeof *t->col, cap);
+  STATION_TABLE_COLUMNS(X)
+#undef X
+  if (posix_memalign(&t->mem, COLUMN_ALIGN, size)) return -ENOMEM;
+  memset(t->mem, 0, size);
+
+  p = t->mem;
+#define X(col)          \
+  t->col = (void *)p;   \
+  p += column_size(sizeof *t->col, cap);
+  STATION_TABLE_COLUMNS(X)
+#undef X
+  t->cap = cap;
+  t->count = 0;
+  return 0;
+}
+
+int station_table_init(struct station_table *t, uint32_t hint) {
+  uint32_t cap = 64;
+
+  while (cap / 4 * 3 < hint) cap *= 2;
+  return station_table_alloc(t, cap);
+}
+
+void station_table_free(struct station_table *t) {
+  free(t->mem);
+  memset(t, 0, sizeof(*t));
+}
+
+int32_t station_table_find(const struct station_table *t, uint32_t ifindex, uint64_t mac) {
+  uint32_t mask = t->cap - 1, i = station_hash(ifindex, mac) & mask;
+
+  for (; t->ifindex[i]; i = (i + 1) & mask) {
+    if (t->mac[i] == mac && t->ifindex[i] == ifindex) return i;
+  }
+  return -1;
+}
+
+static void station_table_move(struct station_table *t, uint32_t to, uint32_t from) {
+#define X(col) t->col[to] = t->col[from];
+  STATION_TABLE_COLUMNS(X)
+#undef X
+}
+
+/* double the capacity, load factor stays at or below 3/4 */
+static int station_table_grow(struct station_table *t) {
+  struct station_table old = *t;
+  uint32_t i;
+
+  if (station_table_alloc(t, old.cap * 2) < 0) {
+    *t = old;
+    return -ENOMEM;
+  }
+  for (i = 0; i < old.cap; i++) {
+    uint32_t mask = t->cap - 1, j;
+
+    if (!old.ifindex[i]) continue;
+    j = station_hash(old.ifindex[i], old.mac[i]) & mask;
+    while (t->ifindex[j]) j = (j + 1) & mask;
+#define X(col) t->col[j] = old.col[i];
+    STATION_TABLE_COLUMNS(X)
+#undef X
+  }
+  t->count = old.count;
+  free(old.mem);
+  return 0;
+}
+
+int32_t station_table_insert(struct station_table *t, uint32_t ifindex, uint64_t mac,
+                             int *created) {
+  uint32_t mask = t->cap - 1, i = station_hash(ifindex, mac) & mask;
+
+  for (; t->ifindex[i]; i = (i + 1) & mask) {
+    if (t->mac[i] == mac && t->ifindex[i] == ifindex) {
+      *created = 0;
+      return i;
+    }
+  }
+
+  if ((t->count + 1) * 4 > t->cap * 3) {
+    if (station_table_grow(t) < 0) return -ENOMEM;
+    mask = t->cap - 1;
+    for (i = station_hash(ifindex, mac) & mask; t->ifindex[i]; i = (i + 1) & mask)
+      ;
+  }
+
+#define X(col) t->col[i] = 0;
+  STATION_TABLE_COLUMNS(X)
+#undef X
+  t->ifindex[i] = ifindex;
+  t->mac[i] = mac;
+  t->count++;
+  *created = 1;
+  return i;
+}
+
+/* Backward shift: walk the probe run after the hole and move back every
+ * entry whose home slot does not lie cyclically between the hole and its
+ * current slot, i.e. that would not be found any more across the hole. */
+void station_table_delete(struct station_table *t, uint32_t slot) {
+  uint32_t mask = t->cap - 1, hole = slot, j = slot;
+
+  for (;;) {
+    uint32_t home;
+
+    j = (j + 1) & mask;
+    if (!t->ifindex[j]) break;
+    home = station_hash(t->ifindex[j], t->mac[j]) & mask;
+    if (((j - home) & mask) >= ((j - hole) & mask)) {
+      station_table_move(t, hole, j);
+      hole = j;
+    }
+  }
+  t->ifindex[hole] = 0;
+  t->count--;
+}
+
+uint32_t station_table_expire(struct station_table *t, uint32_t oldest) {
+  uint32_t i, removed = 0;
+
+  for (i = 0; i < t->cap;) {
+    /* a deletion may shift the next entry into slot i, look at it again */
+    if (t->ifindex[i] && (int32_t)(t->seen[i] - oldest) < 0) {
+      station_table_delete(t, i);
+      removed++;
+    } else {
+      i++;
+    }
+  }
+  return removed;
+}
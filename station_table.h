@@ -0,0 +1,60 @@
+//
+// open addressing station table keyed by (ifindex, MAC)
+//
+
+#ifndef NETLINK_DEMO_STATION_TABLE_H
+#define NETLINK_DEMO_STATION_TABLE_H
+
+#include <stdint.h>
+
+/* Linear probing over power of two sized columns (structure of arrays): a
+ * lookup only touches the key columns, the counters of a station are read
+ * once it is found. Deletion shifts the following entries of the probe run
+ * back instead of leaving tombstones, so lookups never slow down with
+ * association churn. Free slots have ifindex 0, which no interface uses. */
+struct station_table {
+  uint32_t cap, count;
+
+  /* keys */
+  uint32_t *ifindex;
+  uint64_t *mac; /* station_table_mac() */
+
+  /* values, previous sample of the station */
+  uint32_t *seen; /* round of the last update */
+  uint64_t *present;
+  uint64_t *boot_ns;
+  uint64_t *rx_bytes, *tx_bytes, *rx_drop_misc;
+  uint32_t *rx_packets, *tx_packets;
+  uint32_t *tx_retries, *tx_failed;
+  uint32_t *beacon_loss;
+  uint32_t *connected_time;
+
+  void *mem; /* one allocation for all columns */
+};
+
+/* MAC address packed into the low 48 bits */
+static inline uint64_t station_table_mac(const uint8_t *mac) {
+  return (uint64_t)mac[0] << 40 | (uint64_t)mac[1] << 32 | (uint64_t)mac[2] << 24 |
+         (uint64_t)mac[3] << 16 | (uint64_t)mac[4] << 8 | mac[5];
+}
+
+/* room for 'hint' stations without growing */
+int station_table_init(struct station_table *t, uint32_t hint);
+void station_table_free(struct station_table *t);
+
+/* slot of the station, -1 if not present */
+int32_t station_table_find(const struct station_table *t, uint32_t ifindex, uint64_t mac);
+
+/* slot of the station, added with zeroed values if missing ('*created' set).
+ * May grow the table, which moves every slot. Returns -ENOMEM on failure. */
+int32_t station_table_insert(struct station_table *t, uint32_t ifindex, uint64_t mac,
+                             int *created);
+
+/* remove the station in 'slot', entries behind it may move into 'slot' */
+void station_table_delete(struct station_table *t, uint32_t slot);
+
+/* remove every station whose last update is older than round 'oldest',
+ * returns the number of stations removed */
+uint32_t station_table_expire(struct station_table *t, uint32_t oldest);
+
+#endif // NETLINK_DEMO_STATION_TABLE_H
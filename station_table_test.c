@@ -0,0 +1,99 @@
+// backward shift deletion and expiry in a probe run that wraps around the end
+
+#include <stdio.h>
+
+#include "station_table.h"
+
+static int failed;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond);      \
+      failed = 1;                                                     \
+    }                                                                 \
+  } while (0)
+
+#define IFINDEX 3
+#define NKEYS 6
+
+/* MACs whose home slot is 'home', the slot an empty table puts them in */
+static uint64_t key_at(struct station_table *t, uint32_t home, uint64_t *next) {
+  int created;
+
+  for (;; (*next)++) {
+    int32_t i = station_table_insert(t, IFINDEX, *next, &created);
+
+    station_table_delete(t, i);
+    if ((uint32_t)i == home) return (*next)++;
+  }
+}
+
+/* every key that should be there is, with the value it was given */
+static void check_keys(const struct station_table *t, const uint64_t *keys, const int *gone) {
+  uint32_t n = 0;
+  int k;
+
+  for (k = 0; k < NKEYS; k++) {
+    int32_t i = station_table_find(t, IFINDEX, keys[k]);
+
+    if (gone[k]) {
+      CHECK(i < 0);
+    } else {
+      CHECK(i >= 0 && t->seen[i] == 10U + k);
+      n++;
+    }
+  }
+  CHECK(t->count == n);
+}
+
+int main(void) {
+  struct station_table t;
+  uint64_t keys[NKEYS], next = 1;
+  int gone[NKEYS] = {0}, created, k;
+  /* two stations at home in each of the last two slots, two in the first:
+   * the run starts at cap - 2 and wraps to slot 3 */
+  uint32_t home[NKEYS];
+
+  if (station_table_init(&t, 8) < 0) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  home[0] = home[1] = t.cap - 2;
+  home[2] = home[3] = t.cap - 1;
+  home[4] = home[5] = 0;
+  for (k = 0; k < NKEYS; k++) keys[k] = key_at(&t, home[k], &next);
+  for (k = 0; k < NKEYS; k++) {
+    int32_t i = station_table_insert(&t, IFINDEX, keys[k], &created);
+
+    CHECK(created && (uint32_t)i == ((home[0] + k) & (t.cap - 1)));
+    t.seen[i] = 10 + k;
+  }
+  check_keys(&t, keys, gone);
+
+  /* the head of the run: everything behind it moves back across the end */
+  station_table_delete(&t, station_table_find(&t, IFINDEX, keys[0]));
+  gone[0] = 1;
+  check_keys(&t, keys, gone);
+  CHECK(t.ifindex[(home[0] + NKEYS - 1) & (t.cap - 1)] == 0); /* the run got shorter */
+
+  /* one past the end: the stations at home in slot 0 must stay reachable */
+  station_table_delete(&t, station_table_find(&t, IFINDEX, keys[3]));
+  gone[3] = 1;
+  check_keys(&t, keys, gone);
+
+  /* expire what was last seen before round 12, only key 1 */
+  CHECK(station_table_expire(&t, 12) == 1);
+  gone[1] = 1;
+  check_keys(&t, keys, gone);
+
+  /* and the rest, one of them at the wrap */
+  CHECK(station_table_expire(&t, 100) == 3);
+  gone[2] = gone[4] = gone[5] = 1;
+  check_keys(&t, keys, gone);
+  for (k = 0; k < (int)t.cap; k++) CHECK(t.ifindex[k] == 0);
+
+  station_table_free(&t);
+  if (!failed) printf("station_table_test: ok\n");
+  return failed;
+}
@@ -0,0 +1,105 @@
+#include <string.h>
+
+#include "stats.h"
+
+static const char *const span_names[STATS_SPANS] = {
+    [STATS_RESOLVE] = "resolve", [STATS_SEND] = "send",     [STATS_RECV] = "recv",
+    [STATS_DECODE] = "decode",   [STATS_FORMAT] = "format", [STATS_WRITE] = "write",
+    [STATS_ROUND] = "round",     [STATS_SCRAPE] = "scrape",
+};
+
+void stats_span_add(struct stats_hist *h, uint64_t ns) {
+  int b = ns ? 63 - __builtin_clzll(ns) : 0;
+
+  h->bucket[b < STATS_BUCKETS ? b : STATS_BUCKETS - 1]++;
+  h->n++;
+  h->sum_ns += ns;
+  if (ns > h->max_ns) h->max_ns = ns;
+}
+
+void stats_merge(struct stats *to, const struct stats *from) {
+  int i, b;
+
+  for (i = 0; i < STATS_COUNTS; i++) to->count[i] += from->count[i];
+  for (i = 0; i < STATS_SPANS; i++) {
+    struct stats_hist *t = &to->span[i];
+    const struct stats_hist *f = &from->span[i];
+
+    for (b = 0; b < STATS_BUCKETS; b++) t->bucket[b] += f->bucket[b];
+    t->n += f->n;
+    t->sum_ns += f->sum_ns;
+    if (f->max_ns > t->max_ns) t->max_ns = f->max_ns;
+  }
+}
+
+void stats_reset(struct stats *s) {
+  int on = s->on;
+
+  memset(s, 0, sizeof(*s));
+  s->on = on;
+}
+
+static const char *fmt_ns(char *buf, size_t len, double ns) {
+  if (ns < 1e3)
+    snprintf(buf, len, "%.0fns", ns);
+  else if (ns < 1e6)
+    snprintf(buf, len, "%.1fus", ns / 1e3);
+  else if (ns < 1e9)
+    snprintf(buf, len, "%.1fms", ns / 1e6);
+  else
+    snprintf(buf, len, "%.2fs", ns / 1e9);
+  return buf;
+}
+
+/* upper bound of the bucket holding quantile 'q', at most the maximum */
+static double hist_quantile(const struct stats_hist *h, double q) {
+  uint64_t seen = 0;
+  int b;
+
+  for (b = 0; b < STATS_BUCKETS - 1; b++) {
+    seen += h->bucket[b];
+    if (seen >= q * h->n) break;
+  }
+  return b < STATS_BUCKETS - 1 && (2ULL << b) < h->max_ns ? (double)(2ULL << b) : h->max_ns;
+}
+
+void stats_print(const struct stats *s, const char *label, FILE *f) {
+  const uint64_t *c = s->count;
+  const struct stats_hist *rounds = &s->span[STATS_ROUND];
+  char a[16], b[16], d[16], e[16];
+  int i, k, spans = 0;
+
+  for (i = 0; i < STATS_SPANS; i++) spans += s->span[i].n > 0;
+
+  flockfile(f);
+  fprintf(f, "stats %s:\n", label);
+  fprintf(f, "  syscalls: send %llu recv %llu write %llu\n", (unsigned long long)c[STATS_SENDS],
+          (unsigned long long)c[STATS_RECVS], (unsigned long long)c[STATS_WRITES]);
+  fprintf(f, "  datagrams %llu", (unsigned long long)c[STATS_DATAGRAMS]);
+  if (rounds->n) fprintf(f, " (%.1f per round)", (double)c[STATS_DATAGRAMS] / rounds->n);
+  fprintf(f, ", bytes in %llu out %llu\n", (unsigned long long)c[STATS_BYTES_IN],
+          (unsigned long long)c[STATS_BYTES_OUT]);
+  fprintf(f,
+          "  stations %llu events %llu parse errors %llu enobufs %llu dropped %llu "
+          "filtered %llu\n",
+          (unsigned long long)c[STATS_STATIONS], (unsigned long long)c[STATS_EVENTS],
+          (unsigned long long)c[STATS_PARSE_ERRORS], (unsigned long long)c[STATS_ENOBUFS],
+          (unsigned long long)c[STATS_DROPPED], (unsigned long long)c[STATS_FILTERED]);
+  if (spans) fprintf(f, "  %-8s %10s %9s %9s %9s %9s\n", "span", "n", "mean", "p50", "p99", "max");
+  for (i = 0; spans && i < STATS_SPANS; i++) {
+    const struct stats_hist *h = &s->span[i];
+
+    if (h->n == 0) continue;
+    fprintf(f, "  %-8s %10llu %9s %9s %9s %9s\n", span_names[i], (unsigned long long)h->n,
+            fmt_ns(a, sizeof(a), (double)h->sum_ns / h->n), fmt_ns(b, sizeof(b), hist_quantile(h, 0.5)),
+            fmt_ns(d, sizeof(d), hist_quantile(h, 0.99)), fmt_ns(e, sizeof(e), h->max_ns));
+    fprintf(f, "          ");
+    for (k = 0; k < STATS_BUCKETS; k++)
+      if (h->bucket[k])
+        fprintf(f, " %s%s:%u", k == STATS_BUCKETS - 1 ? ">" : "<",
+                fmt_ns(a, sizeof(a), (double)(k == STATS_BUCKETS - 1 ? 1ULL << k : 2ULL << k)),
+                h->bucket[k]);
+    fputc('\n', f);
+  }
+  funlockfile(f);
+}
@@ -0,0 +1,86 @@
+//
+// hot path counters and latency histograms, spans only timed with --stats
+//
+
+#ifndef NETLINK_DEMO_STATS_H
+#define NETLINK_DEMO_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* timed steps, CLOCK_MONOTONIC */
+enum stats_span {
+  STATS_RESOLVE, /* nl80211 family and group ids, disk cache included */
+  STATS_SEND,    /* one GET_STATION request */
+  STATS_RECV,    /* one recvmmsg() batch */
+  STATS_DECODE,  /* one station message */
+  STATS_FORMAT,  /* one sample through the formatter */
+  STATS_WRITE,   /* formatter flush and output write of a round or batch */
+  STATS_ROUND,   /* requests sent to the last reply */
+  STATS_SCRAPE,  /* serve: one exporter client, accept to close */
+  STATS_SPANS
+};
+
+enum stats_count {
+  STATS_SENDS, /* syscalls */
+  STATS_RECVS,
+  STATS_WRITES,
+  STATS_DATAGRAMS, /* dump replies */
+  STATS_BYTES_IN,  /* netlink bytes read, notifications included */
+  STATS_BYTES_OUT,
+  STATS_STATIONS, /* station messages decoded */
+  STATS_EVENTS,   /* notifications that made a sample */
+  STATS_PARSE_ERRORS,
+  STATS_ENOBUFS, /* receive queue overflows */
+  STATS_DROPPED, /* worker mode: samples a full ring refused */
+  STATS_FILTERED, /* samples a filter or top-N left out */
+  STATS_COUNTS
+};
+
+/* bucket b counts spans of [2^b, 2^(b+1)) ns, the last one everything longer */
+#define STATS_BUCKETS 36
+
+struct stats_hist {
+  uint64_t n, sum_ns, max_ns;
+  uint32_t bucket[STATS_BUCKETS];
+};
+
+/* One per thread, nothing is shared: workers are merged when they end.
+ * Counters are always kept, spans cost two clock reads and only run when
+ * 'on' is set. */
+struct stats {
+  int on;
+  uint64_t count[STATS_COUNTS];
+  struct stats_hist span[STATS_SPANS];
+};
+
+/* start of a span, 0 if spans are off */
+static inline uint64_t stats_start(const struct stats *s) {
+  struct timespec ts;
+
+  if (!s->on) return 0;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void stats_span_add(struct stats_hist *h, uint64_t ns);
+
+static inline void stats_end(struct stats *s, enum stats_span span, uint64_t start) {
+  if (start) stats_span_add(&s->span[span], stats_start(s) - start);
+}
+
+static inline void stats_count(struct stats *s, enum stats_count c, uint64_t n) {
+  s->count[c] += n;
+}
+
+/* add 'from' to 'to' */
+void stats_merge(struct stats *to, const struct stats *from);
+/* zero everything but 'on' */
+void stats_reset(struct stats *s);
+
+/* Counters, then per span count, mean, p50, p99 and max, and the non-empty
+ * histogram buckets. Written as one block, 'label' heads it. */
+void stats_print(const struct stats *s, const char *label, FILE *f);
+
+#endif // NETLINK_DEMO_STATS_H
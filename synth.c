@@ -0,0 +1,261 @@
+#include <errno.h>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+#include <string.h>
+
+#include "station.h"
+#include "synth.h"
+
+/* the full mix with every TID is about 2.8 KiB */
+#define SYNTH_MSG_MAX 4096
+
+struct synth_msg {
+  unsigned char buf[SYNTH_MSG_MAX] __attribute__((aligned(4)));
+  uint32_t len;
+};
+
+static void put(struct synth_msg *m, uint16_t type, const void *data, uint16_t len) {
+  struct nlattr *a = (struct nlattr *)(m->buf + m->len);
+
+  a->nla_type = type;
+  a->nla_len = NLA_HDRLEN + len;
+  if (len) memcpy(m->buf + m->len + NLA_HDRLEN, data, len);
+  memset(m->buf + m->len + a->nla_len, 0, NLA_ALIGN(a->nla_len) - a->nla_len);
+  m->len += NLA_ALIGN(a->nla_len);
+}
+
+static void put_u8(struct synth_msg *m, uint16_t type, uint8_t v) { put(m, type, &v, sizeof(v)); }
+static void put_u16(struct synth_msg *m, uint16_t type, uint16_t v) { put(m, type, &v, sizeof(v)); }
+static void put_u32(struct synth_msg *m, uint16_t type, uint32_t v) { put(m, type, &v, sizeof(v)); }
+static void put_u64(struct synth_msg *m, uint16_t type, uint64_t v) { put(m, type, &v, sizeof(v)); }
+static void put_flag(struct synth_msg *m, uint16_t type) { put(m, type, NULL, 0); }
+
+/* nests are closed by patching their length, like nla_nest_end() */
+static uint32_t nest_start(struct synth_msg *m, uint16_t type) {
+  uint32_t off = m->len;
+
+  put(m, type | NLA_F_NESTED, NULL, 0);
+  return off;
+}
+
+static void nest_end(struct synth_msg *m, uint32_t off) {
+  ((struct nlattr *)(m->buf + off))->nla_len = m->len - off;
+}
+
+/* xorshift64, seeded per station so every dump is the same */
+static uint64_t synth_rand(uint64_t *state) {
+  uint64_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+/* one of HT, VHT, HE and EHT per station, as nl80211_put_sta_rate() does */
+static void put_rate(struct synth_msg *m, uint16_t type, uint32_t i, uint64_t *rnd) {
+  uint32_t nest = nest_start(m, type), bitrate = 60 + synth_rand(rnd) % 28000;
+
+  put_u32(m, NL80211_RATE_INFO_BITRATE32, bitrate);
+  if (bitrate <= UINT16_MAX) put_u16(m, NL80211_RATE_INFO_BITRATE, bitrate);
+  switch (i & 3) {
+  case 0:
+    put_u8(m, NL80211_RATE_INFO_MCS, synth_rand(rnd) % 32);
+    put_flag(m, NL80211_RATE_INFO_40_MHZ_WIDTH);
+    put_flag(m, NL80211_RATE_INFO_SHORT_GI);
+    break;
+  case 1:
+    put_u8(m, NL80211_RATE_INFO_VHT_MCS, synth_rand(rnd) % 10);
+    put_u8(m, NL80211_RATE_INFO_VHT_NSS, 1 + synth_rand(rnd) % 4);
+    put_flag(m, NL80211_RATE_INFO_80_MHZ_WIDTH);
+    break;
+  case 2:
+    put_u8(m, NL80211_RATE_INFO_HE_MCS, synth_rand(rnd) % 12);
+    put_u8(m, NL80211_RATE_INFO_HE_NSS, 1 + synth_rand(rnd) % 4);
+    put_u8(m, NL80211_RATE_INFO_HE_GI, synth_rand(rnd) % 3);
+    put_u8(m, NL80211_RATE_INFO_HE_DCM, 0);
+    put_flag(m, NL80211_RATE_INFO_160_MHZ_WIDTH);
+    break;
+  default:
+    put_u8(m, NL80211_RATE_INFO_EHT_MCS, synth_rand(rnd) % 14);
+    put_u8(m, NL80211_RATE_INFO_EHT_NSS, 1 + synth_rand(rnd) % 4);
+    put_u8(m, NL80211_RATE_INFO_EHT_GI, synth_rand(rnd) % 3);
+    put_flag(m, NL80211_RATE_INFO_320_MHZ_WIDTH);
+    break;
+  }
+  nest_end(m, nest);
+}
+
+static void put_chains(struct synth_msg *m, uint16_t type, unsigned chains, int8_t signal) {
+  uint32_t nest = nest_start(m, type);
+  unsigned c;
+
+  for (c = 0; c < chains; c++) put_u8(m, c, (uint8_t)(signal - (int8_t)c));
+  nest_end(m, nest);
+}
+
+/* TIDs are numbered from 1, the last one is non-QoS traffic */
+static void put_tids(struct synth_msg *m, unsigned tids, uint64_t *rnd) {
+  uint32_t nest = nest_start(m, NL80211_STA_INFO_TID_STATS), tid, txq;
+  unsigned t, q;
+
+  for (t = 0; t < tids; t++) {
+    uint64_t tx = synth_rand(rnd) % 1000000;
+
+    tid = nest_start(m, t + 1);
+    put_u64(m, NL80211_TID_STATS_RX_MSDU, synth_rand(rnd) % 1000000);
+    put_u64(m, NL80211_TID_STATS_TX_MSDU, tx);
+    put_u64(m, NL80211_TID_STATS_TX_MSDU_RETRIES, tx / 10);
+    put_u64(m, NL80211_TID_STATS_TX_MSDU_FAILED, tx / 1000);
+    txq = nest_start(m, NL80211_TID_STATS_TXQ_STATS);
+    for (q = NL80211_TXQ_STATS_BACKLOG_BYTES; q <= NL80211_TXQ_STATS_TX_PACKETS; q++)
+      put_u32(m, q, synth_rand(rnd) % 100000);
+    nest_end(m, txq);
+    nest_end(m, tid);
+  }
+  nest_end(m, nest);
+}
+
+static void synth_station(struct synth_msg *m, const struct synth_cfg *cfg, uint32_t i) {
+  uint64_t rnd = (i + 1) * 0x9e3779b97f4a7c15ULL;
+  uint8_t mac[STATION_MAC_LEN] = {0x02, 0x5e, i >> 24, i >> 16, i >> 8, i};
+  int8_t signal = -30 - (int8_t)(synth_rand(&rnd) % 60);
+  uint64_t rx_bytes = synth_rand(&rnd) % (1ULL << 40), tx_bytes = synth_rand(&rnd) % (1ULL << 40);
+  uint32_t tx_packets = synth_rand(&rnd) % 100000000, info;
+  struct nlmsghdr *nlh = (struct nlmsghdr *)m->buf;
+  struct genlmsghdr *genl = NLMSG_DATA(nlh);
+
+  memset(m->buf, 0, NLMSG_LENGTH(GENL_HDRLEN));
+  nlh->nlmsg_type = cfg->family_id;
+  nlh->nlmsg_flags = NLM_F_MULTI;
+  genl->cmd = NL80211_CMD_NEW_STATION;
+  m->len = NLMSG_LENGTH(GENL_HDRLEN);
+
+  put_u32(m, NL80211_ATTR_IFINDEX, cfg->ifindex);
+  put(m, NL80211_ATTR_MAC, mac, sizeof(mac));
+  put_u32(m, NL80211_ATTR_GENERATION, 1);
+
+  info = nest_start(m, NL80211_ATTR_STA_INFO);
+  put_u32(m, NL80211_STA_INFO_INACTIVE_TIME, synth_rand(&rnd) % 60000);
+  if (cfg->parts & SYNTH_FLAGS) {
+    put_u32(m, NL80211_STA_INFO_CONNECTED_TIME, synth_rand(&rnd) % 86400);
+    put_u64(m, NL80211_STA_INFO_ASSOC_AT_BOOTTIME, synth_rand(&rnd) % (1ULL << 50));
+  }
+  put_u32(m, NL80211_STA_INFO_RX_BYTES, (uint32_t)rx_bytes);
+  put_u32(m, NL80211_STA_INFO_TX_BYTES, (uint32_t)tx_bytes);
+  put_u64(m, NL80211_STA_INFO_RX_BYTES64, rx_bytes);
+  put_u64(m, NL80211_STA_INFO_TX_BYTES64, tx_bytes);
+  if (cfg->parts & SYNTH_MESH) {
+    put_u16(m, NL80211_STA_INFO_LLID, i & 0xffff);
+    put_u16(m, NL80211_STA_INFO_PLID, ~i & 0xffff);
+    put_u8(m, NL80211_STA_INFO_PLINK_STATE, NL80211_PLINK_ESTAB);
+    put_u32(m, NL80211_STA_INFO_LOCAL_PM, NL80211_MESH_POWER_ACTIVE);
+    put_u32(m, NL80211_STA_INFO_PEER_PM, NL80211_MESH_POWER_ACTIVE);
+    put_u32(m, NL80211_STA_INFO_NONPEER_PM, NL80211_MESH_POWER_ACTIVE);
+    put_u32(m, NL80211_STA_INFO_AIRTIME_LINK_METRIC, synth_rand(&rnd) % 10000);
+    put_u8(m, NL80211_STA_INFO_CONNECTED_TO_GATE, i & 1);
+    put_u8(m, NL80211_STA_INFO_CONNECTED_TO_AS, 1);
+  }
+  if (cfg->parts & SYNTH_SIGNAL) {
+    put_u8(m, NL80211_STA_INFO_SIGNAL, (uint8_t)signal);
+    put_u8(m, NL80211_STA_INFO_SIGNAL_AVG, (uint8_t)(signal + 1));
+  }
+  if (cfg->parts & SYNTH_CHAINS) {
+    put_chains(m, NL80211_STA_INFO_CHAIN_SIGNAL, cfg->chains, signal);
+    put_chains(m, NL80211_STA_INFO_CHAIN_SIGNAL_AVG, cfg->chains, signal + 1);
+  }
+  if (cfg->parts & SYNTH_RATES) {
+    put_rate(m, NL80211_STA_INFO_TX_BITRATE, i, &rnd);
+    put_rate(m, NL80211_STA_INFO_RX_BITRATE, i + 1, &rnd);
+  }
+  put_u32(m, NL80211_STA_INFO_RX_PACKETS, synth_rand(&rnd) % 100000000);
+  put_u32(m, NL80211_STA_INFO_TX_PACKETS, tx_packets);
+  put_u32(m, NL80211_STA_INFO_TX_RETRIES, tx_packets / 8);
+  put_u32(m, NL80211_STA_INFO_TX_FAILED, tx_packets / 500);
+  if (cfg->parts & SYNTH_AIRTIME)
+    put_u32(m, NL80211_STA_INFO_EXPECTED_THROUGHPUT, synth_rand(&rnd) % 2000000);
+  put_u32(m, NL80211_STA_INFO_BEACON_LOSS, synth_rand(&rnd) % 16);
+  if (cfg->parts & SYNTH_BSS) {
+    uint32_t bss = nest_start(m, NL80211_STA_INFO_BSS_PARAM);
+
+    if (i & 1) put_flag(m, NL80211_STA_BSS_PARAM_CTS_PROT);
+    put_flag(m, NL80211_STA_BSS_PARAM_SHORT_PREAMBLE);
+    put_flag(m, NL80211_STA_BSS_PARAM_SHORT_SLOT_TIME);
+    put_u8(m, NL80211_STA_BSS_PARAM_DTIM_PERIOD, 2);
+    put_u16(m, NL80211_STA_BSS_PARAM_BEACON_INTERVAL, 100);
+    nest_end(m, bss);
+  }
+  if (cfg->parts & SYNTH_FLAGS) {
+    struct nl80211_sta_flag_update fl = {
+        .mask = 1 << NL80211_STA_FLAG_AUTHORIZED | 1 << NL80211_STA_FLAG_AUTHENTICATED |
+                1 << NL80211_STA_FLAG_ASSOCIATED | 1 << NL80211_STA_FLAG_WME,
+    };
+
+    fl.set = fl.mask;
+    put(m, NL80211_STA_INFO_STA_FLAGS, &fl, sizeof(fl));
+  }
+  put_u64(m, NL80211_STA_INFO_RX_DROP_MISC, synth_rand(&rnd) % 1000);
+  if (cfg->parts & SYNTH_SIGNAL) {
+    put_u64(m, NL80211_STA_INFO_BEACON_RX, synth_rand(&rnd) % 1000000);
+    put_u8(m, NL80211_STA_INFO_BEACON_SIGNAL_AVG, (uint8_t)(signal - 2));
+  }
+  if (cfg->parts & SYNTH_TIDS) put_tids(m, cfg->tids, &rnd);
+  if (cfg->parts & SYNTH_SIGNAL) {
+    put_u8(m, NL80211_STA_INFO_ACK_SIGNAL, (uint8_t)(signal + 3));
+    put_u8(m, NL80211_STA_INFO_ACK_SIGNAL_AVG, (uint8_t)(signal + 2));
+  }
+  if (cfg->parts & SYNTH_AIRTIME) {
+    put_u64(m, NL80211_STA_INFO_RX_DURATION, synth_rand(&rnd) % (1ULL << 40));
+    put_u64(m, NL80211_STA_INFO_TX_DURATION, synth_rand(&rnd) % (1ULL << 40));
+    put_u16(m, NL80211_STA_INFO_AIRTIME_WEIGHT, 256);
+  }
+  nest_end(m, info);
+  nlh->nlmsg_len = m->len;
+}
+
+int synth_dump(struct bench_dump *d, const struct synth_cfg *cfg) {
+  struct synth_msg m;
+  uint32_t i;
+  int ret;
+
+  for (i = 0; i < cfg->stations; i++) {
+    synth_station(&m, cfg, i);
+    ret = bench_dump_append(d, (const struct nlmsghdr *)m.buf);
+    if (ret < 0) return ret;
+  }
+  return 0;
+}
+
+static const struct {
+  const char *name;
+  unsigned part;
+} synth_parts[] = {
+    {"signal", SYNTH_SIGNAL}, {"chains", SYNTH_CHAINS},   {"rates", SYNTH_RATES},
+    {"bss", SYNTH_BSS},       {"flags", SYNTH_FLAGS},     {"airtime", SYNTH_AIRTIME},
+    {"mesh", SYNTH_MESH},     {"tids", SYNTH_TIDS},
+};
+
+int synth_mix(struct synth_cfg *cfg, const char *mix) {
+  const char *p = mix;
+  size_t i, len;
+
+  cfg->chains = STATION_MAX_CHAINS;
+  cfg->tids = STATION_MAX_TIDS;
+  if (!strcmp(mix, "min")) {
+    cfg->parts = SYNTH_MIN;
+  } else if (!strcmp(mix, "typical")) {
+    cfg->parts = SYNTH_TYPICAL;
+    cfg->chains = 2;
+  } else if (!strcmp(mix, "full")) {
+    cfg->parts = SYNTH_FULL;
+  } else {
+    for (cfg->parts = 0; *p; p += len + (p[len] == ',')) {
+      len = strcspn(p, ",");
+      for (i = 0; i < sizeof(synth_parts) / sizeof(synth_parts[0]); i++)
+        if (strlen(synth_parts[i].name) == len && !strncmp(p, synth_parts[i].name, len)) break;
+      if (i == sizeof(synth_parts) / sizeof(synth_parts[0])) return -EINVAL;
+      cfg->parts |= synth_parts[i].part;
+    }
+  }
+  return 0;
+}
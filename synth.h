@@ -0,0 +1,48 @@
+//
+// synthetic nl80211 station dumps, for benchmarks at any station count
+//
+
+#ifndef NETLINK_DEMO_SYNTH_H
+#define NETLINK_DEMO_SYNTH_H
+
+#include <stdint.h>
+
+#include "bench.h"
+
+/* synth_cfg.parts, attribute groups put into STA_INFO besides the byte and
+ * packet counters every station has */
+enum synth_part {
+  SYNTH_SIGNAL = 1 << 0,  /* signal, signal avg, ack signal, beacon signal */
+  SYNTH_CHAINS = 1 << 1,  /* CHAIN_SIGNAL and CHAIN_SIGNAL_AVG nests */
+  SYNTH_RATES = 1 << 2,   /* TX_BITRATE and RX_BITRATE nests, HT/VHT/HE/EHT */
+  SYNTH_BSS = 1 << 3,     /* BSS_PARAM nest */
+  SYNTH_FLAGS = 1 << 4,   /* STA_FLAGS, connected time, assoc at boottime */
+  SYNTH_AIRTIME = 1 << 5, /* tx/rx duration, airtime weight, expected throughput */
+  SYNTH_MESH = 1 << 6,    /* mesh peer link attributes */
+  SYNTH_TIDS = 1 << 7,    /* TID_STATS nest with TXQ_STATS per TID */
+};
+
+#define SYNTH_MIN 0
+#define SYNTH_TYPICAL (SYNTH_SIGNAL | SYNTH_CHAINS | SYNTH_RATES | SYNTH_BSS | SYNTH_FLAGS)
+#define SYNTH_FULL (SYNTH_TYPICAL | SYNTH_AIRTIME | SYNTH_MESH | SYNTH_TIDS)
+
+struct synth_cfg {
+  uint32_t stations;
+  uint16_t family_id; /* nlmsg_type of the messages */
+  uint32_t ifindex;
+  unsigned parts;  /* enum synth_part */
+  unsigned chains; /* CHAIN_SIGNAL entries, up to STATION_MAX_CHAINS */
+  unsigned tids;   /* TID_STATS entries, up to STATION_MAX_TIDS */
+};
+
+/* "min", "typical", "full" or a comma separated list of "signal", "chains",
+ * "rates", "bss", "flags", "airtime", "mesh" and "tids". Fills parts,
+ * chains and tids. Returns 0 or -EINVAL. */
+int synth_mix(struct synth_cfg *cfg, const char *mix);
+
+/* Append cfg->stations NL80211_CMD_NEW_STATION messages as the kernel lays
+ * them out. MACs and counters differ per station and are the same on every
+ * run. Returns 0 or -ENOMEM. */
+int synth_dump(struct bench_dump *d, const struct synth_cfg *cfg);
+
+#endif // NETLINK_DEMO_SYNTH_H